@@ -0,0 +1,132 @@
+#!/bin/bash
+# Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+#
+# Common part of bench_*.sh, sourced, not run.
+#
+# A tc_backend_sim process is started with SPIDERS + REMOTES endpoints and
+# registered in the tdbctl under test as SPIDER0.. and SPT0.., the servers
+# are dropped and the simulator stopped when the script exits. Use a tdbctl
+# with no other servers, it is the only one of its cluster.
+#
+# Environment:
+#   TDBCTL_MYSQL  client command of the tdbctl, default
+#                 "mysql -h127.0.0.1 -P26000 -uroot"
+#   SIM           path of tc_backend_sim, default ./tc_backend_sim
+#   SIM_HOST      address the simulator listens on, default 127.0.0.1
+#   SIM_PORT      port of the first endpoint, default 25000
+#   SIM_ARGS      more options of tc_backend_sim, like "--latency-ms=2"
+#   SPIDERS       spider endpoints, default 4
+#   REMOTES       remote endpoints, default 1000
+#
+# Every endpoint is a connection from tdbctl, some benchmarks open more,
+# raise "ulimit -n" and "ulimit -u" of both tdbctl and the simulator.
+
+TDBCTL_MYSQL=${TDBCTL_MYSQL:-"mysql -h127.0.0.1 -P26000 -uroot"}
+SIM=${SIM:-./tc_backend_sim}
+SIM_HOST=${SIM_HOST:-127.0.0.1}
+SIM_PORT=${SIM_PORT:-25000}
+SIM_ARGS=${SIM_ARGS:-}
+SPIDERS=${SPIDERS:-4}
+REMOTES=${REMOTES:-1000}
+SIM_LOG=${SIM_LOG:-/tmp/tc_backend_sim.$$.log}
+SIM_PID=
+
+tc_sql()
+{
+  $TDBCTL_MYSQL -N -B -e "$1"
+}
+
+now_ms()
+{
+  date +%s%3N
+}
+
+# start the simulator with options of the benchmark in $@
+sim_start()
+{
+  local count=$((SPIDERS + REMOTES))
+  if [ "$(ulimit -n)" != "unlimited" ] && [ "$(ulimit -n)" -lt $((count * 2 + 64)) ]; then
+    echo "warning: ulimit -n is $(ulimit -n), $((count * 2 + 64)) or more is needed" >&2
+  fi
+  $SIM --host="$SIM_HOST" --base-port="$SIM_PORT" --count="$count" \
+    --stats-interval=1 $SIM_ARGS "$@" > "$SIM_LOG" 2>&1 &
+  SIM_PID=$!
+  for i in $(seq 1 100); do
+    grep -q "^listening" "$SIM_LOG" && return 0
+    kill -0 $SIM_PID 2>/dev/null || break
+    sleep 0.1
+  done
+  echo "failed to start $SIM:" >&2
+  cat "$SIM_LOG" >&2
+  exit 1
+}
+
+sim_stop()
+{
+  [ -n "$SIM_PID" ] && kill $SIM_PID 2>/dev/null && wait $SIM_PID 2>/dev/null
+  SIM_PID=
+  rm -f "$SIM_LOG"
+}
+
+# counter of the simulator in the last stats line, like "heartbeat"
+sim_stat()
+{
+  tail -n 1 "$SIM_LOG" | tr ' ' '\n' | awk -F= -v name="$1" '$1 == name { print $2 }'
+}
+
+# wait for the next stats line, so that sim_stat is up to date
+sim_stat_sync()
+{
+  local lines=$(grep -c "^stats" "$SIM_LOG")
+  while [ "$(grep -c "^stats" "$SIM_LOG")" -le "$lines" ]; do
+    sleep 0.2
+  done
+}
+
+nodes_register()
+{
+  local sql=""
+  for i in $(seq 0 $((SPIDERS - 1))); do
+    sql="$sql create server SPIDER$i foreign data wrapper SPIDER options(host '$SIM_HOST', port $((SIM_PORT + i)), user 'sim', password 'sim');"
+  done
+  for i in $(seq 0 $((REMOTES - 1))); do
+    sql="$sql create server SPT$i foreign data wrapper mysql options(host '$SIM_HOST', port $((SIM_PORT + SPIDERS + i)), user 'sim', password 'sim');"
+  done
+  tc_sql "$sql" || exit 1
+  tc_sql "tdbctl flush routing" || exit 1
+}
+
+nodes_unregister()
+{
+  local sql=""
+  for i in $(seq 0 $((SPIDERS - 1))); do
+    sql="$sql drop server if exists SPIDER$i;"
+  done
+  for i in $(seq 0 $((REMOTES - 1))); do
+    sql="$sql drop server if exists SPT$i;"
+  done
+  tc_sql "$sql"
+}
+
+bench_cleanup()
+{
+  nodes_unregister
+  sim_stop
+}
+
+# latency of all nodes for an operation of TC_NODE_LATENCY, like "DDL"
+latency_histogram()
+{
+  echo "latency of $1 calls to all nodes (TIME is the upper bound of the bucket):"
+  tc_sql "select TIME, sum(COUNT), sum(TOTAL) from information_schema.TC_NODE_LATENCY
+    where OPERATION = '$1' group by TIME order by TIME" |
+    awk -F'\t' 'BEGIN { printf "%16s %12s %18s\n", "TIME", "COUNT", "TOTAL" }
+      { printf "%16s %12s %18s\n", $1, $2, $3 }'
+}
+
+# avg and max of the numbers on stdin, with a label
+summary()
+{
+  awk -v label="$1" '{ s += $1; if ($1 > m) m = $1; n++ }
+    END { if (n) printf "%-24s runs %4d  avg %8.1f ms  max %8d ms\n", label, n, s / n, m }'
+}
@@ -0,0 +1,51 @@
+#!/bin/bash
+# Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+#
+# Time of DDL fanned out by tdbctl to SPIDERS spiders and REMOTES remotes.
+#
+# ITER times create, alter and drop a table in DB, the time of every DDL
+# seen by the client is summarized, then the node latency histogram of DDL
+# and the slowest node of the jobs from INFORMATION_SCHEMA.TC_DDL_TRACE.
+#
+#   ITER  DDL of each kind, default 10
+#   DB    database, default tc_bench
+# See bench_common.sh for the others, like
+#   REMOTES=2000 SIM_ARGS="--jitter-ms=20 --slow-ports=25100" ./bench_ddl.sh
+
+. "$(dirname "$0")/bench_common.sh"
+
+ITER=${ITER:-10}
+DB=${DB:-tc_bench}
+
+trap bench_cleanup EXIT
+sim_start
+nodes_register
+tc_sql "tdbctl flush latency"
+
+tc_sql "create database if not exists $DB" || exit 1
+for kind in create alter drop; do
+  : > /tmp/tc_bench_ddl.$$.$kind
+done
+for i in $(seq 1 $ITER); do
+  begin=$(now_ms)
+  tc_sql "use $DB; create table t_$i(id int primary key, v int)"
+  echo $(($(now_ms) - begin)) >> /tmp/tc_bench_ddl.$$.create
+  begin=$(now_ms)
+  tc_sql "use $DB; alter table t_$i add column w int"
+  echo $(($(now_ms) - begin)) >> /tmp/tc_bench_ddl.$$.alter
+  begin=$(now_ms)
+  tc_sql "use $DB; drop table t_$i"
+  echo $(($(now_ms) - begin)) >> /tmp/tc_bench_ddl.$$.drop
+done
+tc_sql "drop database if exists $DB"
+
+echo "DDL on $SPIDERS spiders and $REMOTES remotes, simulator options: $SIM_ARGS"
+for kind in create alter drop; do
+  summary "$kind table" < /tmp/tc_bench_ddl.$$.$kind
+  rm -f /tmp/tc_bench_ddl.$$.$kind
+done
+latency_histogram DDL
+echo "last jobs:"
+tc_sql "select JOB_ID, STATE, DURATION, NODES, FAILED_NODES, SLOWEST_NODE,
+  SLOWEST_TIME from information_schema.TC_DDL_TRACE
+  order by JOB_ID desc limit $((ITER * 3))"
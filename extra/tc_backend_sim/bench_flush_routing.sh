@@ -0,0 +1,34 @@
+#!/bin/bash
+# Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+#
+# Time of TDBCTL FLUSH ROUTING with SPIDERS spiders and REMOTES remotes,
+# every flush writes all the REMOTES servers to mysql.servers of every
+# spider.
+#
+#   ITER  flushes, default 10
+# See bench_common.sh for the others.
+
+. "$(dirname "$0")/bench_common.sh"
+
+ITER=${ITER:-10}
+
+trap bench_cleanup EXIT
+sim_start
+nodes_register
+tc_sql "tdbctl flush latency"
+
+sim_stat_sync
+routing_begin=$(sim_stat routing)
+for i in $(seq 1 $ITER); do
+  begin=$(now_ms)
+  tc_sql "tdbctl flush routing" || exit 1
+  echo $(($(now_ms) - begin))
+done > /tmp/tc_bench_flush.$$
+sim_stat_sync
+routing_end=$(sim_stat routing)
+
+echo "routing of $REMOTES remotes on $SPIDERS spiders, simulator options: $SIM_ARGS"
+summary "tdbctl flush routing" < /tmp/tc_bench_flush.$$
+rm -f /tmp/tc_bench_flush.$$
+echo "mysql.servers statements on spiders: $((routing_end - routing_begin))"
+latency_histogram FLUSH
@@ -0,0 +1,54 @@
+#!/bin/bash
+# Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+#
+# Probe cycles of tc_check_availability on SPIDERS spiders.
+#
+# The monitor runs for DURATION seconds with tc_check_availability_interval
+# of INTERVAL, the heartbeat updates received by the simulator give the
+# mean time between probes of a spider. Slow or hung spiders can be set by
+# SIM_ARGS, like SIM_ARGS="--hang-ports=25000-25009" to see how they
+# delay the probes of the others.
+#
+#   DURATION  seconds, default 60
+#   INTERVAL  tc_check_availability_interval, default 3
+# See bench_common.sh for the others, SPIDERS defaults to 1000 and
+# REMOTES to 1 here.
+
+REMOTES=${REMOTES:-1}
+SPIDERS=${SPIDERS:-1000}
+. "$(dirname "$0")/bench_common.sh"
+
+DURATION=${DURATION:-60}
+INTERVAL=${INTERVAL:-3}
+
+old_check=$(tc_sql "select @@global.tc_check_availability")
+old_interval=$(tc_sql "select @@global.tc_check_availability_interval")
+monitor_cleanup()
+{
+  tc_sql "set global tc_check_availability = $old_check;
+    set global tc_check_availability_interval = $old_interval"
+  bench_cleanup
+}
+
+trap monitor_cleanup EXIT
+sim_start
+nodes_register
+tc_sql "tdbctl flush latency"
+
+tc_sql "set global tc_check_availability_interval = $INTERVAL;
+  set global tc_check_availability = 1" || exit 1
+sim_stat_sync
+heartbeat_begin=$(sim_stat heartbeat)
+begin=$(now_ms)
+sleep $DURATION
+sim_stat_sync
+heartbeat_end=$(sim_stat heartbeat)
+elapsed=$(($(now_ms) - begin))
+
+probes=$((heartbeat_end - heartbeat_begin))
+echo "monitor of $SPIDERS spiders for $elapsed ms, interval $INTERVAL s, simulator options: $SIM_ARGS"
+echo "heartbeats: $probes"
+if [ $probes -gt 0 ]; then
+  echo "mean time between probes of a spider: $((elapsed * SPIDERS / probes)) ms"
+fi
+latency_histogram PROBE
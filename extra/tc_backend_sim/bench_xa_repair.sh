@@ -0,0 +1,51 @@
+#!/bin/bash
+# Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+#
+# Time for tc_check_repair_trans to repair the prepared XA transactions of
+# REMOTES remotes.
+#
+# Every remote starts with XA_PREPARED prepared transactions, none is in
+# mysql.xa_commit_log, so all are rolled back. Rounds of the repair thread
+# are tc_max_prepared_time apart, it is set to the minimum 8 seconds,
+# both variables are restored at the end.
+#
+#   XA_PREPARED  prepared transactions of every remote, default 100
+#   TIMEOUT      seconds to wait for the repair, default 600
+# See bench_common.sh for the others.
+
+. "$(dirname "$0")/bench_common.sh"
+
+XA_PREPARED=${XA_PREPARED:-100}
+TIMEOUT=${TIMEOUT:-600}
+
+old_repair=$(tc_sql "select @@global.tc_check_repair_trans")
+old_max_time=$(tc_sql "select @@global.tc_max_prepared_time")
+xa_cleanup()
+{
+  tc_sql "set global tc_check_repair_trans = $old_repair;
+    set global tc_max_prepared_time = $old_max_time"
+  bench_cleanup
+}
+
+trap xa_cleanup EXIT
+sim_start --xa-prepared=$XA_PREPARED
+nodes_register
+tc_sql "tdbctl flush latency"
+
+total=$((XA_PREPARED * REMOTES))
+begin=$(now_ms)
+tc_sql "set global tc_max_prepared_time = 8; set global tc_check_repair_trans = 1" || exit 1
+while :; do
+  sim_stat_sync
+  repaired=$(sim_stat xa_end)
+  [ "$repaired" -ge "$total" ] && break
+  if [ $(($(now_ms) - begin)) -gt $((TIMEOUT * 1000)) ]; then
+    echo "timeout, $repaired of $total repaired"
+    break
+  fi
+done
+elapsed=$(($(now_ms) - begin))
+
+echo "$XA_PREPARED prepared transactions on $REMOTES remotes, simulator options: $SIM_ARGS"
+echo "repaired $repaired of $total in $elapsed ms, xa recover rounds: $(( $(sim_stat xa_recover) / REMOTES ))"
+latency_histogram XA
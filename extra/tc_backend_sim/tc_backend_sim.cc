@@ -0,0 +1,1108 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+/*
+  tc_backend_sim: stand-in spider/remote nodes for benchmarking tdbctl
+
+  Listens on --count ports from --base-port, every port is one endpoint
+  which speaks enough of the client/server protocol for the statements
+  tdbctl sends to its nodes, so a cluster of thousands of nodes is one
+  process instead of thousands of mysqld. Packets are read and written by
+  NET over vio, the same code mysqld uses.
+
+  Every endpoint accepts any user and password and keeps:
+    rows of mysql.servers, written by "replace into mysql.servers" and
+    "delete from mysql.servers", read by "select ... from mysql.servers",
+    so routing flush and routing repair see what they have written;
+    prepared XA transactions, --xa-prepared of them at start, returned
+    by "xa recover [with time [older than n]]" and removed by
+    "xa commit"/"xa rollback".
+  Every other statement (DDL, heartbeat update, set, flush ...) is
+  answered with OK, other SELECT/SHOW with an empty result.
+
+  Latency and faults are injected per COM_QUERY:
+    --latency-ms/--jitter-ms    delay before the reply
+    --slow-ports/--slow-ms      extra delay on some endpoints
+    --hang-ports                never reply, like a node stuck in IO
+    --down-ports                not listened, connect is refused
+    --error-permille            reply --error-code instead of OK
+    --drop-permille             close the connection instead of reply
+  Port lists are ranges like "25000-25009,25100".
+
+  With --stats-interval, counters of all endpoints are printed every
+  interval seconds to stdout, the bench_*.sh scripts read them.
+
+  One thread per connection, raise "ulimit -n" and the max user processes
+  for thousands of endpoints.
+*/
+
+#include <my_global.h>
+#include <my_sys.h>
+#include <my_getopt.h>
+#include <m_string.h>
+#include <m_ctype.h>
+#include <mysql_version.h>
+#include <mysql_com.h>
+#include <mysqld_error.h>
+#include <violite.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <system_error>
+using namespace std;
+
+#define SIM_VERSION "1.0"
+#define SIM_SERVER_VERSION "5.7.20-tc-backend-sim"
+/* utf8_general_ci */
+#define SIM_CHARSET 33
+#define SIM_SERVERS_COLUMNS 9
+
+static char *opt_host = NULL;
+static uint opt_base_port = 25000;
+static uint opt_count = 1000;
+static uint opt_latency_ms = 0;
+static uint opt_jitter_ms = 0;
+static char *opt_slow_ports = NULL;
+static uint opt_slow_ms = 1000;
+static char *opt_hang_ports = NULL;
+static char *opt_down_ports = NULL;
+static uint opt_error_permille = 0;
+static uint opt_error_code = ER_LOCK_WAIT_TIMEOUT;
+static uint opt_drop_permille = 0;
+static uint opt_xa_prepared = 0;
+static uint opt_xa_prepared_age = 3600;
+static uint opt_stats_interval = 0;
+
+static struct my_option my_long_options[] =
+{
+  {"help", '?', "Display this help and exit.",
+   0, 0, 0, GET_NO_ARG, NO_ARG, 0, 0, 0, 0, 0, 0},
+  {"host", 'h', "Address to listen on.", &opt_host, &opt_host,
+   0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"base-port", 'P', "Port of the first endpoint.",
+   &opt_base_port, &opt_base_port, 0, GET_UINT, REQUIRED_ARG,
+   25000, 1, 65535, 0, 0, 0},
+  {"count", 'n', "Number of endpoints, on consecutive ports.",
+   &opt_count, &opt_count, 0, GET_UINT, REQUIRED_ARG,
+   1000, 1, 65535, 0, 0, 0},
+  {"latency-ms", 0, "Delay of every reply, in milliseconds.",
+   &opt_latency_ms, &opt_latency_ms, 0, GET_UINT, REQUIRED_ARG,
+   0, 0, 3600000, 0, 0, 0},
+  {"jitter-ms", 0, "Random extra delay of every reply, up to this "
+   "many milliseconds.", &opt_jitter_ms, &opt_jitter_ms, 0, GET_UINT,
+   REQUIRED_ARG, 0, 0, 3600000, 0, 0, 0},
+  {"slow-ports", 0, "Ports which add --slow-ms to every reply.",
+   &opt_slow_ports, &opt_slow_ports, 0, GET_STR, REQUIRED_ARG,
+   0, 0, 0, 0, 0, 0},
+  {"slow-ms", 0, "Extra delay of --slow-ports, in milliseconds.",
+   &opt_slow_ms, &opt_slow_ms, 0, GET_UINT, REQUIRED_ARG,
+   1000, 0, 3600000, 0, 0, 0},
+  {"hang-ports", 0, "Ports which accept connections but never reply "
+   "to a query.", &opt_hang_ports, &opt_hang_ports, 0, GET_STR,
+   REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"down-ports", 0, "Ports which are not listened.",
+   &opt_down_ports, &opt_down_ports, 0, GET_STR, REQUIRED_ARG,
+   0, 0, 0, 0, 0, 0},
+  {"error-permille", 0, "Replies per thousand which are --error-code.",
+   &opt_error_permille, &opt_error_permille, 0, GET_UINT, REQUIRED_ARG,
+   0, 0, 1000, 0, 0, 0},
+  {"error-code", 0, "Error of --error-permille.",
+   &opt_error_code, &opt_error_code, 0, GET_UINT, REQUIRED_ARG,
+   ER_LOCK_WAIT_TIMEOUT, 1, 65535, 0, 0, 0},
+  {"drop-permille", 0, "Replies per thousand for which the connection "
+   "is closed instead.", &opt_drop_permille, &opt_drop_permille, 0,
+   GET_UINT, REQUIRED_ARG, 0, 0, 1000, 0, 0, 0},
+  {"xa-prepared", 0, "Prepared XA transactions of every endpoint at "
+   "start.", &opt_xa_prepared, &opt_xa_prepared, 0, GET_UINT,
+   REQUIRED_ARG, 0, 0, 1000000, 0, 0, 0},
+  {"xa-prepared-age", 0, "Seconds the --xa-prepared transactions have "
+   "been prepared at start.", &opt_xa_prepared_age, &opt_xa_prepared_age,
+   0, GET_UINT, REQUIRED_ARG, 3600, 0, 86400 * 365, 0, 0, 0},
+  {"stats-interval", 's', "Print counters every this many seconds, "
+   "0 for never.", &opt_stats_interval, &opt_stats_interval, 0, GET_UINT,
+   REQUIRED_ARG, 0, 0, 86400, 0, 0, 0},
+  {"version", 'V', "Output version information and exit.",
+   0, 0, 0, GET_NO_ARG, NO_ARG, 0, 0, 0, 0, 0, 0},
+  {0, 0, 0, 0, 0, 0, GET_NO_ARG, NO_ARG, 0, 0, 0, 0, 0, 0}
+};
+
+typedef struct sim_endpoint
+{
+  uint port;
+  my_socket fd;
+  bool slow;
+  bool hang;
+  std::mutex mtx;
+  /* Server_name-->row of mysql.servers */
+  map<string, vector<string> > server_map;
+  /* xid-->prepare time */
+  map<string, time_t> xa_map;
+} SIM_ENDPOINT;
+
+/* statements by kind, for --stats-interval */
+enum sim_stat
+{
+  SIM_STAT_CONNECT = 0,
+  SIM_STAT_QUERY,
+  SIM_STAT_DDL,
+  SIM_STAT_HEARTBEAT,
+  SIM_STAT_ROUTING,
+  SIM_STAT_XA_RECOVER,
+  SIM_STAT_XA_END,
+  SIM_STAT_ERROR,
+  SIM_STAT_DROP,
+  SIM_STAT_COUNT
+};
+
+static const char *sim_stat_names[] =
+{
+  "connect", "query", "ddl", "heartbeat", "routing", "xa_recover",
+  "xa_end", "error", "drop"
+};
+
+static std::atomic<ulonglong> sim_stats[SIM_STAT_COUNT];
+static std::atomic<ulong> sim_thread_id(0);
+static vector<SIM_ENDPOINT*> sim_endpoints;
+
+/* result of one statement */
+typedef struct sim_result
+{
+  /* no result set if columns is empty */
+  vector<string> columns;
+  /* NULL is a value of "\0N" */
+  vector<vector<string> > rows;
+  ulonglong affected_rows;
+  uint err_code;
+  const char *sqlstate;
+  string err_msg;
+} SIM_RESULT;
+
+static const string sim_null("\0N", 2);
+
+static void print_version(void)
+{
+  printf("%s Ver %s, for %s (%s)\n", my_progname, SIM_VERSION,
+    SYSTEM_TYPE, MACHINE_TYPE);
+}
+
+static void usage(void)
+{
+  print_version();
+  puts("Stand-in spider/remote nodes for benchmarking tdbctl, test only.\n");
+  printf("Usage: %s [OPTIONS]\n", my_progname);
+  my_print_help(my_long_options);
+  my_print_variables(my_long_options);
+}
+
+static my_bool
+get_one_option(int optid, const struct my_option *opt MY_ATTRIBUTE((unused)),
+  char *argument MY_ATTRIBUTE((unused)))
+{
+  switch (optid) {
+  case 'V':
+    print_version();
+    exit(0);
+  case '?':
+    usage();
+    exit(0);
+  }
+  return 0;
+}
+
+/*
+  whether port is in list like "25000-25009,25100"
+
+  @retval
+    -1 list is wrong
+*/
+static int sim_port_in_list(const char *list, uint port)
+{
+  if (!list)
+    return 0;
+  const char *pos = list;
+  while (*pos)
+  {
+    char *end;
+    ulong first = strtoul(pos, &end, 10);
+    ulong last = first;
+    if (end == pos)
+      return -1;
+    pos = end;
+    if (*pos == '-')
+    {
+      last = strtoul(++pos, &end, 10);
+      if (end == pos)
+        return -1;
+      pos = end;
+    }
+    if (*pos == ',')
+      pos++;
+    else if (*pos)
+      return -1;
+    if (port >= first && port <= last)
+      return 1;
+  }
+  return 0;
+}
+
+static ulonglong sim_now_ms()
+{
+  return (ulonglong)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void sim_sleep_ms(ulonglong ms)
+{
+  if (ms)
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static string sim_server_uuid(uint port)
+{
+  char buf[64];
+  snprintf(buf, sizeof(buf), "5e5e5e5e-0000-0000-0000-%012u", port);
+  return buf;
+}
+
+/* write packets of NET */
+
+static void sim_store_length(string &packet, ulonglong length)
+{
+  uchar buf[9];
+  uchar *end = net_store_length(buf, length);
+  packet.append((char *)buf, end - buf);
+}
+
+static void sim_store_string(string &packet, const string &str)
+{
+  if (str == sim_null)
+  {
+    packet += (char)251;
+    return;
+  }
+  sim_store_length(packet, str.length());
+  packet += str;
+}
+
+static void sim_store_int2(string &packet, uint value)
+{
+  packet += (char)(value & 0xff);
+  packet += (char)((value >> 8) & 0xff);
+}
+
+static void sim_store_int4(string &packet, ulong value)
+{
+  sim_store_int2(packet, value & 0xffff);
+  sim_store_int2(packet, (value >> 16) & 0xffff);
+}
+
+static bool sim_write(NET *net, const string &packet)
+{
+  return my_net_write(net, (const uchar *)packet.data(), packet.length());
+}
+
+static bool sim_write_ok(NET *net, ulonglong affected_rows, uint status)
+{
+  string packet(1, '\0');
+  sim_store_length(packet, affected_rows);
+  sim_store_length(packet, 0);
+  sim_store_int2(packet, status);
+  sim_store_int2(packet, 0);
+  return sim_write(net, packet);
+}
+
+static bool sim_write_eof(NET *net, uint status)
+{
+  string packet(1, (char)254);
+  sim_store_int2(packet, 0);
+  sim_store_int2(packet, status);
+  return sim_write(net, packet);
+}
+
+static bool sim_write_error(NET *net, uint err_code, const char *sqlstate,
+  const string &err_msg)
+{
+  string packet(1, (char)255);
+  sim_store_int2(packet, err_code);
+  packet += '#';
+  packet.append(sqlstate, SQLSTATE_LENGTH);
+  packet += err_msg;
+  return sim_write(net, packet);
+}
+
+static bool sim_write_result(NET *net, const SIM_RESULT &result, uint status)
+{
+  string packet;
+  if (result.err_code)
+    return sim_write_error(net, result.err_code, result.sqlstate,
+      result.err_msg);
+  if (result.columns.empty())
+    return sim_write_ok(net, result.affected_rows, status);
+
+  sim_store_length(packet, result.columns.size());
+  if (sim_write(net, packet))
+    return TRUE;
+  for (auto &column : result.columns)
+  {
+    packet.clear();
+    sim_store_string(packet, "def");
+    sim_store_string(packet, "");
+    sim_store_string(packet, "");
+    sim_store_string(packet, "");
+    sim_store_string(packet, column);
+    sim_store_string(packet, column);
+    packet += (char)0x0c;
+    sim_store_int2(packet, SIM_CHARSET);
+    sim_store_int4(packet, 255 * 3);
+    packet += (char)MYSQL_TYPE_VAR_STRING;
+    sim_store_int2(packet, 0);
+    packet += (char)0;
+    sim_store_int2(packet, 0);
+    if (sim_write(net, packet))
+      return TRUE;
+  }
+  if (sim_write_eof(net, status & ~SERVER_MORE_RESULTS_EXISTS))
+    return TRUE;
+  for (auto &row : result.rows)
+  {
+    packet.clear();
+    for (auto &value : row)
+      sim_store_string(packet, value);
+    if (sim_write(net, packet))
+      return TRUE;
+  }
+  return sim_write_eof(net, status);
+}
+
+/* parse statements */
+
+/*
+  split query of COM_QUERY into statements on ';' out of quotes,
+  empty statements are skipped
+*/
+static vector<string> sim_split_query(const char *query, size_t length)
+{
+  vector<string> stmt_list;
+  string stmt;
+  char quote = 0;
+  for (size_t i = 0; i < length; i++)
+  {
+    char c = query[i];
+    if (quote)
+    {
+      stmt += c;
+      if (c == '\\' && quote != '`' && i + 1 < length)
+        stmt += query[++i];
+      else if (c == quote)
+        quote = 0;
+      continue;
+    }
+    if (c == '\'' || c == '"' || c == '`')
+      quote = c;
+    if (c != ';')
+    {
+      stmt += c;
+      continue;
+    }
+    if (stmt.find_first_not_of(" \t\r\n") != string::npos)
+      stmt_list.push_back(stmt);
+    stmt.clear();
+  }
+  if (stmt.find_first_not_of(" \t\r\n") != string::npos)
+    stmt_list.push_back(stmt);
+  return stmt_list;
+}
+
+/* lower case of stmt with runs of space as one space, for matching */
+static string sim_stmt_key(const string &stmt)
+{
+  string key;
+  bool space = true;
+  for (unsigned char c : stmt)
+  {
+    if (isspace(c))
+    {
+      if (!space)
+        key += ' ';
+      space = true;
+      continue;
+    }
+    key += (char)tolower(c);
+    space = false;
+  }
+  if (!key.empty() && key[key.length() - 1] == ' ')
+    key.erase(key.length() - 1);
+  return key;
+}
+
+static bool sim_prefix(const string &key, const char *prefix)
+{
+  return !key.compare(0, strlen(prefix), prefix);
+}
+
+static size_t sim_skip_space(const string &stmt, size_t pos)
+{
+  while (pos < stmt.length() && isspace((unsigned char)stmt[pos]))
+    pos++;
+  return pos;
+}
+
+/*
+  parse a quoted string or a bare word from pos, NULL is sim_null
+
+  @retval
+    FALSE ok, pos is after the value
+*/
+static bool sim_parse_value(const string &stmt, size_t &pos, string &value)
+{
+  value.clear();
+  pos = sim_skip_space(stmt, pos);
+  if (pos >= stmt.length())
+    return TRUE;
+  char quote = stmt[pos];
+  if (quote == '\'' || quote == '"')
+  {
+    for (pos++; pos < stmt.length(); pos++)
+    {
+      char c = stmt[pos];
+      if (c == '\\' && pos + 1 < stmt.length())
+        value += stmt[++pos];
+      else if (c == quote && pos + 1 < stmt.length() && stmt[pos + 1] == quote)
+        value += stmt[++pos];
+      else if (c == quote)
+      {
+        pos++;
+        return FALSE;
+      }
+      else
+        value += c;
+    }
+    return TRUE;
+  }
+  while (pos < stmt.length() && !isspace((unsigned char)stmt[pos]) &&
+    stmt[pos] != ',' && stmt[pos] != ')' && stmt[pos] != '(')
+    value += stmt[pos++];
+  if (value.empty())
+    return TRUE;
+  if (!my_strcasecmp(&my_charset_latin1, value.c_str(), "null"))
+    value = sim_null;
+  return FALSE;
+}
+
+/* quoted values of stmt from pos */
+static vector<string> sim_quoted_values(const string &stmt, size_t pos)
+{
+  vector<string> value_list;
+  while ((pos = stmt.find_first_of("'\"", pos)) != string::npos)
+  {
+    string value;
+    if (sim_parse_value(stmt, pos, value))
+      break;
+    value_list.push_back(value);
+  }
+  return value_list;
+}
+
+/* position of word in stmt, ignoring case */
+static size_t sim_find(const string &stmt, const char *word, size_t pos = 0)
+{
+  string lower(stmt);
+  for (auto &c : lower)
+    c = (char)tolower((unsigned char)c);
+  return lower.find(word, pos);
+}
+
+/* execute statements */
+
+static void sim_set_error(SIM_RESULT &result, uint err_code,
+  const char *sqlstate, const string &err_msg)
+{
+  result.err_code = err_code;
+  result.sqlstate = sqlstate;
+  result.err_msg = err_msg;
+}
+
+/* replace into mysql.servers(<9 columns>) values(...),(...) */
+static void sim_replace_servers(SIM_ENDPOINT *ep, const string &stmt,
+  SIM_RESULT &result)
+{
+  size_t pos = sim_find(stmt, "values");
+  vector<vector<string> > row_list;
+  if (pos == string::npos)
+  {
+    sim_set_error(result, ER_PARSE_ERROR, "42000", "You have an error in "
+      "your SQL syntax, VALUES expected");
+    return;
+  }
+  pos += strlen("values");
+  while ((pos = sim_skip_space(stmt, pos)) < stmt.length() && stmt[pos] == '(')
+  {
+    vector<string> row;
+    string value;
+    pos++;
+    while (!sim_parse_value(stmt, pos, value))
+    {
+      row.push_back(value);
+      pos = sim_skip_space(stmt, pos);
+      if (pos < stmt.length() && stmt[pos] == ',')
+        pos++;
+      else
+        break;
+    }
+    if (pos >= stmt.length() || stmt[pos] != ')' ||
+      row.size() != SIM_SERVERS_COLUMNS)
+    {
+      sim_set_error(result, ER_WRONG_VALUE_COUNT_ON_ROW, "21S01",
+        "Column count doesn't match value count at row " +
+        to_string(row_list.size() + 1));
+      return;
+    }
+    row_list.push_back(row);
+    pos = sim_skip_space(stmt, pos + 1);
+    if (pos < stmt.length() && stmt[pos] == ',')
+      pos++;
+  }
+
+  std::lock_guard<std::mutex> lock(ep->mtx);
+  for (auto &row : row_list)
+  {
+    /* replace counts the deleted row too */
+    result.affected_rows += ep->server_map.count(row[0]) ? 2 : 1;
+    ep->server_map[row[0]] = row;
+  }
+}
+
+/*
+  delete from mysql.servers where Wrapper='x'
+  delete from mysql.servers where Server_name="x"
+  delete from mysql.servers where Server_name in("x" "y")
+*/
+static void sim_delete_servers(SIM_ENDPOINT *ep, const string &stmt,
+  SIM_RESULT &result)
+{
+  size_t pos = sim_find(stmt, "where");
+  if (pos == string::npos)
+  {
+    std::lock_guard<std::mutex> lock(ep->mtx);
+    result.affected_rows = ep->server_map.size();
+    ep->server_map.clear();
+    return;
+  }
+  bool by_wrapper = sim_find(stmt, "wrapper", pos) != string::npos;
+  vector<string> value_list = sim_quoted_values(stmt, pos);
+
+  std::lock_guard<std::mutex> lock(ep->mtx);
+  for (auto &value : value_list)
+  {
+    if (!by_wrapper)
+    {
+      result.affected_rows += ep->server_map.erase(value);
+      continue;
+    }
+    for (auto its = ep->server_map.begin(); its != ep->server_map.end();)
+    {
+      if (!my_strcasecmp(&my_charset_latin1, its->second[7].c_str(),
+        value.c_str()))
+      {
+        its = ep->server_map.erase(its);
+        result.affected_rows++;
+      }
+      else
+        its++;
+    }
+  }
+}
+
+/* select * or the 9 columns from mysql.servers [where Wrapper = "x"] */
+static void sim_select_servers(SIM_ENDPOINT *ep, const string &stmt,
+  SIM_RESULT &result)
+{
+  size_t pos = sim_find(stmt, "where");
+  vector<string> value_list;
+  if (pos != string::npos)
+    value_list = sim_quoted_values(stmt, pos);
+  result.columns = {"Server_name", "Host", "Db", "Username", "Password",
+    "Port", "Socket", "Wrapper", "Owner"};
+
+  std::lock_guard<std::mutex> lock(ep->mtx);
+  for (auto &server : ep->server_map)
+  {
+    if (value_list.size() && my_strcasecmp(&my_charset_latin1,
+      server.second[7].c_str(), value_list[0].c_str()))
+      continue;
+    result.rows.push_back(server.second);
+  }
+}
+
+/* xa recover [with time [older than n]] */
+static void sim_xa_recover(SIM_ENDPOINT *ep, const string &key,
+  SIM_RESULT &result)
+{
+  bool with_time = sim_prefix(key, "xa recover with time");
+  ulong older_than = 0;
+  size_t pos = key.find(" older than ");
+  time_t now = time(NULL);
+  if (pos != string::npos)
+    older_than = strtoul(key.c_str() + pos + strlen(" older than "), NULL, 10);
+
+  result.columns = {"formatID", "gtrid_length", "bqual_length", "data"};
+  if (with_time)
+    result.columns.push_back("prepare_time");
+
+  std::lock_guard<std::mutex> lock(ep->mtx);
+  for (auto &xa : ep->xa_map)
+  {
+    if (now - xa.second <= (time_t)older_than)
+      continue;
+    vector<string> row = {"1", to_string(xa.first.length()), "0", xa.first};
+    if (with_time)
+    {
+      char buf[32];
+      struct tm tm_time;
+      localtime_r(&xa.second, &tm_time);
+      strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm_time);
+      row.push_back(buf);
+    }
+    result.rows.push_back(row);
+  }
+}
+
+/* xa commit "xid" / xa rollback "xid" */
+static void sim_xa_end(SIM_ENDPOINT *ep, const string &stmt,
+  SIM_RESULT &result)
+{
+  vector<string> value_list = sim_quoted_values(stmt, 0);
+  std::lock_guard<std::mutex> lock(ep->mtx);
+  if (value_list.empty() || !ep->xa_map.erase(value_list[0]))
+    sim_set_error(result, ER_XAER_NOTA, "XAE04", "XAER_NOTA: Unknown XID");
+}
+
+/* select @@var, the value is never NULL */
+static void sim_select_variable(SIM_ENDPOINT *ep, const string &key,
+  SIM_RESULT &result)
+{
+  string name = key.substr(strlen("select @@"));
+  string value = "0";
+  name = name.substr(0, name.find_first_of(" ,;"));
+  if (!name.compare(0, 7, "global."))
+    name = name.substr(7);
+  else if (!name.compare(0, 8, "session."))
+    name = name.substr(8);
+
+  if (name == "version")
+    value = SIM_SERVER_VERSION;
+  else if (name == "server_uuid")
+    value = sim_server_uuid(ep->port);
+  else if (name == "port" || name == "server_id")
+    value = to_string(ep->port);
+  else if (name.find("character_set") == 0)
+    value = "utf8";
+  else if (name.find("collation") == 0)
+    value = "utf8_general_ci";
+  result.columns.push_back("@@" + name);
+  result.rows.push_back(vector<string>(1, value));
+}
+
+static enum sim_stat sim_execute(SIM_ENDPOINT *ep, const string &stmt,
+  SIM_RESULT &result)
+{
+  string key = sim_stmt_key(stmt);
+  result.affected_rows = 0;
+  result.err_code = 0;
+
+  if (sim_prefix(key, "xa recover"))
+  {
+    sim_xa_recover(ep, key, result);
+    return SIM_STAT_XA_RECOVER;
+  }
+  if (sim_prefix(key, "xa commit") || sim_prefix(key, "xa rollback"))
+  {
+    sim_xa_end(ep, stmt, result);
+    return SIM_STAT_XA_END;
+  }
+  if (sim_prefix(key, "replace into mysql.servers"))
+  {
+    sim_replace_servers(ep, stmt, result);
+    return SIM_STAT_ROUTING;
+  }
+  if (sim_prefix(key, "delete from mysql.servers"))
+  {
+    sim_delete_servers(ep, stmt, result);
+    return SIM_STAT_ROUTING;
+  }
+  if (sim_prefix(key, "update cluster_admin.cluster_heartbeat "))
+  {
+    result.affected_rows = 1;
+    return SIM_STAT_HEARTBEAT;
+  }
+  if (sim_prefix(key, "select") && key.find(" from mysql.servers") !=
+    string::npos)
+  {
+    sim_select_servers(ep, stmt, result);
+    return SIM_STAT_QUERY;
+  }
+  if (sim_prefix(key, "select @@"))
+  {
+    sim_select_variable(ep, key, result);
+    return SIM_STAT_QUERY;
+  }
+  if (sim_prefix(key, "show variables") || sim_prefix(key, "show global variables"))
+  {
+    result.columns = {"Variable_name", "Value"};
+    if (key.find("'server_uuid'") != string::npos)
+      result.rows.push_back({"server_uuid", sim_server_uuid(ep->port)});
+    return SIM_STAT_QUERY;
+  }
+  if (sim_prefix(key, "select count(") || sim_prefix(key, "select max(") ||
+    sim_prefix(key, "select min("))
+  {
+    result.columns.push_back(key.substr(strlen("select "),
+      key.find(')') + 1 - strlen("select ")));
+    result.rows.push_back(vector<string>(1, key[7] == 'c' ? "0" : sim_null));
+    return SIM_STAT_QUERY;
+  }
+  if (sim_prefix(key, "select") || sim_prefix(key, "show") ||
+    sim_prefix(key, "desc") || sim_prefix(key, "explain") ||
+    sim_prefix(key, "checksum"))
+  {
+    /* no table has rows */
+    result.columns.push_back("Value");
+    return SIM_STAT_QUERY;
+  }
+  if (sim_prefix(key, "create") || sim_prefix(key, "alter") ||
+    sim_prefix(key, "drop") || sim_prefix(key, "rename") ||
+    sim_prefix(key, "truncate"))
+    return SIM_STAT_DDL;
+  return SIM_STAT_QUERY;
+}
+
+/* handle connection */
+
+static bool sim_handshake(NET *net, ulong thread_id)
+{
+  string packet(1, (char)PROTOCOL_VERSION);
+  ulong capabilities = CLIENT_LONG_PASSWORD | CLIENT_FOUND_ROWS |
+    CLIENT_LONG_FLAG | CLIENT_CONNECT_WITH_DB | CLIENT_PROTOCOL_41 |
+    CLIENT_INTERACTIVE | CLIENT_TRANSACTIONS | CLIENT_RESERVED2 |
+    CLIENT_MULTI_STATEMENTS | CLIENT_MULTI_RESULTS | CLIENT_PS_MULTI_RESULTS |
+    CLIENT_PLUGIN_AUTH | CLIENT_CONNECT_ATTRS |
+    CLIENT_PLUGIN_AUTH_LENENC_CLIENT_DATA;
+  /* any password is accepted, the scramble is not checked */
+  const char *scramble = "tcbackendsim12345678";
+
+  packet += SIM_SERVER_VERSION;
+  packet += '\0';
+  sim_store_int4(packet, thread_id);
+  packet.append(scramble, 8);
+  packet += '\0';
+  sim_store_int2(packet, capabilities & 0xffff);
+  packet += (char)SIM_CHARSET;
+  sim_store_int2(packet, SERVER_STATUS_AUTOCOMMIT);
+  sim_store_int2(packet, capabilities >> 16);
+  packet += (char)(SCRAMBLE_LENGTH + 1);
+  packet.append(10, '\0');
+  packet.append(scramble + 8, SCRAMBLE_LENGTH - 8);
+  packet += '\0';
+  packet += "mysql_native_password";
+  packet += '\0';
+  if (sim_write(net, packet) || net_flush(net))
+    return TRUE;
+
+  /* handshake response of client */
+  if (my_net_read(net) == packet_error)
+    return TRUE;
+  return sim_write_ok(net, 0, SERVER_STATUS_AUTOCOMMIT) || net_flush(net);
+}
+
+/* wait until client closes a connection of --hang-ports */
+static void sim_hang(Vio *vio)
+{
+  while (vio_io_wait(vio, VIO_IO_EVENT_READ, 1000) == 0)
+    ;
+}
+
+static void sim_handle_query(SIM_ENDPOINT *ep, NET *net, const char *query,
+  size_t length, std::mt19937 &rnd)
+{
+  vector<string> stmt_list = sim_split_query(query, length);
+  ulonglong delay = opt_latency_ms + (ep->slow ? opt_slow_ms : 0);
+  std::uniform_int_distribution<uint> permille(0, 999);
+
+  if (opt_jitter_ms)
+    delay += std::uniform_int_distribution<uint>(0, opt_jitter_ms)(rnd);
+  sim_sleep_ms(delay);
+
+  if (opt_drop_permille && permille(rnd) < opt_drop_permille)
+  {
+    sim_stats[SIM_STAT_DROP]++;
+    vio_shutdown(net->vio, SHUT_RDWR);
+    return;
+  }
+  if (opt_error_permille && permille(rnd) < opt_error_permille)
+  {
+    sim_stats[SIM_STAT_ERROR]++;
+    sim_write_error(net, opt_error_code, "HY000",
+      "Error injected by tc_backend_sim");
+    return;
+  }
+  if (stmt_list.empty())
+  {
+    sim_write_error(net, ER_EMPTY_QUERY, "42000", "Query was empty");
+    return;
+  }
+
+  for (size_t i = 0; i < stmt_list.size(); i++)
+  {
+    SIM_RESULT result;
+    uint status = SERVER_STATUS_AUTOCOMMIT;
+    if (i + 1 < stmt_list.size())
+      status |= SERVER_MORE_RESULTS_EXISTS;
+    sim_stats[sim_execute(ep, stmt_list[i], result)]++;
+    /* like mysqld, statements after an error are not executed */
+    if (sim_write_result(net, result, status) || result.err_code)
+      return;
+  }
+}
+
+static void sim_handle_connection(SIM_ENDPOINT *ep, my_socket fd)
+{
+  NET net;
+  Vio *vio;
+  ulong thread_id = ++sim_thread_id;
+  std::mt19937 rnd((uint)(thread_id * 2654435761UL));
+
+  my_thread_init();
+  sim_stats[SIM_STAT_CONNECT]++;
+  if (!(vio = vio_new(fd, VIO_TYPE_TCPIP, 0)))
+  {
+    closesocket(fd);
+    my_thread_end();
+    return;
+  }
+  if (my_net_init(&net, vio))
+  {
+    vio_delete(vio);
+    my_thread_end();
+    return;
+  }
+
+  if (!sim_handshake(&net, thread_id))
+  {
+    for (;;)
+    {
+      ulong length;
+      net.pkt_nr = net.compress_pkt_nr = 0;
+      if ((length = my_net_read(&net)) == packet_error || length == 0)
+        break;
+      enum enum_server_command command = (enum enum_server_command)net.read_pos[0];
+      if (command == COM_QUIT)
+        break;
+      if (ep->hang)
+      {
+        sim_hang(vio);
+        break;
+      }
+      switch (command) {
+      case COM_QUERY:
+        sim_handle_query(ep, &net, (const char *)net.read_pos + 1, length - 1,
+          rnd);
+        break;
+      case COM_INIT_DB:
+      case COM_PING:
+      case COM_RESET_CONNECTION:
+      case COM_REFRESH:
+        sim_write_ok(&net, 0, SERVER_STATUS_AUTOCOMMIT);
+        break;
+      case COM_SET_OPTION:
+        sim_write_eof(&net, SERVER_STATUS_AUTOCOMMIT);
+        break;
+      default:
+        sim_write_error(&net, ER_UNKNOWN_COM_ERROR, "08S01",
+          "Unknown command");
+        break;
+      }
+      if (net_flush(&net) || net.error)
+        break;
+    }
+  }
+
+  net_end(&net);
+  vio_delete(vio);
+  my_thread_end();
+}
+
+/* listen and accept */
+
+static my_socket sim_listen(const char *host, uint port)
+{
+  struct sockaddr_in addr;
+  int on = 1;
+  my_socket fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd == INVALID_SOCKET)
+    return INVALID_SOCKET;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((ushort)port);
+  if (inet_pton(AF_INET, host, &addr.sin_addr) != 1 ||
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) ||
+    bind(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+    listen(fd, 128))
+  {
+    closesocket(fd);
+    return INVALID_SOCKET;
+  }
+  return fd;
+}
+
+/* one thread polls all listening sockets, a thread per connection */
+static void sim_accept_loop()
+{
+  vector<struct pollfd> poll_list;
+  vector<SIM_ENDPOINT*> ep_list;
+  for (auto ep : sim_endpoints)
+  {
+    if (ep->fd == INVALID_SOCKET)
+      continue;
+    struct pollfd pfd;
+    pfd.fd = ep->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    poll_list.push_back(pfd);
+    ep_list.push_back(ep);
+  }
+
+  for (;;)
+  {
+    if (poll(&poll_list[0], poll_list.size(), -1) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "poll failed: %s\n", strerror(errno));
+      return;
+    }
+    for (size_t i = 0; i < poll_list.size(); i++)
+    {
+      if (!(poll_list[i].revents & POLLIN))
+        continue;
+      my_socket fd = accept(poll_list[i].fd, NULL, NULL);
+      if (fd == INVALID_SOCKET)
+      {
+        if (errno == EMFILE || errno == ENFILE)
+        {
+          fprintf(stderr, "accept failed: %s, raise ulimit -n\n",
+            strerror(errno));
+          sim_sleep_ms(100);
+        }
+        continue;
+      }
+      try
+      {
+        std::thread t(sim_handle_connection, ep_list[i], fd);
+        t.detach();
+      }
+      catch (const std::system_error &e)
+      {
+        fprintf(stderr, "create thread failed: %s, raise ulimit -u\n",
+          e.what());
+        closesocket(fd);
+      }
+    }
+  }
+}
+
+static void sim_print_stats()
+{
+  ulonglong start = sim_now_ms();
+  for (;;)
+  {
+    sim_sleep_ms(opt_stats_interval * 1000ULL);
+    printf("stats elapsed_ms=%llu", sim_now_ms() - start);
+    for (uint i = 0; i < SIM_STAT_COUNT; i++)
+      printf(" %s=%llu", sim_stat_names[i], (ulonglong)sim_stats[i]);
+    printf("\n");
+    fflush(stdout);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int ho_error;
+  uint listened = 0;
+  time_t now = time(NULL);
+
+  MY_INIT(argv[0]);
+  if ((ho_error = handle_options(&argc, &argv, my_long_options,
+    get_one_option)))
+    exit(ho_error);
+  if (!opt_host)
+    opt_host = (char *)"127.0.0.1";
+  if (opt_base_port + opt_count - 1 > 65535)
+  {
+    fprintf(stderr, "--base-port + --count exceeds 65535\n");
+    exit(1);
+  }
+  if (sim_port_in_list(opt_slow_ports, 0) < 0 ||
+    sim_port_in_list(opt_hang_ports, 0) < 0 ||
+    sim_port_in_list(opt_down_ports, 0) < 0)
+  {
+    fprintf(stderr, "wrong port list, use ranges like 25000-25009,25100\n");
+    exit(1);
+  }
+  signal(SIGPIPE, SIG_IGN);
+
+  for (uint i = 0; i < opt_count; i++)
+  {
+    SIM_ENDPOINT *ep = new SIM_ENDPOINT;
+    ep->port = opt_base_port + i;
+    ep->slow = sim_port_in_list(opt_slow_ports, ep->port) > 0;
+    ep->hang = sim_port_in_list(opt_hang_ports, ep->port) > 0;
+    ep->fd = INVALID_SOCKET;
+    /* same xids on every endpoint, like the branches of one transaction */
+    for (uint x = 0; x < opt_xa_prepared; x++)
+      ep->xa_map["tc_backend_sim_" + to_string(x)] = now - opt_xa_prepared_age;
+    if (sim_port_in_list(opt_down_ports, ep->port) <= 0)
+    {
+      if ((ep->fd = sim_listen(opt_host, ep->port)) == INVALID_SOCKET)
+      {
+        fprintf(stderr, "listen on %s:%u failed: %s\n", opt_host, ep->port,
+          strerror(errno));
+        exit(1);
+      }
+      listened++;
+    }
+    sim_endpoints.push_back(ep);
+  }
+  printf("listening on %u endpoints of %s:%u-%u\n", listened, opt_host,
+    opt_base_port, opt_base_port + opt_count - 1);
+  fflush(stdout);
+
+  if (opt_stats_interval)
+  {
+    std::thread t(sim_print_stats);
+    t.detach();
+  }
+  if (listened)
+    sim_accept_loop();
+  else
+    for (;;)
+      sim_sleep_ms(1000);
+  my_end(0);
+  return 0;
+}
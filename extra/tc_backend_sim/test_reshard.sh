@@ -0,0 +1,143 @@
+#!/bin/bash
+# Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+#
+# Check of TDBCTL RESHARD on a real cluster, not on the simulator: the
+# remotes must be MySQL, the copy uses triggers and chunks of the table.
+#
+# A table with composite primary key (a, b) and shard key a is filled
+# through a spider, a new remote is added as the last SPT server and the
+# table is resharded with small chunks, then rows and checksum read through
+# the spider must be the same as before. Then checks that
+#   - a table of more shards than the MYSQL wrapper servers is refused
+#   - a secondary tdbctl refuses to reshard, if TDBCTL_SECONDARY_MYSQL is set
+# The database DB is dropped and the new remote removed at the end.
+#
+# Environment:
+#   TDBCTL_MYSQL            client command of the primary tdbctl, default
+#                           "mysql -h127.0.0.1 -P26000 -uroot"
+#   TDBCTL_SECONDARY_MYSQL  client command of a secondary tdbctl, optional
+#   SPIDER_MYSQL            client command of a spider, default
+#                           "mysql -h127.0.0.1 -P25000 -uroot"
+#   NEW_REMOTE              host:port:user:password of a MySQL not in the
+#                           cluster yet, required
+#   DB                      database, default tc_test_reshard
+#   ROWS                    rows of the table, default 5000
+#   CHUNK                   tc_reshard_chunk_size during the check, default 97
+
+TDBCTL_MYSQL=${TDBCTL_MYSQL:-"mysql -h127.0.0.1 -P26000 -uroot"}
+SPIDER_MYSQL=${SPIDER_MYSQL:-"mysql -h127.0.0.1 -P25000 -uroot"}
+DB=${DB:-tc_test_reshard}
+ROWS=${ROWS:-5000}
+CHUNK=${CHUNK:-97}
+
+if [ -z "$NEW_REMOTE" ]; then
+  echo "NEW_REMOTE is not set" >&2
+  exit 2
+fi
+IFS=: read -r NEW_HOST NEW_PORT NEW_USER NEW_PASSWD <<< "$NEW_REMOTE"
+
+tc_sql()
+{
+  $TDBCTL_MYSQL -N -B -e "$1"
+}
+
+spider_sql()
+{
+  $SPIDER_MYSQL -N -B -e "$1"
+}
+
+fail()
+{
+  echo "FAIL: $*"
+  exit 1
+}
+
+# run $2 on client $1, it must fail with message containing $3
+expect_error()
+{
+  local out
+  out=$($1 -N -B -e "$2" 2>&1) && fail "\"$2\" succeeded, expected: $3"
+  echo "$out" | grep -qF "$3" || fail "\"$2\": $out, expected: $3"
+}
+
+prefix=$(tc_sql "select @@global.tc_mysql_wrapper_prefix")
+remotes=$(tc_sql "select count(*) from mysql.servers where Wrapper = 'mysql'")
+new_server="$prefix$remotes"
+old_chunk=$(tc_sql "select @@global.tc_reshard_chunk_size")
+
+add_new_server()
+{
+  tc_sql "create server $new_server foreign data wrapper mysql options(host '$NEW_HOST',
+    port $NEW_PORT, user '$NEW_USER', password '$NEW_PASSWD');
+    tdbctl flush routing"
+}
+
+test_cleanup()
+{
+  tc_sql "set global tc_reshard_chunk_size = $old_chunk"
+  if [ -z "$(tc_sql "select Server_name from mysql.servers where Server_name = '$new_server'")" ]; then
+    add_new_server
+  fi
+  spider_sql "drop database if exists $DB"
+  tc_sql "drop server if exists $new_server; tdbctl flush routing"
+}
+
+trap test_cleanup EXIT
+
+table_state()
+{
+  spider_sql "select count(*), sum(crc32(concat_ws('#', a, b, v))) from $DB.$1"
+}
+
+fill_table()
+{
+  local i=0 values
+  while [ $i -lt $ROWS ]; do
+    values=""
+    for j in $(seq $i $((i + 499))); do
+      [ $j -ge $ROWS ] && break
+      values="$values${values:+,}($((j % 101)), $j, md5($j))"
+    done
+    spider_sql "insert into $DB.$1 values $values" || fail "insert into $1"
+    i=$((i + 500))
+  done
+}
+
+create_table()
+{
+  spider_sql "create table $DB.$1(a int not null, b int not null, v varchar(32),
+    primary key(a, b)) comment 'shard_key \"a\"'" || fail "create table $1"
+}
+
+spider_sql "create database if not exists $DB" || fail "create database"
+create_table t
+fill_table t
+before=$(table_state t)
+
+# grow: the table has $remotes shards, $new_server is added
+add_new_server || fail "create server $new_server"
+tc_sql "set global tc_reshard_chunk_size = $CHUNK"
+begin=$(date +%s)
+tc_sql "tdbctl reshard $DB.t" || fail "reshard $DB.t"
+echo "reshard of $ROWS rows to $((remotes + 1)) shards in $(($(date +%s) - begin)) s"
+after=$(table_state t)
+[ "$before" = "$after" ] || fail "rows differ after reshard: $before, $after"
+for a in 0 1 50 100; do
+  count=$(spider_sql "select count(*) from $DB.t where a = $a")
+  expected=$(( (ROWS - a + 100) / 101 ))
+  [ "$count" = "$expected" ] || fail "$count rows of a = $a, expected $expected"
+done
+echo "ok: rows and checksum are the same after reshard"
+
+# shrink: a table of $((remotes + 1)) shards with $remotes servers
+create_table t_shrink
+tc_sql "drop server $new_server; tdbctl flush routing" || fail "drop server $new_server"
+expect_error "$TDBCTL_MYSQL" "tdbctl reshard $DB.t_shrink" "shard count can't be reduced"
+add_new_server || fail "create server $new_server"
+echo "ok: reshard to fewer shards is refused"
+
+if [ -n "$TDBCTL_SECONDARY_MYSQL" ]; then
+  expect_error "$TDBCTL_SECONDARY_MYSQL" "tdbctl reshard $DB.t" "not primary"
+  echo "ok: secondary tdbctl refuses to reshard"
+fi
+echo "PASS"
@@ -200,6 +200,12 @@ enum enum_sql_command {
 	TC_SQLCOM_DROP_NODE,
 	TC_SQLCOM_SHOW_PROCESSLIST,
 	TC_SQLCOM_SHOW_VARIABLES,
+	TC_SQLCOM_CHECK_SCHEMA,
+	TC_SQLCOM_SHOW_STATUS,
+	TC_SQLCOM_ROUTE,
+	TC_SQLCOM_RESHARD,
+	TC_SQLCOM_CHECKSUM,
+	TC_SQLCOM_FLUSH_LATENCY,
   /* This should be the last !!! */
   SQLCOM_END
 };
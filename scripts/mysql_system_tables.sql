@@ -96,6 +96,14 @@ CREATE TABLE IF NOT EXISTS cluster_admin.tc_partiton_admin_log ( uid int(11) NOT
 
 CREATE TABLE IF NOT EXISTS cluster_admin.tc_partiton_admin_config ( db_name char(64) NOT NULL DEFAULT '', tb_name char(64) NOT NULL DEFAULT '', partition_column char(64) DEFAULT 'thedate', expiration_time int(11) DEFAULT NULL, partition_column_type char(64) NOT NULL DEFAULT 'int', interval_time int(11) DEFAULT '1' COMMENT 'interval', remote_hash_algorithm char(64) DEFAULT 'list', is_partitioned int(11) DEFAULT '0', updatetime timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE  CURRENT_TIMESTAMP, PRIMARY KEY (`db_name`,`tb_name`)) ENGINE=InnoDB STATS_PERSISTENT=0;
 
+CREATE TABLE IF NOT EXISTS cluster_admin.tc_schema_catalog_log ( version bigint NOT NULL AUTO_INCREMENT, db_name char(64) NOT NULL DEFAULT '', tb_name char(64) NOT NULL DEFAULT '', sql_type char(64) NOT NULL DEFAULT '', query mediumtext, create_time timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP, KEY `idx_db_tb` (`db_name`,`tb_name`), PRIMARY KEY (`version`)) ENGINE=InnoDB STATS_PERSISTENT=0;
+
+CREATE TABLE IF NOT EXISTS cluster_admin.tc_schema_catalog ( db_name char(64) NOT NULL DEFAULT '', tb_name char(64) NOT NULL DEFAULT '', server_name char(64) NOT NULL DEFAULT '', version bigint NOT NULL DEFAULT 0, create_sql mediumtext, updatetime timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE  CURRENT_TIMESTAMP, PRIMARY KEY (`db_name`,`tb_name`,`server_name`)) ENGINE=InnoDB STATS_PERSISTENT=0;
+
+CREATE TABLE IF NOT EXISTS cluster_admin.tc_table_stats ( db_name char(64) NOT NULL DEFAULT '', tb_name char(64) NOT NULL DEFAULT '', server_name char(64) NOT NULL DEFAULT '', host char(255) NOT NULL DEFAULT '', table_rows bigint unsigned NOT NULL DEFAULT 0, data_length bigint unsigned NOT NULL DEFAULT 0, index_length bigint unsigned NOT NULL DEFAULT 0, data_free bigint unsigned NOT NULL DEFAULT 0, update_time datetime DEFAULT NULL, collect_time timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE  CURRENT_TIMESTAMP, PRIMARY KEY (`db_name`,`tb_name`,`server_name`)) ENGINE=InnoDB STATS_PERSISTENT=0;
+
+create or replace view cluster_admin.v_tc_table_skew as select db_name,tb_name,count(*) as shards,sum(table_rows) as table_rows, sum(data_length+index_length) as total_length, max(data_length+index_length) as max_length, avg(data_length+index_length) as avg_length, substring_index(group_concat(server_name order by data_length+index_length desc),',',1) as max_server_name, round(max(data_length+index_length)/nullif(avg(data_length+index_length),0),2) as skew_ratio from cluster_admin.tc_table_stats group by db_name,tb_name;
+
 SET @sql_mode_orig=@@SESSION.sql_mode;
 SET SESSION sql_mode='NO_ENGINE_SUBSTITUTION';
 
@@ -686,6 +686,12 @@ enum enum_schema_tables
   SCH_TABLE_NAMES,
   SCH_TABLE_PRIVILEGES,
   SCH_TABLE_STATS,
+  SCH_TC_CLUSTER_GLOBAL_STATUS,
+  SCH_TC_CLUSTER_INNODB_TRX,
+  SCH_TC_CLUSTER_PROCESSLIST,
+  SCH_TC_CLUSTER_TABLES,
+  SCH_TC_DDL_TRACE,
+  SCH_TC_NODE_LATENCY,
   SCH_TEMPORARY_TABLES,
   SCH_THREAD_STATS,
   SCH_TRIGGERS,
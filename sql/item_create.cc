@@ -3700,6 +3700,19 @@ protected:
 };
 
 
+class Create_func_tc_shard_index : public Create_func_arg3
+{
+public:
+  virtual Item *create(THD *thd, Item *arg1, Item *arg2, Item *arg3);
+
+  static Create_func_tc_shard_index s_singleton;
+
+protected:
+  Create_func_tc_shard_index() {}
+  virtual ~Create_func_tc_shard_index() {}
+};
+
+
 class Create_func_time_format : public Create_func_arg2
 {
 public:
@@ -7101,6 +7114,15 @@ Create_func_tan::create(THD *thd, Item *arg1)
 }
 
 
+Create_func_tc_shard_index Create_func_tc_shard_index::s_singleton;
+
+Item*
+Create_func_tc_shard_index::create(THD *thd, Item *arg1, Item *arg2, Item *arg3)
+{
+  return new (thd->mem_root) Item_func_tc_shard_index(POS(), arg1, arg2, arg3);
+}
+
+
 Create_func_time_format Create_func_time_format::s_singleton;
 
 Item*
@@ -7727,6 +7749,7 @@ static Native_func_registry func_array[] =
   { { C_STRING_WITH_LEN("SUBSTRING_INDEX") }, BUILDER(Create_func_substr_index)},
   { { C_STRING_WITH_LEN("SUBTIME") }, BUILDER(Create_func_subtime)},
   { { C_STRING_WITH_LEN("TAN") }, BUILDER(Create_func_tan)},
+  { { C_STRING_WITH_LEN("TC_SHARD_INDEX") }, BUILDER(Create_func_tc_shard_index)},
   { { C_STRING_WITH_LEN("TIMEDIFF") }, BUILDER(Create_func_timediff)},
   { { C_STRING_WITH_LEN("TIME_FORMAT") }, BUILDER(Create_func_time_format)},
   { { C_STRING_WITH_LEN("TIME_TO_SEC") }, BUILDER(Create_func_time_to_sec)},
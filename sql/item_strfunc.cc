@@ -49,6 +49,7 @@ C_MODE_START
 C_MODE_END
 
 #include "template_utils.h"
+#include "tc_route.h"                // tc_route_get_rule
 
 #include "pfs_file_provider.h"
 #include "mysql/psi/mysql_file.h"
@@ -4985,6 +4986,68 @@ longlong Item_func_crc32::val_int()
   return (longlong) crc32(0L, (uchar*)res->ptr(), res->length());
 }
 
+/*
+  the rule of the table is fetched at the first row and kept until the
+  statement ends, it is fetched again when db or table of the row differs.
+*/
+longlong Item_func_tc_shard_index::val_int()
+{
+  DBUG_ASSERT(fixed == 1);
+  String db_buf, tb_buf;
+  String *db= args[0]->val_str(&db_buf);
+  String *tb= args[1]->val_str(&tb_buf);
+  longlong shard;
+
+  null_value= 1;
+  if (!db || !tb)
+    return 0;
+  if (rule && (stringcmp(db, &rule_db) || stringcmp(tb, &rule_table)))
+  {
+    delete rule;
+    rule= NULL;
+  }
+  if (!rule)
+  {
+    rule= new TC_ROUTE_RULE;
+    if (tc_route_get_rule(std::string(db->ptr(), db->length()),
+                          std::string(tb->ptr(), tb->length()), *rule))
+    {
+      delete rule;
+      rule= NULL;
+      return 0;
+    }
+    rule_db.copy(*db);
+    rule_table.copy(*tb);
+  }
+
+  if (rule->func == TC_ROUTE_FUNC_NONE)
+  {
+    longlong key= args[2]->val_int();
+    if (args[2]->null_value)
+      return 0;
+    shard= tc_route_shard_by_int(*rule, key, args[2]->unsigned_flag);
+  }
+  else
+  {
+    String *key= args[2]->val_str(&value);
+    if (!key)
+      return 0;
+    shard= tc_route_shard_by_str(*rule, key->ptr(), key->length(),
+                                 key->charset());
+  }
+  if (shard < 0)
+    return 0;
+  null_value= 0;
+  return shard;
+}
+
+void Item_func_tc_shard_index::cleanup()
+{
+  delete rule;
+  rule= NULL;
+  Item_int_func::cleanup();
+}
+
 #ifdef HAVE_COMPRESS
 #include "zlib.h"
 
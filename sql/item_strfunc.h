@@ -1263,6 +1263,26 @@ public:
   longlong val_int();
 };
 
+/*
+  TC_SHARD_INDEX(db, table, key): shard index of key of spider table,
+  computed by the partition rule of the table on tdbctl.
+  rule_db and rule_table are the table the rule is got for.
+*/
+class Item_func_tc_shard_index :public Item_int_func
+{
+  String value;
+  String rule_db, rule_table;
+  struct tc_route_rule *rule;
+public:
+  Item_func_tc_shard_index(const POS &pos, Item *a, Item *b, Item *c)
+    :Item_int_func(pos, a, b, c), rule(NULL)
+  {}
+  const char *func_name() const { return "tc_shard_index"; }
+  void fix_length_and_dec() { max_length= 10; maybe_null= 1; }
+  longlong val_int();
+  void cleanup();
+};
+
 class Item_func_uncompressed_length : public Item_int_func
 {
   String value;
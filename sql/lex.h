@@ -430,6 +430,7 @@ static const SYMBOL symbols[] = {
   { SYM("NUMERIC",                  NUMERIC_SYM)},
   { SYM("NVARCHAR",                 NVARCHAR_SYM)},
   { SYM("OFFSET",                   OFFSET_SYM)},
+  { SYM("OLDER",                    OLDER_SYM)},
   { SYM("ON",                       ON)},
   { SYM("ONE",                      ONE_SYM)},
   { SYM("ONLY",                     ONLY_SYM)},
@@ -149,6 +149,7 @@
 #include "tc_monitor.h"
 #include "tc_xa_repair.h"
 #include "tc_partition_admin.h"
+#include "tc_table_stats.h"
 #include<iostream>
 #include<thread>
 
@@ -438,9 +439,17 @@ my_bool tc_partition_admin = TRUE;
 my_bool tc_restrict_query_from_spider = TRUE;
 ulong tc_check_repair_routing_interval = 300;
 ulong tc_check_availability_interval = 10;
+ulong tc_check_availability_max_interval = 5;
+double tc_check_availability_phi_threshold = 8;
 ulong tc_partition_admin_interval = 86400;
 ulong tc_partition_admin_time = 3600;
 ulong tc_partition_init_interval = 300;
+ulong tc_partition_admin_threads = 8;
+ulong tc_partition_admin_host_threads = 2;
+ulong tc_partition_admin_window = 1800;
+ulong tc_partition_admin_max_threads_running = 50;
+ulong tc_partition_admin_max_slave_lag = 300;
+ulong tc_partition_admin_precreate_days = 40;
 /*
 -1: unknown
 0:  not primary
@@ -451,6 +460,14 @@ because tdbctl_is_primary it not maintained when network partition
 long tdbctl_is_primary = 0;
 char *tc_skip_dump_db_list;
 ulong tc_max_prepared_time = 60;
+ulong tc_xa_commit_log_retention = 0;
+ulong tc_reshard_chunk_size = 1000;
+ulong tc_checksum_chunk_size = 10000;
+ulong tc_checksum_threads = 8;
+ulong tc_checksum_host_threads = 2;
+my_bool tc_table_stats = TRUE;
+ulong tc_table_stats_interval = 300;
+ulong tc_ddl_trace_jobs = 32;
 ulong opt_binlog_rows_event_max_size;
 const char *binlog_checksum_default= "NONE";
 ulong binlog_checksum_options;
@@ -537,6 +554,9 @@ ulonglong denied_connections= 0;
   if check ok then tc_is_available=1
 */
 int tc_is_available = 0;
+/* progress of the current partition admin round, (table, remote) items */
+ulong tc_partition_admin_total = 0;
+ulong tc_partition_admin_done = 0;
 
 /**
   Limit of the total number of prepared statements in the server.
@@ -4651,6 +4671,7 @@ static int init_tdbctl_components()
   create_tc_xa_repair_thread();
   create_check_cluster_availability_thread();
   create_partition_admin_thread();
+  create_tc_table_stats_thread();
 
   DBUG_RETURN(0);
 }
@@ -7255,6 +7276,8 @@ SHOW_VAR status_vars[]= {
   {"Tc_log_max_pages_used",    (char*) &tc_log_max_pages_used,                         SHOW_LONG,              SHOW_SCOPE_GLOBAL},
   {"Tc_log_page_size",         (char*) &tc_log_page_size,                              SHOW_LONG_NOFLUSH,      SHOW_SCOPE_GLOBAL},
   {"Tc_log_page_waits",        (char*) &tc_log_page_waits,                             SHOW_LONG,              SHOW_SCOPE_GLOBAL},
+  {"Tc_partition_admin_done",  (char*) &tc_partition_admin_done,                       SHOW_LONG,              SHOW_SCOPE_GLOBAL},
+  {"Tc_partition_admin_total", (char*) &tc_partition_admin_total,                      SHOW_LONG,              SHOW_SCOPE_GLOBAL},
 #ifdef HAVE_POOL_OF_THREADS
   {"Threadpool_idle_threads",  (char *) &show_threadpool_idle_threads,                 SHOW_FUNC,              SHOW_SCOPE_GLOBAL},
   {"Threadpool_threads",       (char *) &tp_stats.num_worker_threads,                  SHOW_INT,               SHOW_SCOPE_GLOBAL},
@@ -9864,6 +9887,9 @@ void init_server_psi_keys(void)
   mysql_statement_register(category, &stmt_info_rpl, 1);
 #endif
 
+  /* tdbctl threads and calls to nodes */
+  init_tc_psi_keys();
+
   /* Common client and server code. */
   init_client_psi_keys();
   /* Vio */
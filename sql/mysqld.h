@@ -183,12 +183,28 @@ extern my_bool tc_partition_admin;
 extern my_bool tc_restrict_query_from_spider;
 extern ulong tc_check_repair_routing_interval;
 extern ulong tc_check_availability_interval;
+extern ulong tc_check_availability_max_interval;
+extern double tc_check_availability_phi_threshold;
 extern ulong tc_partition_admin_interval;
 extern ulong tc_partition_init_interval;
 extern ulong tc_partition_admin_time;
+extern ulong tc_partition_admin_threads;
+extern ulong tc_partition_admin_host_threads;
+extern ulong tc_partition_admin_window;
+extern ulong tc_partition_admin_max_threads_running;
+extern ulong tc_partition_admin_max_slave_lag;
+extern ulong tc_partition_admin_precreate_days;
 extern char *tc_skip_dump_db_list;
 extern long tdbctl_is_primary;
 extern ulong tc_max_prepared_time;
+extern ulong tc_xa_commit_log_retention;
+extern ulong tc_reshard_chunk_size;
+extern ulong tc_checksum_chunk_size;
+extern ulong tc_checksum_threads;
+extern ulong tc_checksum_host_threads;
+extern my_bool tc_table_stats;
+extern ulong tc_table_stats_interval;
+extern ulong tc_ddl_trace_jobs;
 extern my_bool opt_old_style_user_limits, trust_function_creators;
 extern my_bool check_proxy_users, mysql_native_password_proxy_users, sha256_password_proxy_users;
 extern uint opt_crash_binlog_innodb;
@@ -293,6 +309,8 @@ extern my_bool binlog_gtid_simple_recovery;
 extern ulong binlog_error_action;
 extern ulong locked_account_connection_count;
 extern int tc_is_available;
+extern ulong tc_partition_admin_total;
+extern ulong tc_partition_admin_done;
 enum enum_binlog_error_action
 {
   /// Ignore the error and let server continue without binlogging
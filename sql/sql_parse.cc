@@ -105,6 +105,11 @@
 #include "tc_base.h"
 #include "tc_monitor.h"
 #include "tc_node.h"
+#include "tc_schema_catalog.h"
+#include "tc_route.h"
+#include "tc_reshard.h"
+#include "tc_checksum.h"
+#include "tc_latency.h"
 #include "tc_show.h"
 
 #ifndef _WIN32
@@ -779,6 +784,12 @@ void init_update_queries(void)
   sql_command_flags[TC_SQLCOM_FLUSH_ROUTING]|=        CF_ALLOW_PROTOCOL_PLUGIN;
   sql_command_flags[TC_SQLCOM_SHOW_VARIABLES]|=       CF_ALLOW_PROTOCOL_PLUGIN;
   sql_command_flags[TC_SQLCOM_SHOW_PROCESSLIST]|=     CF_ALLOW_PROTOCOL_PLUGIN;
+  sql_command_flags[TC_SQLCOM_CHECK_SCHEMA]|=         CF_ALLOW_PROTOCOL_PLUGIN;
+  sql_command_flags[TC_SQLCOM_SHOW_STATUS]|=          CF_ALLOW_PROTOCOL_PLUGIN;
+  sql_command_flags[TC_SQLCOM_ROUTE]|=                CF_ALLOW_PROTOCOL_PLUGIN;
+  sql_command_flags[TC_SQLCOM_RESHARD]|=              CF_ALLOW_PROTOCOL_PLUGIN;
+  sql_command_flags[TC_SQLCOM_CHECKSUM]|=             CF_ALLOW_PROTOCOL_PLUGIN;
+  sql_command_flags[TC_SQLCOM_FLUSH_LATENCY]|=        CF_ALLOW_PROTOCOL_PLUGIN;
   sql_command_flags[TC_SQLCOM_CREATE_NODE]|=          CF_ALLOW_PROTOCOL_PLUGIN;
   sql_command_flags[TC_SQLCOM_ALTER_NODE]|=           CF_ALLOW_PROTOCOL_PLUGIN;
   sql_command_flags[TC_SQLCOM_DROP_NODE]|=            CF_ALLOW_PROTOCOL_PLUGIN;
@@ -828,6 +839,7 @@ void init_update_queries(void)
   sql_command_flags[TC_SQLCOM_ALTER_NODE] |= CF_DISALLOW_IN_NO_PRIMARY;
   sql_command_flags[TC_SQLCOM_DROP_NODE] |= CF_DISALLOW_IN_NO_PRIMARY;
   sql_command_flags[TC_SQLCOM_FLUSH_ROUTING] |= CF_DISALLOW_IN_NO_PRIMARY;
+  sql_command_flags[TC_SQLCOM_RESHARD] |= CF_DISALLOW_IN_NO_PRIMARY;
 }
 
 bool sqlcom_can_generate_row_events(enum enum_sql_command command)
@@ -3888,14 +3900,34 @@ end_with_restore_list:
       lex->verbose);
     break;
   case TC_SQLCOM_SHOW_PROCESSLIST:
-    if (!thd->security_context()->priv_user().str[0] &&
-        check_global_access(thd,PROCESS_ACL))
+    if (check_global_access(thd, PROCESS_ACL))
       break;
-    tc_show_processlist(thd, lex->verbose, lex->server_name);
+    res= tc_show_processlist(thd, lex->verbose, lex->server_name,
+                             lex->select_lex->where_cond(),
+                             lex->select_lex->select_limit);
     break;
   case TC_SQLCOM_SHOW_VARIABLES:
     tc_show_variables(thd, lex->option_type, lex->wild, lex->server_name);
     break;
+  case TC_SQLCOM_CHECK_SCHEMA:
+    res= tc_check_schema(thd, lex->name, lex->ident);
+    break;
+  case TC_SQLCOM_SHOW_STATUS:
+    res= tc_show_global_status(thd, lex->server_name, lex->ident, lex->verbose);
+    break;
+  case TC_SQLCOM_ROUTE:
+    res= tc_route_keys(thd, lex->name, lex->ident, lex->select_lex->item_list);
+    break;
+  case TC_SQLCOM_RESHARD:
+    res= tc_reshard_table(thd, lex->name, lex->ident);
+    break;
+  case TC_SQLCOM_CHECKSUM:
+    res= tc_checksum_table(thd, lex->name, lex->ident, lex->verbose);
+    break;
+  case TC_SQLCOM_FLUSH_LATENCY:
+    tc_latency_flush();
+    my_ok(thd);
+    break;
   case SQLCOM_SHOW_PRIVILEGES:
     res= mysqld_show_privileges(thd);
     break;
@@ -5479,11 +5511,7 @@ end_with_restore_list:
 
       string server_name, add_address;
       list<FOREIGN_SERVER*> server_list;
-      char path[FN_REFLEN + 1];
-      char *p = my_stpnmov(path, mysql_tmpdir, sizeof(path));
-      my_snprintf(p, sizeof(path) - (p - path), "/%s_%lu%lx_%lx.sql",
-        tmp_file_prefix, current_thd->query_start(), current_pid,
-        thd->thread_id());
+      int ret = 0;
 
       /*
         get spider_list from mysql.servers, exclude slave spiders
@@ -5508,23 +5536,22 @@ end_with_restore_list:
       DBUG_ASSERT(strcasecmp(server_list.front()->host, lex->server_options.get_host()) != 0 &&
         server_list.front()->port != lex->server_options.get_port());
 
-      if (tc_dump_node_schema(
+      ret = tc_copy_node_schema(
         server_list.front()->host,
         server_list.front()->port,
         server_list.front()->username,
         server_list.front()->password,
-        path))
+        lex->server_options.get_host(),
+        lex->server_options.get_port(),
+        lex->server_options.get_username(),
+        lex->server_options.get_password());
+      if (ret == 1)
       {
         my_error(ER_TCADMIN_DUMP_NODE_ERROR, MYF(0),
           server_list.front()->host, server_list.front()->port);
         goto error;
       }
-
-      if (tc_restore_node_schema(lex->server_options.get_host(),
-        lex->server_options.get_port(),
-        lex->server_options.get_username(),
-        lex->server_options.get_password(),
-        path))
+      else if (ret)
       {
         my_error(ER_TCADMIN_RESTORE_NODE_ERROR, MYF(0),
           lex->server_options.get_host(), lex->server_options.get_port());
@@ -6010,7 +6037,7 @@ tcadmin_execute_command(THD* thd, bool first_level)
     parse_result.query_string = thd->query();
     parse_result.db_name = tc_get_cur_dbname(thd, lex);
     parse_result.table_name = tc_get_cur_tbname(thd, lex);
-    parse_result.result = tc_parse_getkey_for_spider(thd, key_name, result_info, sizeof(result_info), &parse_result.is_with_unique, &is_unsigned_key);
+    parse_result.result = tc_parse_getkey_for_spider(thd, key_name, result_info, sizeof(result_info), &parse_result.is_with_unique, &is_unsigned_key, &parse_result.shard_key_type);
     parse_result.result_info = result_info;
     parse_result.shard_key = key_name;
 
@@ -6475,11 +6502,7 @@ tcadmin_execute_command(THD* thd, bool first_level)
 
       string server_name, add_address;
       list<FOREIGN_SERVER*> server_list;
-      char path[FN_REFLEN + 1];
-      char *p = my_stpnmov(path, mysql_tmpdir, sizeof(path));
-      my_snprintf(p, sizeof(path) - (p - path), "/%s_%lu%lx_%lx.sql",
-                  tmp_file_prefix, current_thd->query_start(), current_pid,
-                  thd->thread_id());
+      int ret = 0;
 
       /*
         get spider_list from mysql.servers, exclude slave spiders
@@ -6503,23 +6526,22 @@ tcadmin_execute_command(THD* thd, bool first_level)
       */
       DBUG_ASSERT(strcasecmp(server_list.front()->host, lex->server_options.get_host()) != 0 &&
                   server_list.front()->port != lex->server_options.get_port());
-      if (tc_dump_node_schema(
+      ret = tc_copy_node_schema(
           server_list.front()->host,
           server_list.front()->port,
           server_list.front()->username,
           server_list.front()->password,
-          path))
+          lex->server_options.get_host(),
+          lex->server_options.get_port(),
+          lex->server_options.get_username(),
+          lex->server_options.get_password());
+      if (ret == 1)
       {
         my_error(ER_TCADMIN_DUMP_NODE_ERROR, MYF(0),
                   server_list.front()->host, server_list.front()->port);
         goto error;
       }
-
-      if (tc_restore_node_schema(lex->server_options.get_host(),
-          lex->server_options.get_port(),
-          lex->server_options.get_username(),
-          lex->server_options.get_password(),
-          path))
+      else if (ret)
       {
         my_error(ER_TCADMIN_RESTORE_NODE_ERROR, MYF(0),
                 lex->server_options.get_host(), lex->server_options.get_port());
@@ -6544,13 +6566,13 @@ tcadmin_execute_command(THD* thd, bool first_level)
   }
   case TC_SQLCOM_SHOW_PROCESSLIST:
   {
-    if (!thd->security_context()->priv_user().str[0] &&
-        check_global_access(thd, PROCESS_ACL))
+    if (check_global_access(thd, PROCESS_ACL))
       goto error;
 
-    tc_show_processlist(thd, lex->verbose, lex->server_name);
-
-    my_ok(thd);
+    if (tc_show_processlist(thd, lex->verbose, lex->server_name,
+                            lex->select_lex->where_cond(),
+                            lex->select_lex->select_limit))
+      goto error;
     goto finish;
   }
   case TC_SQLCOM_SHOW_VARIABLES:
@@ -6559,6 +6581,42 @@ tcadmin_execute_command(THD* thd, bool first_level)
     my_ok(thd);
     goto finish;
   }
+  case TC_SQLCOM_CHECK_SCHEMA:
+  {
+    if (tc_check_schema(thd, lex->name, lex->ident))
+      goto error;
+    goto finish;
+  }
+  case TC_SQLCOM_SHOW_STATUS:
+  {
+    if (tc_show_global_status(thd, lex->server_name, lex->ident, lex->verbose))
+      goto error;
+    goto finish;
+  }
+  case TC_SQLCOM_ROUTE:
+  {
+    if (tc_route_keys(thd, lex->name, lex->ident, lex->select_lex->item_list))
+      goto error;
+    goto finish;
+  }
+  case TC_SQLCOM_RESHARD:
+  {
+    if (tc_reshard_table(thd, lex->name, lex->ident))
+      goto error;
+    goto finish;
+  }
+  case TC_SQLCOM_CHECKSUM:
+  {
+    if (tc_checksum_table(thd, lex->name, lex->ident, lex->verbose))
+      goto error;
+    goto finish;
+  }
+  case TC_SQLCOM_FLUSH_LATENCY:
+  {
+    tc_latency_flush();
+    my_ok(thd);
+    goto finish;
+  }
 
   /* 5. other may be supported int the future */
   case SQLCOM_UNLOCK_TABLES:
@@ -6589,6 +6647,8 @@ tcadmin_execute_command(THD* thd, bool first_level)
       goto error;
     tc_append_before_query(thd, lex, before_sql_for_spider, before_sql_for_remote);
     tc_ddl_run(thd, lex, before_sql_for_spider, before_sql_for_remote, spider_sql, remote_sql_map, &exec_result);
+    if (!exec_result.result)
+      tc_schema_catalog_update(thd, lex->sql_command, &parse_result);
     res = tc_process_all_result(thd, &parse_result, &exec_result);
     goto finish;
   }
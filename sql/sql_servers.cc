@@ -1500,6 +1500,9 @@ int tc_set_changed_remote_read_only()
     tdbctl node: need ALL PRIVILEGES to connect spider, remote do DDL etc.
     remote node: N/A
 
+    accounts already exist with the right password and privileges are
+    skipped, only the difference is granted on each node.
+
     tdbctl only need to do grants on primary node at present
     tdbctl, spider, remote must all exists in mysql.servers, otherwise, return 0(ok).
 
@@ -1514,18 +1517,21 @@ int tc_do_grants_internal(LEX *lex)
   map<string, string> spider_user_map;
   map<string, string> spider_passwd_map;
   map<string, tc_exec_info> spider_result_map;
+  map<string, vector<TC_GRANT_ITEM> > spider_grant_map;
   string spider_do_sql;
 
   map<string, MYSQL*> remote_conn_map;
   map<string, string> remote_user_map;
   map<string, string> remote_passwd_map;
   map<string, tc_exec_info> remote_result_map;
-  string remote_do_sql;
+  map<string, vector<TC_GRANT_ITEM> > remote_grant_map;
 
   map<string, MYSQL*> tdbctl_conn_map;
   map<string, string> tdbctl_user_map;
   map<string, string> tdbctl_passwd_map;
   map<string, tc_exec_info> tdbctl_result_map;
+  map<string, vector<TC_GRANT_ITEM> > tdbctl_grant_map;
+  vector<TC_GRANT_ITEM> tdbctl_grant_list;
   string tdbctl_do_sql;
 
   string host;
@@ -1625,11 +1631,10 @@ int tc_do_grants_internal(LEX *lex)
 
   //remote do grant
   init_result_map2(remote_result_map, remote_ipport_map);
-  remote_do_sql = tc_get_remote_grant_sql(spider_ipport_set, spider_user_map,
-	  spider_passwd_map, remote_ipport_map, remote_user_map, remote_passwd_map,
-	  tdbctl_ipport_map, tdbctl_user_map, tdbctl_passwd_map);
-  if (tc_exec_sql_paral(remote_do_sql, remote_conn_map,
-	  remote_result_map, remote_user_map, remote_passwd_map, FALSE))
+  for (auto &remote : remote_ipport_map)
+    tc_get_remote_grant_list(remote.second, remote_user_map, remote_passwd_map,
+      spider_ipport_set, tdbctl_ipport_map, remote_grant_map[remote.second]);
+  if (tc_do_grants_paral("", remote_conn_map, remote_grant_map, remote_result_map))
   {/* return, close conn, reconnect + retry all */
 	  error = 1;
 	  my_error(ER_TCADMIN_INTERNAL_GRANT_ERROR, MYF(0), concat_result_map(remote_result_map).c_str());
@@ -1642,10 +1647,11 @@ int tc_do_grants_internal(LEX *lex)
   init_result_map(spider_result_map, spider_ipport_set);
   //set ddl_execute_by_ctl to off on spider, only need execute on spider node
   spider_do_sql = "set ddl_execute_by_ctl = off;";
-  spider_do_sql += tc_get_spider_grant_sql(spider_ipport_set, spider_user_map,
-      spider_passwd_map, tdbctl_ipport_map, tdbctl_user_map, tdbctl_passwd_map);
-  if (tc_exec_sql_paral(spider_do_sql, spider_conn_map,
-      spider_result_map, spider_user_map, spider_passwd_map, FALSE))
+  for (auto &spider : spider_ipport_set)
+    tc_get_spider_grant_list(spider, spider_user_map, spider_passwd_map,
+      tdbctl_ipport_map, spider_grant_map[spider]);
+  if (tc_do_grants_paral(spider_do_sql, spider_conn_map, spider_grant_map,
+      spider_result_map))
   {/* return, close conn, reconnect + retry all */
     error = 1;
     my_error(ER_TCADMIN_INTERNAL_GRANT_ERROR, MYF(0), concat_result_map(spider_result_map).c_str());
@@ -1654,10 +1660,12 @@ int tc_do_grants_internal(LEX *lex)
 
   //tdbctl do grant
   init_result_map2(tdbctl_result_map, tdbctl_ipport_map);
-  tdbctl_do_sql += tc_get_tdbctl_grant_sql(spider_ipport_set, spider_user_map,
-      spider_passwd_map, tdbctl_ipport_map, tdbctl_user_map, tdbctl_passwd_map);
-  if (tc_exec_sql_paral(tdbctl_do_sql, tdbctl_conn_map,
-    tdbctl_result_map, tdbctl_user_map, tdbctl_passwd_map, FALSE))
+  tc_get_tdbctl_grant_list(spider_ipport_set, tdbctl_ipport_map,
+      tdbctl_user_map, tdbctl_passwd_map, tdbctl_grant_list);
+  for (auto &tdbctl : tdbctl_conn_map)
+    tdbctl_grant_map[tdbctl.first] = tdbctl_grant_list;
+  if (tc_do_grants_paral(tdbctl_do_sql, tdbctl_conn_map, tdbctl_grant_map,
+    tdbctl_result_map))
   {
     error = 1;
     my_error(ER_TCADMIN_INTERNAL_GRANT_ERROR, MYF(0), concat_result_map(tdbctl_result_map).c_str());
@@ -1782,6 +1790,7 @@ bool tc_check_ipport_valid()
 /* at present, CREATE/ALTER(mysql wrapper) NODE also do tc_flush_routing */
 bool tc_flush_routing(LEX* lex)
 {
+  Tc_latency_op_guard latency_op_guard(TC_LATENCY_OP_FLUSH);
   int ret = 0;
   bool result = FALSE;
 	bool is_force = lex->is_tc_flush_force;
@@ -1877,6 +1886,8 @@ bool tc_flush_routing(LEX* lex)
 
 finish:
   tc_conn_free(spider_conn_map);
+  /* latency slots of dropped nodes can be taken by new nodes */
+  tc_latency_release_stale();
   spider_conn_map.clear();
   all_spider_ipport_set.clear();
   to_flush_ipport_set.clear();
@@ -1965,6 +1976,7 @@ int compare_and_return_changed_server(
 
 void tc_check_and_repair_routing_thread()
 {
+  tc_latency_cur_op = TC_LATENCY_OP_FLUSH;
   while (1)
   {
 	  if (tc_check_repair_routing && tdbctl_is_primary)
@@ -2269,7 +2281,8 @@ finish:
 
 void create_check_and_repaire_routing_thread()
 {
-  std::thread t(tc_check_and_repair_routing_thread);
+  std::thread t(tc_thread_create(key_thread_tc_routing_repair,
+    tc_check_and_repair_routing_thread));
   t.detach();
 }
 
@@ -62,6 +62,7 @@
 #include "partition_info.h"                 // partition_info
 #include "partitioning/partition_handler.h" // Partition_handler
 
+#include "tc_information_schema.h"           // tc_fill_cluster_processlist
 #include "pfs_file_provider.h"
 #include "mysql/psi/mysql_file.h"
 #ifndef EMBEDDED_LIBRARY
@@ -9902,6 +9903,18 @@ ST_SCHEMA_TABLE schema_tables[]=
    fill_schema_table_privileges, 0, 0, -1, -1, 0, 0},
   {"TABLE_STATISTICS", table_stats_fields_info, create_schema_table,
     fill_schema_table_stats, make_old_format, 0, -1, -1, 0, 0},
+  {"TC_CLUSTER_GLOBAL_STATUS", tc_cluster_global_status_fields_info,
+   create_schema_table, tc_fill_cluster_global_status, 0, 0, -1, -1, 0, 0},
+  {"TC_CLUSTER_INNODB_TRX", tc_cluster_innodb_trx_fields_info,
+   create_schema_table, tc_fill_cluster_innodb_trx, 0, 0, -1, -1, 0, 0},
+  {"TC_CLUSTER_PROCESSLIST", tc_cluster_processlist_fields_info,
+   create_schema_table, tc_fill_cluster_processlist, 0, 0, -1, -1, 0, 0},
+  {"TC_CLUSTER_TABLES", tc_cluster_tables_fields_info,
+   create_schema_table, tc_fill_cluster_tables, 0, 0, -1, -1, 0, 0},
+  {"TC_DDL_TRACE", tc_ddl_trace_fields_info,
+   create_schema_table, tc_fill_ddl_trace, 0, 0, -1, -1, 0, 0},
+  {"TC_NODE_LATENCY", tc_node_latency_fields_info,
+   create_schema_table, tc_fill_node_latency, 0, 0, -1, -1, 0, 0},
   {"TEMPORARY_TABLES", temporary_table_fields_info, create_schema_table,
    fill_temporary_tables, make_temporary_tables_old_format, 0, 2, 3, 0,
    OPEN_TABLE_ONLY|OPTIMIZE_I_S_TABLE},
@@ -863,6 +863,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, YYLTYPE **c, ulong *yystacksize);
 %token  NUMERIC_SYM                   /* SQL-2003-R */
 %token  NVARCHAR_SYM
 %token  OFFSET_SYM
+%token  OLDER_SYM
 %token  ON                            /* SQL-2003-R */
 %token  ONE_SYM
 %token  ONLY_SYM                      /* SQL-2003-R */
@@ -1230,6 +1231,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, YYLTYPE **c, ulong *yystacksize);
 
 %type <ulong_num>
         ulong_num real_ulong_num merge_insert_types
+        opt_xa_recover_older_than
         ws_nweights func_datetime_precision
         ws_level_flag_desc ws_level_flag_reverse ws_level_flags
         opt_ws_levels ws_level_list ws_level_list_item ws_level_number
@@ -2286,6 +2288,16 @@ tdbctl:
           Lex->sql_command = TC_SQLCOM_FLUSH_ROUTING;
           Lex->tc_do_grants = FALSE;
         }
+      | TDBCTL_SYM FLUSH_SYM IDENT_sys
+        {
+          /* TDBCTL FLUSH LATENCY */
+          if (my_strcasecmp(system_charset_info, $3.str, "LATENCY"))
+          {
+            my_syntax_error(ER_THD(YYTHD, ER_SYNTAX_ERROR));
+            MYSQL_YYABORT;
+          }
+          Lex->sql_command = TC_SQLCOM_FLUSH_LATENCY;
+        }
       | TDBCTL_SYM MONITOR_SYM INIT_SYM
         {
           Lex->sql_command = TC_SQLCOM_MONITOR_INIT;
@@ -2331,7 +2343,7 @@ tdbctl:
               new (YYTHD->mem_root) Sql_cmd_drop_server($5, $4);
           Lex->tc_do_grants = FALSE;
         }
-      | TDBCTL_SYM SHOW opt_server opt_full PROCESSLIST_SYM
+      | TDBCTL_SYM SHOW opt_server opt_full PROCESSLIST_SYM opt_tdbctl_where opt_tdbctl_limit
         {
           Lex->sql_command = TC_SQLCOM_SHOW_PROCESSLIST;
         }
@@ -2339,6 +2351,115 @@ tdbctl:
         {
           Lex->sql_command = TC_SQLCOM_SHOW_VARIABLES;
         }
+      | TDBCTL_SYM SHOW opt_server GLOBAL_SYM STATUS_SYM opt_tdbctl_aggregate
+        {
+          Lex->sql_command = TC_SQLCOM_SHOW_STATUS;
+          Lex->ident= null_lex_str;
+        }
+      | TDBCTL_SYM SHOW IDENT_sys GLOBAL_SYM STATUS_SYM opt_tdbctl_aggregate
+        {
+          Lex->sql_command = TC_SQLCOM_SHOW_STATUS;
+          Lex->server_name = NULL;
+          Lex->ident= $3;
+        }
+      | TDBCTL_SYM IDENT_sys table_ident KEYS '(' expr_list ')'
+        {
+          /* TDBCTL ROUTE db.table KEYS (key, ...) */
+          if (my_strcasecmp(system_charset_info, $2.str, "ROUTE"))
+          {
+            my_syntax_error(ER_THD(YYTHD, ER_SYNTAX_ERROR));
+            MYSQL_YYABORT;
+          }
+          CONTEXTUALIZE($6);
+          Lex->sql_command = TC_SQLCOM_ROUTE;
+          Lex->name.str= const_cast<char *>($3->db.str);
+          Lex->name.length= $3->db.length;
+          Lex->ident.str= const_cast<char *>($3->table.str);
+          Lex->ident.length= $3->table.length;
+          Select->item_list= $6->value;
+        }
+      | TDBCTL_SYM IDENT_sys table_ident
+        {
+          /* TDBCTL RESHARD db.table */
+          if (my_strcasecmp(system_charset_info, $2.str, "RESHARD"))
+          {
+            my_syntax_error(ER_THD(YYTHD, ER_SYNTAX_ERROR));
+            MYSQL_YYABORT;
+          }
+          Lex->sql_command = TC_SQLCOM_RESHARD;
+          Lex->name.str= const_cast<char *>($3->db.str);
+          Lex->name.length= $3->db.length;
+          Lex->ident.str= const_cast<char *>($3->table.str);
+          Lex->ident.length= $3->table.length;
+        }
+      | TDBCTL_SYM CHECKSUM_SYM TABLE_SYM table_ident opt_tdbctl_with_slaves
+        {
+          /* TDBCTL CHECKSUM TABLE db.table [WITH SLAVES] */
+          Lex->sql_command = TC_SQLCOM_CHECKSUM;
+          Lex->name.str= const_cast<char *>($4->db.str);
+          Lex->name.length= $4->db.length;
+          Lex->ident.str= const_cast<char *>($4->table.str);
+          Lex->ident.length= $4->table.length;
+        }
+      | TDBCTL_SYM CHECK_SYM DATABASE opt_tdbctl_check_target
+        {
+          Lex->sql_command = TC_SQLCOM_CHECK_SCHEMA;
+        }
+        ;
+
+opt_tdbctl_aggregate:
+          /* empty */ { Lex->verbose= false; }
+        | AGGREGATE_SYM { Lex->verbose= true; }
+        ;
+
+opt_tdbctl_with_slaves:
+          /* empty */ { Lex->verbose= false; }
+        | WITH IDENT_sys
+          {
+            if (my_strcasecmp(system_charset_info, $2.str, "SLAVES"))
+            {
+              my_syntax_error(ER_THD(YYTHD, ER_SYNTAX_ERROR));
+              MYSQL_YYABORT;
+            }
+            Lex->verbose= true;
+          }
+        ;
+
+opt_tdbctl_where:
+          /* empty */
+        | WHERE expr
+          {
+            ITEMIZE($2, &$2);
+            Select->set_where_cond($2);
+          }
+        ;
+
+opt_tdbctl_limit:
+          /* empty */
+        | LIMIT real_ulonglong_num
+          {
+            Select->select_limit= new (YYTHD->mem_root) Item_uint($2);
+            if (Select->select_limit == NULL)
+              MYSQL_YYABORT;
+          }
+        ;
+
+opt_tdbctl_check_target:
+         /* empty */
+        {
+          Lex->name= null_lex_str;
+          Lex->ident= null_lex_str;
+        }
+        | ident
+        {
+          Lex->name= $1;
+          Lex->ident= null_lex_str;
+        }
+        | ident '.' ident
+        {
+          Lex->name= $1;
+          Lex->ident= $3;
+        }
         ;
 
           
@@ -13925,6 +14046,7 @@ keyword_sp:
         | NUMBER_SYM               {}
         | NVARCHAR_SYM             {}
         | OFFSET_SYM               {}
+        | OLDER_SYM                {}
         | ONE_SYM                  {}
         | ONLY_SYM                 {}
         | PACK_KEYS_SYM            {}
@@ -15838,12 +15960,24 @@ xa:
             Lex->sql_command = SQLCOM_XA_RECOVER;
             Lex->m_sql_cmd= new (YYTHD->mem_root) Sql_cmd_xa_recover($3);
           }
+        | XA_SYM RECOVER_SYM opt_convert_xid WITH TIME_SYM
+          opt_xa_recover_older_than
+          {
+            Lex->sql_command = SQLCOM_XA_RECOVER;
+            Lex->m_sql_cmd= new (YYTHD->mem_root)
+                              Sql_cmd_xa_recover($3, true, $6);
+          }
         ;
 
 opt_convert_xid:
           /* empty */ { $$= false; }
          | CONVERT_SYM XID_SYM { $$= true; }
 
+opt_xa_recover_older_than:
+          /* empty */ { $$= 0; }
+        | OLDER_SYM THAN_SYM ulong_num { $$= $3; }
+        ;
+
 xid:
           text_string
           {
@@ -6332,6 +6332,16 @@ static Sys_var_mybool Sys_tc_force_execute(
        SESSION_VAR(tc_force_execute), CMD_LINE(OPT_ARG),
        DEFAULT(TRUE));
 
+static Sys_var_ulong Sys_tc_fanout_read_timeout(
+       "tc_fanout_read_timeout",
+       "The timeout(seconds) of read only queries sent to all nodes, such as "
+       "TDBCTL SHOW and TC_CLUSTER_* tables, nodes not replied in time are "
+       "reported as stragglers and the results of other nodes are returned. "
+       "The global value is used by xa recover of tc_check_repair_trans. "
+       "0 means no timeout other than the read timeout of the connection",
+       SESSION_VAR(tc_fanout_read_timeout), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 600), DEFAULT(10), BLOCK_SIZE(1));
+
 static Sys_var_mybool Sys_tc_check_repair_routing(
        "tc_check_repair_routing",
        "If set to TRUE, check and repair routing between tdbctl and spiders",
@@ -6356,6 +6366,20 @@ static Sys_var_ulong Sys_tc_check_availability_interval(
 	GLOBAL_VAR(tc_check_availability_interval), CMD_LINE(REQUIRED_ARG),
 	VALID_RANGE(3, 65535), DEFAULT(10), BLOCK_SIZE(1));
 
+static Sys_var_ulong Sys_tc_check_availability_max_interval(
+	"tc_check_availability_max_interval",
+	"The max interval time of probing a stable spider node when check the availability of the cluster, "
+	"no more than half of tc_check_availability_interval",
+	GLOBAL_VAR(tc_check_availability_max_interval), CMD_LINE(REQUIRED_ARG),
+	VALID_RANGE(1, 65535), DEFAULT(5), BLOCK_SIZE(1));
+
+static Sys_var_double Sys_tc_check_availability_phi_threshold(
+	"tc_check_availability_phi_threshold",
+	"The suspicion level(phi) of accrual failure detector above which a spider node "
+	"is considered unavailable when check the availability of the cluster",
+	GLOBAL_VAR(tc_check_availability_phi_threshold), CMD_LINE(REQUIRED_ARG),
+	VALID_RANGE(1, 100), DEFAULT(8));
+
 static Sys_var_mybool Sys_tc_check_repair_trans(
   "tc_check_repair_trans",
   "If set to TRUE, check and repair  prepared transaction of remote data node",
@@ -6370,6 +6394,61 @@ static Sys_var_ulong Sys_tc_max_prepared_time(
   GLOBAL_VAR(tc_max_prepared_time), CMD_LINE(REQUIRED_ARG),
   VALID_RANGE(8, 604800), DEFAULT(60), BLOCK_SIZE(1));
 
+static Sys_var_ulong Sys_tc_xa_commit_log_retention(
+  "tc_xa_commit_log_retention",
+  "The retention time(seconds) of mysql.xa_commit_log of remote data node, "
+  "older records are purged by background thread when repair prepared "
+  "transaction, 0 for never purge",
+  GLOBAL_VAR(tc_xa_commit_log_retention), CMD_LINE(REQUIRED_ARG),
+  VALID_RANGE(0, 365*86400), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_tc_reshard_chunk_size(
+  "tc_reshard_chunk_size",
+  "Rows of one primary key chunk copied by TDBCTL RESHARD, change log of "
+  "old shard is also applied by this size, cutover begins when the change "
+  "log not applied of every old shard is less than this size",
+  GLOBAL_VAR(tc_reshard_chunk_size), CMD_LINE(REQUIRED_ARG),
+  VALID_RANGE(1, 100000), DEFAULT(1000), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_tc_checksum_chunk_size(
+  "tc_checksum_chunk_size",
+  "Rows of one primary key chunk hashed by TDBCTL CHECKSUM TABLE",
+  GLOBAL_VAR(tc_checksum_chunk_size), CMD_LINE(REQUIRED_ARG),
+  VALID_RANGE(1, 1000000), DEFAULT(10000), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_tc_checksum_threads(
+  "tc_checksum_threads",
+  "Max number of shards checked parallel by TDBCTL CHECKSUM TABLE",
+  GLOBAL_VAR(tc_checksum_threads), CMD_LINE(REQUIRED_ARG),
+  VALID_RANGE(1, 256), DEFAULT(8), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_tc_checksum_host_threads(
+  "tc_checksum_host_threads",
+  "Max number of shards checked parallel on the same host by TDBCTL "
+  "CHECKSUM TABLE, both master and slaves of a shard are counted",
+  GLOBAL_VAR(tc_checksum_host_threads), CMD_LINE(REQUIRED_ARG),
+  VALID_RANGE(1, 64), DEFAULT(2), BLOCK_SIZE(1));
+
+static Sys_var_mybool Sys_tc_table_stats(
+  "tc_table_stats",
+  "If set to TRUE, primary tdbctl collects table statistics of every "
+  "remote into cluster_admin.tc_table_stats",
+  GLOBAL_VAR(tc_table_stats), CMD_LINE(OPT_ARG),
+  DEFAULT(TRUE));
+
+static Sys_var_ulong Sys_tc_table_stats_interval(
+  "tc_table_stats_interval",
+  "The interval time(seconds) of collecting table statistics of remotes",
+  GLOBAL_VAR(tc_table_stats_interval), CMD_LINE(REQUIRED_ARG),
+  VALID_RANGE(10, 86400), DEFAULT(300), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_tc_ddl_trace_jobs(
+  "tc_ddl_trace_jobs",
+  "Number of the last cluster DDL whose timeline is kept for "
+  "information_schema.TC_DDL_TRACE, 0 disables the trace",
+  GLOBAL_VAR(tc_ddl_trace_jobs), CMD_LINE(REQUIRED_ARG),
+  VALID_RANGE(0, 1024), DEFAULT(32), BLOCK_SIZE(1));
+
 static Sys_var_charptr Sys_tc_spider_wrapper_prefix(
   "tc_spider_wrapper_prefix", "prefix of server name for SPIDER wrapper",
   READ_ONLY GLOBAL_VAR(tdbctl_spider_wrapper_prefix),
@@ -6439,6 +6518,43 @@ static Sys_var_ulong Sys_tc_partition_admin_time(
 	GLOBAL_VAR(tc_partition_admin_time), CMD_LINE(REQUIRED_ARG),
 	VALID_RANGE(0, 86400), DEFAULT(3600), BLOCK_SIZE(1));
 
+static Sys_var_ulong Sys_tc_partition_admin_threads(
+	"tc_partition_admin_threads",
+	"The max number of remotes admin partition at the same time",
+	GLOBAL_VAR(tc_partition_admin_threads), CMD_LINE(REQUIRED_ARG),
+	VALID_RANGE(1, 1024), DEFAULT(8), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_tc_partition_admin_host_threads(
+	"tc_partition_admin_host_threads",
+	"The max number of remotes on the same host admin partition at the same time",
+	GLOBAL_VAR(tc_partition_admin_host_threads), CMD_LINE(REQUIRED_ARG),
+	VALID_RANGE(1, 64), DEFAULT(2), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_tc_partition_admin_window(
+	"tc_partition_admin_window",
+	"The seconds which add and delete partition of remotes are spread across, "
+	"0 for all remotes start at the same time",
+	GLOBAL_VAR(tc_partition_admin_window), CMD_LINE(REQUIRED_ARG),
+	VALID_RANGE(0, 43200), DEFAULT(1800), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_tc_partition_admin_max_threads_running(
+	"tc_partition_admin_max_threads_running",
+	"Defer admin partition of a remote whose Threads_running exceeds it, 0 for no check",
+	GLOBAL_VAR(tc_partition_admin_max_threads_running), CMD_LINE(REQUIRED_ARG),
+	VALID_RANGE(0, 100000), DEFAULT(50), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_tc_partition_admin_max_slave_lag(
+	"tc_partition_admin_max_slave_lag",
+	"Defer admin partition of a remote whose Seconds_Behind_Master exceeds it, 0 for no check",
+	GLOBAL_VAR(tc_partition_admin_max_slave_lag), CMD_LINE(REQUIRED_ARG),
+	VALID_RANGE(0, 86400), DEFAULT(300), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_tc_partition_admin_precreate_days(
+	"tc_partition_admin_precreate_days",
+	"The days partitions are created ahead of now",
+	GLOBAL_VAR(tc_partition_admin_precreate_days), CMD_LINE(REQUIRED_ARG),
+	VALID_RANGE(1, 365), DEFAULT(40), BLOCK_SIZE(1));
+
 static Sys_var_long Sys_tc_is_primary(
 	"tc_is_primary",
 	"where the node is primary,-1 for unknown,0 for not-primary,1 for primary",
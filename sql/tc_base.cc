@@ -13,6 +13,8 @@
 #include "handler.h"
 #include "log.h"
 #include "rpl_group_replication.h"
+#include "password.h"
+#include "errmsg.h"
 #include <string.h>
 #include <iostream>
 #include <string>
@@ -24,6 +26,8 @@
 #include <regex>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <memory>
 #include "rpl_slave.h"
 #ifndef WIN32
 #include <arpa/inet.h>
@@ -900,7 +904,7 @@ int tcadmin_validate_and_fill_value(
 }
 
 // buf_len means length of key_name ... result, etc
-bool tc_parse_getkey_for_spider(THD *thd, char *key_name, char *result, int buf_len, bool *is_unique_key, bool *is_unsigned_key)
+bool tc_parse_getkey_for_spider(THD *thd, char *key_name, char *result, int buf_len, bool *is_unique_key, bool *is_unsigned_key, enum_field_types *key_type)
 {
     LEX* lex = thd->lex;
     List_iterator<Create_field> it_field = lex->alter_info.create_list;
@@ -1093,6 +1097,7 @@ bool tc_parse_getkey_for_spider(THD *thd, char *key_name, char *result, int buf_
         if (!strcmp(tmp_field->field_name, key_name))
         {
             *is_unsigned_key = tmp_field->flags & UNSIGNED_FLAG;
+            *key_type = tmp_field->sql_type;
             break;
         }
     }
@@ -1249,6 +1254,7 @@ void tc_parse_result_init(TC_PARSE_RESULT *parse_result_t)
     parse_result_t->is_with_shard = FALSE;
     parse_result_t->is_with_autu = FALSE;
     parse_result_t->is_with_unique = FALSE;
+    parse_result_t->shard_key_type = MYSQL_TYPE_LONG;
     parse_result_t->result = TRUE;
 }
 
@@ -1326,49 +1332,121 @@ string tc_get_only_spider_ddl(TC_PARSE_RESULT *tc_parse_result_t, int shard_coun
     return sql;
 }
 
-string tcadmin_get_shard_range_by_index(int index, int shard_count, bool is_unsigned) {
-    string ret;
+/*
+  upper bound of partition index in range sharding, the key domain
+  [min_value, min_value + width] is split evenly into shard_count parts
+
+  @NOTE:
+    computed as min_value + floor((width + 1) * (index + 1) / shard_count)
+    without overflow, the last partition is always MAXVALUE
+*/
+string tcadmin_get_shard_range_by_index(
+    int index,
+    int shard_count,
+    longlong min_value,
+    ulonglong width,
+    bool is_unsigned)
+{
     ostringstream sstr;
+    ulonglong count = shard_count;
+    ulonglong part = index + 1;
+    ulonglong offset;
     /* index should always be less than shard_count, at most equal than shard_count - 1*/
-    if (index == shard_count - 1) 
+    if (index == shard_count - 1)
+        return "MAXVALUE";
+
+    offset = (width / count) * part + ((width % count + 1) * part) / count;
+    if (is_unsigned)
+        sstr << (ulonglong)min_value + offset;
+    else
+        sstr << (longlong)((ulonglong)min_value + offset);
+    return sstr.str();
+}
+
+/*
+  partition expression and key domain of range sharding
+
+  crc32/crc32_ci: crc32(key)%N, domain is [0, N-1]
+  integer key: the key itself, domain is the range of its type
+  date: to_days(key), datetime: to_seconds(key), timestamp:
+    unix_timestamp(key), domain is the range of the type
+*/
+static void tc_get_shard_range_expr(
+    tspider_shard_func shard_func,
+    enum_field_types key_type,
+    bool *is_unsigned_key,
+    string hash_key,
+    int shard_count,
+    string *expr,
+    longlong *min_value,
+    ulonglong *width)
+{
+    uint bits = 64;
+    hash_key = "`" + hash_key + "`";
+    if (shard_func == tspider_shard_func_crc32 ||
+        shard_func == tspider_shard_func_crc32_ci)
     {
-        ret = "MAXVALUE";
+        *expr = (shard_func == tspider_shard_func_crc32 ? "crc32(" : "crc32_ci(") +
+            hash_key + ")%" + to_string(shard_count);
+        *is_unsigned_key = true;
+        *min_value = 0;
+        *width = shard_count - 1;
+        return;
     }
-    else 
+
+    switch (key_type)
     {
-        if (is_unsigned)
-        {   /* If shard_count == 1, it should not come here */
-            unsigned int range = INT_MAX / shard_count;
-            unsigned int ret_val = range * (index + 1);
-            sstr << ret_val;
-            ret = sstr.str();
-        }
-        else 
-        {
-            int zero_line = (shard_count - 1) / 2;
-            int below_zero_cnt = zero_line + 1;
-            int above_zero_cnt = shard_count - below_zero_cnt;
-            int ret_val = 0;
-            if (index == zero_line)
-            {
-                ret = "0";
-            }            
-            else if (index < zero_line)
-            {
-                ret_val = INT_MIN / below_zero_cnt * (below_zero_cnt - 1 - index);
-                sstr << ret_val;
-                ret = sstr.str();
-            }
-            else
-            {
-                ret_val = INT_MAX / above_zero_cnt * (index - zero_line);
-                sstr << ret_val;
-                ret = sstr.str();
-            }
-            
-        }
+    case MYSQL_TYPE_DATE:
+    case MYSQL_TYPE_NEWDATE:
+        /* '1000-01-01' to '9999-12-31' */
+        *expr = "to_days(" + hash_key + ")";
+        *is_unsigned_key = false;
+        *min_value = calc_daynr(1000, 1, 1);
+        *width = calc_daynr(9999, 12, 31) - *min_value;
+        return;
+    case MYSQL_TYPE_DATETIME:
+    case MYSQL_TYPE_DATETIME2:
+        /* '1000-01-01 00:00:00' to '9999-12-31 23:59:59' */
+        *expr = "to_seconds(" + hash_key + ")";
+        *is_unsigned_key = false;
+        *min_value = (longlong)calc_daynr(1000, 1, 1) * SECONDS_IN_24H;
+        *width = ((longlong)calc_daynr(9999, 12, 31) + 1) * SECONDS_IN_24H - 1 - *min_value;
+        return;
+    case MYSQL_TYPE_TIMESTAMP:
+    case MYSQL_TYPE_TIMESTAMP2:
+        /* '1970-01-01 00:00:01' UTC to '2038-01-19 03:14:07' UTC */
+        *expr = "unix_timestamp(" + hash_key + ")";
+        *is_unsigned_key = false;
+        *min_value = 1;
+        *width = INT_MAX32 - 1;
+        return;
+    case MYSQL_TYPE_TINY:
+        bits = 8;
+        break;
+    case MYSQL_TYPE_SHORT:
+        bits = 16;
+        break;
+    case MYSQL_TYPE_INT24:
+        bits = 24;
+        break;
+    case MYSQL_TYPE_LONG:
+        bits = 32;
+        break;
+    default:
+        break;
+    }
+
+    *expr = hash_key;
+    if (*is_unsigned_key)
+    {
+        *min_value = 0;
+        *width = (bits == 64 ? ULLONG_MAX : (1ULL << bits) - 1);
+    }
+    else
+    {
+        *min_value = (bits == 64 ? LLONG_MIN : -(1LL << (bits - 1)));
+        *width = (bits == 64 ? ULLONG_MAX : (1ULL << bits) - 1);
     }
-    return ret;
 }
 
 string tc_get_spider_create_table(
@@ -1388,6 +1466,9 @@ string tc_get_spider_create_table(
     string connection_string;
     string partiton_by = " partition by ";
     string spider_partition_count_str;
+    string range_expr;
+    longlong range_min = 0;
+    ulonglong range_width = 0;
 
     regex pattern1("ENGINE\\s*=\\s*MyISAM", regex::icase);
     regex pattern2("ENGINE\\s*=\\s*InnoDB", regex::icase);
@@ -1412,7 +1493,14 @@ string tc_get_spider_create_table(
     {   /* tspider_shard_type_range */
         partiton_by = partiton_by + "range(";
     }
-    if (shard_func == tspider_shard_func_crc32) 
+    if (shard_type == tspider_shard_type_range)
+    {
+        /* range over the whole domain of the key, not the key%N */
+        tc_get_shard_range_expr(shard_func, tc_parse_result_t->shard_key_type,
+            &is_unsigned_key, hash_key, shard_count, &range_expr, &range_min, &range_width);
+        partiton_by = partiton_by + range_expr + ") (";
+    }
+    else if (shard_func == tspider_shard_func_crc32) 
     {
         is_unsigned_key = true;
         partiton_by = partiton_by + "crc32(" + 
@@ -1448,7 +1536,7 @@ string tc_get_spider_create_table(
         }
         else
         {   /* range */
-            pt_sql = "PARTITION pt" + hash_value + " values less than (" + tcadmin_get_shard_range_by_index(i, shard_count, is_unsigned_key) 
+            pt_sql = "PARTITION pt" + hash_value + " values less than (" + tcadmin_get_shard_range_by_index(i, shard_count, range_min, range_width, is_unsigned_key) 
                 + ") COMMENT = 'database \"" 
                 + db_name + "_" + hash_value + "\", table \"" + tb_name + "\", " + server_info +  "\' ENGINE = SPIDER";
         }
@@ -2126,20 +2214,14 @@ void tc_spider_real_query(
   string ipport
 )
 {
-    int ret = mysql_real_query(mysql, sql.c_str(), sql.length());
     tc_exec_info exec_info;
     exec_info.err_code = 0;
     exec_info.err_msg = "";
-    while (!ret)
-    {
-        ret = tc_mysql_next_result(mysql);
-    }
-    if (ret != -1)
-    {/* error happened */
-        exec_info.err_code = mysql_errno(mysql);
-        exec_info.err_msg = mysql_error(mysql);
+    size_t event = tc_trace_event_begin(exec_result->trace, "spider", ipport);
+    if (tc_exec_sql_without_result(mysql, sql, &exec_info))
         exec_result->result = TRUE;
-    }
+    tc_trace_event_end(exec_result->trace, event, exec_info.err_code,
+        exec_info.err_msg);
     spider_exec_mtx.lock();
     exec_result->spider_result_info.insert(pair<string, tc_exec_info>(ipport, exec_info));
     spider_exec_mtx.unlock();
@@ -2153,20 +2235,14 @@ void tc_remote_real_query(
   string ipport
 )
 {
-    int ret = mysql_real_query(mysql, sql.c_str(), sql.length());
     tc_exec_info exec_info;
     exec_info.err_code = 0;
     exec_info.err_msg = "";
-    while (!ret)
-    {
-        ret = tc_mysql_next_result(mysql);
-    }
-    if (ret != -1)
-    {/* error happened */
-        exec_info.err_code = mysql_errno(mysql);
-        exec_info.err_msg = mysql_error(mysql);
+    size_t event = tc_trace_event_begin(exec_result->trace, "remote", ipport);
+    if (tc_exec_sql_without_result(mysql, sql, &exec_info))
         exec_result->result = TRUE;
-    }
+    tc_trace_event_end(exec_result->trace, event, exec_info.err_code,
+        exec_info.err_msg);
     remote_exec_mtx.lock();
     exec_result->remote_result_info.insert(pair<string, tc_exec_info>(ipport, exec_info));
     remote_exec_mtx.unlock();
@@ -2187,12 +2263,14 @@ bool tc_spider_ddl_run_paral(
     map<string, int> ret_map;
     int i = 0;
 
+    size_t phase = tc_trace_event_begin(exec_result->trace, "spider phase", "");
     map<string, MYSQL*>::iterator its;
     for (its = spider_conn_map.begin(); its != spider_conn_map.end(); its++)
     {
         string ipport = its->first;
         MYSQL *mysql = its->second;
-        thread tmp_t(tc_spider_real_query, mysql, exec_sql, exec_result, ipport);
+        thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_spider_real_query,
+            mysql, exec_sql, exec_result, ipport));
         thread_array[i] = move(tmp_t);
         i++;
     }
@@ -2202,6 +2280,7 @@ bool tc_spider_ddl_run_paral(
         if (thread_array[i].joinable())
             thread_array[i].join();
     }
+    tc_trace_event_end(exec_result->trace, phase, 0, "");
 
     //for (its = spider_conn_map.begin(); its != spider_conn_map.end(); its++)
     //{
@@ -2249,6 +2328,7 @@ bool tc_remotedb_ddl_run_paral(
         return TRUE;
     }
 
+    size_t phase = tc_trace_event_begin(exec_result->trace, "remote phase", "");
     map<string, string>::iterator its;
     for (its = remote_ipport_map.begin(); its != remote_ipport_map.end(); its++)
     {
@@ -2256,7 +2336,8 @@ bool tc_remotedb_ddl_run_paral(
         string ipport = its->second;
         string exec_sql = before_sql + remote_sql_map[server];
         MYSQL *mysql = remote_conn_map[ipport];
-        thread tmp_t(tc_remote_real_query, mysql, exec_sql, exec_result, ipport);
+        thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_remote_real_query,
+            mysql, exec_sql, exec_result, ipport));
         thread_array[i] = move(tmp_t);
         i++;
     }
@@ -2266,6 +2347,7 @@ bool tc_remotedb_ddl_run_paral(
         if (thread_array[i].joinable())
             thread_array[i].join();
     }
+    tc_trace_event_end(exec_result->trace, phase, 0, "");
 
     //for (its = remote_ipport_map.begin(); its != remote_ipport_map.end(); its++)
     //{
@@ -2307,8 +2389,10 @@ bool tc_ddl_run(
   tc_execute_result *exec_result
 )
 {
+    Tc_latency_op_guard latency_op_guard(TC_LATENCY_OP_DDL);
     bool spider_run_first = tc_spider_run_first(thd, lex);
     exec_result->result = FALSE;
+    exec_result->trace = tc_trace_job_begin(thd);
     if (spider_run_first)
     {/* drop table/database/column */
         if (!tc_spider_ddl_run_paral(
@@ -2342,6 +2426,7 @@ bool tc_ddl_run(
               exec_result);
         }
     }
+    tc_trace_job_end(exec_result->trace, exec_result->result);
     return FALSE;
 }
 
@@ -2614,6 +2699,41 @@ string tc_get_user_name(
 }
 
 MYSQL* tc_conn_connect(string ipport, string user, string passwd)
+{
+  return tc_conn_connect_by_deadline(ipport, user, passwd, 0);
+}
+
+/*
+  deadline of a fan-out started now
+
+  @retval
+    my_micro_time() after timeout seconds, 0 for no deadline if timeout is 0
+*/
+ulonglong tc_fanout_deadline(ulong timeout)
+{
+  return timeout ? my_micro_time() + (ulonglong)timeout * 1000000 : 0;
+}
+
+bool tc_fanout_deadline_passed(ulonglong deadline)
+{
+  return deadline && my_micro_time() >= deadline;
+}
+
+/* seconds left until deadline, at least 1, 0 if passed */
+static uint tc_deadline_seconds_left(ulonglong deadline)
+{
+  ulonglong now = my_micro_time();
+  if (now >= deadline)
+    return 0;
+  return (uint)((deadline - now + 999999) / 1000000);
+}
+
+/*
+  connect to node, timeouts are bounded by deadline and no retry is made
+  after the deadline passed, deadline 0 for default timeouts
+*/
+MYSQL* tc_conn_connect_by_deadline(string ipport, string user, string passwd,
+  ulonglong deadline)
 {
   int read_timeout = 600;
   int write_timeout = 600;
@@ -2626,6 +2746,8 @@ MYSQL* tc_conn_connect(string ipport, string user, string passwd)
   uint real_connect_option = 0;
   uint ssl_mode = SSL_MODE_DISABLED;
   MYSQL* mysql;
+  TC_PSI_STATEMENT stmt;
+  string connect_sql = "CONNECT " + user + "@" + ipport;
 
   if (user.length() == 0 && passwd.length() == 0)
   {
@@ -2633,8 +2755,24 @@ MYSQL* tc_conn_connect(string ipport, string user, string passwd)
     return NULL;
   }
 
+  tc_psi_statement_start(&stmt, TC_PSI_STATEMENT_CONNECT, ipport,
+    connect_sql.c_str(), connect_sql.length());
+
   while (connect_retry_count-- > 0)
   {
+    if (deadline)
+    {
+      uint seconds_left = tc_deadline_seconds_left(deadline);
+      if (!seconds_left)
+      {
+        sql_print_warning("tc connect fail: %s, no reply within deadline",
+          ipport.c_str());
+        tc_psi_statement_end(&stmt, NULL, TRUE, 0);
+        return NULL;
+      }
+      read_timeout = write_timeout = (int)seconds_left;
+      connect_timeout = min<int>(connect_timeout, (int)seconds_left);
+    }
     mysql = mysql_init(NULL);
     mysql_options(mysql, MYSQL_OPT_READ_TIMEOUT, &read_timeout);
     mysql_options(mysql, MYSQL_OPT_WRITE_TIMEOUT, &write_timeout);
@@ -2644,18 +2782,51 @@ MYSQL* tc_conn_connect(string ipport, string user, string passwd)
     if (!mysql_real_connect(mysql, hosts.c_str(), user.c_str(), passwd.c_str(), "", port, NULL, real_connect_option))
     {
       sql_print_warning("tc connect fail: error code is %d, error message: %s", mysql_errno(mysql), mysql_error(mysql));
-      if(mysql)
-        mysql_close(mysql);
       if (!connect_retry_count)
+      {
+        tc_psi_statement_end(&stmt, mysql, TRUE, 0);
+        mysql_close(mysql);
         return NULL;
+      }
+      if(mysql)
+        mysql_close(mysql);
     }
     else
       break;
   }
 
+  tc_psi_statement_end(&stmt, mysql, FALSE, 0);
   return mysql;
 }
 
+/*
+  limit read/write on an open connection to the time left until deadline
+
+  @retval
+    FALSE ok
+    TRUE deadline passed
+*/
+bool tc_conn_set_deadline(MYSQL *mysql, ulonglong deadline)
+{
+  if (!deadline)
+    return FALSE;
+  uint seconds_left = tc_deadline_seconds_left(deadline);
+  if (!seconds_left)
+    return TRUE;
+  my_net_set_read_timeout(&mysql->net, seconds_left);
+  my_net_set_write_timeout(&mysql->net, seconds_left);
+  return FALSE;
+}
+
+/* restore timeouts of a connection kept after tc_conn_set_deadline */
+void tc_conn_reset_deadline(MYSQL *mysql)
+{
+  if (!mysql || !mysql->net.vio)
+    return;
+  my_net_set_read_timeout(&mysql->net, mysql->options.read_timeout);
+  my_net_set_write_timeout(&mysql->net, mysql->options.write_timeout);
+}
+
 /*
   get map for  server_name->ipport
 
@@ -2924,7 +3095,8 @@ bool tc_exec_sql_paral(
   {
     string ipport = its->first;
     MYSQL* mysql = its->second;
-    thread tmp_t(tc_exec_sql_up, mysql, exec_sql, &result_map[ipport]);
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_exec_sql_up,
+      mysql, exec_sql, &result_map[ipport]));
     thread_array[i] = move(tmp_t);
     i++;
   }
@@ -2996,7 +3168,8 @@ bool tc_exec_sql_paral_with_result(
   {
     string ipport = its->first;
     MYSQL* mysql = its->second;
-    thread tmp_t(tc_exec_sql_up_with_result, mysql, exec_sql, &result_map[ipport]);
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_exec_sql_up_with_result,
+      mysql, exec_sql, &result_map[ipport]));
     thread_array[i] = move(tmp_t);
     i++;
   }
@@ -3090,9 +3263,168 @@ MYSQL_RES* tc_exec_sql_up_with_result(MYSQL* mysql, string sql, MYSQL_RES** res)
   return *res;
 }
 
+PSI_thread_key key_thread_tc_monitor, key_thread_tc_xa_repair,
+  key_thread_tc_partition_admin, key_thread_tc_routing_repair,
+  key_thread_tc_table_stats, key_thread_tc_worker;
+
+#ifdef HAVE_PSI_INTERFACE
+static PSI_thread_info all_tc_threads[]=
+{
+  { &key_thread_tc_monitor, "tc_monitor", PSI_FLAG_GLOBAL},
+  { &key_thread_tc_xa_repair, "tc_xa_repair", PSI_FLAG_GLOBAL},
+  { &key_thread_tc_partition_admin, "tc_partition_admin", PSI_FLAG_GLOBAL},
+  { &key_thread_tc_routing_repair, "tc_routing_repair", PSI_FLAG_GLOBAL},
+  { &key_thread_tc_table_stats, "tc_table_stats", PSI_FLAG_GLOBAL},
+  { &key_thread_tc_worker, "tc_worker", 0}
+};
+
+/* indexed by tc_psi_statement_type */
+static PSI_statement_info all_tc_statements[]=
+{
+  { 0, "connect", 0},
+  { 0, "query", 0},
+  { 0, "execute", 0}
+};
+#endif /* HAVE_PSI_INTERFACE */
+
+/* register performance_schema keys of tdbctl, called at server start */
+void init_tc_psi_keys()
+{
+#ifdef HAVE_PSI_INTERFACE
+  mysql_thread_register("sql", all_tc_threads, array_elements(all_tc_threads));
+  mysql_statement_register("tdbctl", all_tc_statements,
+    array_elements(all_tc_statements));
+#endif
+}
+
+/*
+  instrument the running std::thread as key
+
+  @retval
+    instrumentation of the thread, passed to tc_psi_thread_end
+*/
+void *tc_psi_thread_init(PSI_thread_key key)
+{
+#ifdef HAVE_PSI_THREAD_INTERFACE
+  PSI_thread *psi = PSI_THREAD_CALL(new_thread)(key, NULL, 0);
+  PSI_THREAD_CALL(set_thread_os_id)(psi);
+  PSI_THREAD_CALL(set_thread)(psi);
+  return psi;
+#else
+  return NULL;
+#endif
+}
+
+void tc_psi_thread_end(void *psi)
+{
+#ifdef HAVE_PSI_THREAD_INTERFACE
+  if (psi)
+    PSI_THREAD_CALL(delete_current_thread)();
+#endif
+}
+
+/* ip#port of a connection to node */
+string tc_mysql_ipport(MYSQL *mysql)
+{
+  if (!mysql || !mysql->host)
+    return "";
+  return string(mysql->host) + "#" + to_string(mysql->port);
+}
+
+#ifdef HAVE_PSI_STATEMENT_INTERFACE
+/*
+  server name of ip#port, ip#port itself if not in mysql.servers
+
+  @NOTE:
+    the map is reloaded only when mysql.servers is modified, and the mutex
+    is taken only to reload it, calls of the same version read the cached
+    map without lock
+*/
+static string tc_psi_server_name(const string &ipport)
+{
+  static std::mutex name_mtx;
+  static std::shared_ptr<const map<string, string>> name_map;
+  static std::atomic<ulong> name_server_version(-1);
+  ulong server_version = get_modify_server_version();
+  if (server_version != name_server_version.load())
+  {
+    std::lock_guard<std::mutex> lock(name_mtx);
+    if (server_version != name_server_version.load())
+    {
+      MEM_ROOT mem_root;
+      init_sql_alloc(key_memory_bases, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+      MEM_ROOT_GUARD(mem_root);
+      std::atomic_store(&name_map, std::shared_ptr<const map<string, string>>(
+        new map<string, string>(get_server_name_map(&mem_root, NULL_WRAPPER, FALSE))));
+      name_server_version.store(server_version);
+    }
+  }
+  std::shared_ptr<const map<string, string>> cur_map = std::atomic_load(&name_map);
+  if (!cur_map)
+    return ipport;
+  map<string, string>::const_iterator its = cur_map->find(ipport);
+  return its == cur_map->end() ? ipport : its->second;
+}
+#endif
+
+/*
+  start the statement event of a call to node, stmt->locker is NULL if
+  the statement is not instrumented
+*/
+void tc_psi_statement_start(TC_PSI_STATEMENT *stmt, tc_psi_statement_type type,
+  const string &ipport, const char *sql, size_t length)
+{
+  stmt->locker = NULL;
+  stmt->type = type;
+  stmt->ipport = ipport;
+  stmt->start_time = my_micro_time();
+#ifdef HAVE_PSI_STATEMENT_INTERFACE
+  stmt->locker = PSI_STATEMENT_CALL(get_thread_statement_locker)(&stmt->state,
+    all_tc_statements[type].m_key, &my_charset_bin, NULL);
+  if (stmt->locker)
+  {
+    /* the node is shown as a comment before the query in SQL_TEXT */
+    string text = "/* " + tc_psi_server_name(ipport) + " */ ";
+    text.append(sql, length);
+    PSI_STATEMENT_CALL(start_statement)(stmt->locker, NULL, 0, __FILE__, __LINE__);
+    PSI_STATEMENT_CALL(set_statement_text)(stmt->locker, text.c_str(),
+      (uint)text.length());
+  }
+#endif
+}
+
+/*
+  end the statement event started by tc_psi_statement_start, and count
+  the call in the latency histogram of its node
+*/
+void tc_psi_statement_end(TC_PSI_STATEMENT *stmt, MYSQL *mysql, bool error,
+  ulonglong rows_sent)
+{
+  tc_latency_collect(stmt->ipport, stmt->type == TC_PSI_STATEMENT_CONNECT ?
+    TC_LATENCY_OP_CONNECT : tc_latency_cur_op,
+    my_micro_time() - stmt->start_time);
+#ifdef HAVE_PSI_STATEMENT_INTERFACE
+  if (!stmt->locker)
+    return;
+  Diagnostics_area da(false);
+  if (error && mysql && mysql_errno(mysql))
+    da.set_error_status(mysql_errno(mysql), mysql_error(mysql), mysql_sqlstate(mysql));
+  else if (error)
+    da.set_error_status(CR_CONN_HOST_ERROR, "can't connect to node", "HY000");
+  else
+    da.set_ok_status(mysql_affected_rows(mysql), mysql_insert_id(mysql), NULL);
+  PSI_STATEMENT_CALL(set_statement_rows_sent)(stmt->locker, rows_sent);
+  PSI_STATEMENT_CALL(end_statement)(stmt->locker, &da);
+  stmt->locker = NULL;
+#endif
+}
+
 MYSQL_RES* tc_exec_sql_with_result(MYSQL* mysql, string sql)
 {
   MYSQL_RES* result;
+  TC_PSI_STATEMENT stmt;
+  tc_psi_statement_start(&stmt, TC_PSI_STATEMENT_QUERY, tc_mysql_ipport(mysql),
+    sql.c_str(), sql.length());
   if (mysql_real_query(mysql, sql.c_str(), sql.length()))
   {
     result = NULL;
@@ -3105,17 +3437,23 @@ MYSQL_RES* tc_exec_sql_with_result(MYSQL* mysql, string sql)
     */
     result = mysql_store_result(mysql);
   }
+  tc_psi_statement_end(&stmt, mysql, result == NULL && mysql_errno(mysql),
+    result ? mysql_num_rows(result) : 0);
   return result;
 }
 
 
 bool tc_exec_sql_without_result(MYSQL* mysql, string sql, tc_exec_info* exec_info)
 {
+  TC_PSI_STATEMENT stmt;
+  tc_psi_statement_start(&stmt, TC_PSI_STATEMENT_EXECUTE, tc_mysql_ipport(mysql),
+    sql.c_str(), sql.length());
   int ret = mysql_real_query(mysql, sql.c_str(), sql.length());
   while (!ret)
   {
     ret = tc_mysql_next_result(mysql);
   }
+  tc_psi_statement_end(&stmt, mysql, ret != -1, 0);
   if (ret != -1)
   {/* error happened */
     exec_info->err_code = mysql_errno(mysql);
@@ -3125,6 +3463,69 @@ bool tc_exec_sql_without_result(MYSQL* mysql, string sql, tc_exec_info* exec_inf
   return FALSE;
 }
 
+/* identifier quoted by backtick */
+string tc_quote_name(const string &name)
+{
+  string res = "`";
+  for (char c : name)
+  {
+    if (c == '`')
+      res += '`';
+    res += c;
+  }
+  return res + "`";
+}
+
+/*
+  escape value as bytes and quote it, NULL for null
+
+  @NOTE:
+    only for connection of binary charset(SET NAMES binary), which
+    copies rows between nodes as bytes
+*/
+void tc_append_quoted_value(string &sql, const char *value, ulong length)
+{
+  if (!value)
+  {
+    sql += "NULL";
+    return;
+  }
+  char *buf = new char[length * 2 + 1];
+  size_t buf_len = escape_string_for_mysql(&my_charset_bin, buf, length * 2 + 1,
+    value, length);
+  sql += "'";
+  sql.append(buf, buf_len);
+  sql += "'";
+  delete[] buf;
+}
+
+/*
+  condition of rows after value_list in the order of column_list, for
+  chunks by primary key
+
+  @NOTE:
+    (a,b) > (x,y) is not used as range by MySQL 5.7, it is expanded to
+    a >= x AND (a > x OR (a = x AND b > y)). columns are quoted and values
+    are quoted constants.
+*/
+string tc_row_greater_sql(const vector<string> &column_list,
+  const vector<string> &value_list)
+{
+  string sql = "";
+  for (size_t i = column_list.size(); i-- > 0;)
+  {
+    string greater = column_list[i] + " > " + value_list[i];
+    if (sql.empty())
+      sql = greater;
+    else
+      sql = "(" + greater + " OR (" + column_list[i] + " = " +
+        value_list[i] + " AND " + sql + "))";
+  }
+  if (column_list.size() > 1)
+    sql = "(" + column_list[0] + " >= " + value_list[0] + " AND " + sql + ")";
+  return sql;
+}
+
 my_time_t string_to_timestamp(const string s)
 {
   MYSQL_TIME_STATUS status;
@@ -3228,166 +3629,318 @@ enum_ident_wrapper_check tc_check_wrapper_name(LEX_STRING *org_name)
   return IDENT_WRAPPER_OK;
 }
 
+/* host part of ip#port */
+static string tc_grant_host(string address)
+{
+  return address.substr(0, address.find("#"));
+}
+
 /*
-  Generate internal spider GRANT sql according to mysql.servers's info.
-  Each spider should do [GRANT ALL PRIVILEGES] sql for all tdbctls, which use to
-  do DDL on spider. If not, after tdbctl(MGR) failover, new primary tdbctl may
-  access denied by spider
-  The generate sqls should execute on each spider
+  Generate internal grants one spider should have.
+  Each spider should do [GRANT ALL PRIVILEGES] for all tdbctls with its own
+  user, which use to do DDL on spider. If not, after tdbctl(MGR) failover,
+  new primary tdbctl may access denied by spider
 */
-string tc_get_spider_grant_sql(
-        set<string> &spider_ipport_set,
+void tc_get_spider_grant_list(
+        string spider_ipport,
         map<string, string> &spider_user_map,
         map<string, string> &spider_passwd_map,
         map<string, string> &tdbctl_ipport_map,
-        map<string, string> &tdbctl_user_map,
-        map<string, string> &tdbctl_passwd_map)
+        vector<TC_GRANT_ITEM> &grant_list)
 {
-  string spider_do_sql;
-  char create_sql[FN_REFLEN], grant_sql[FN_REFLEN];
-  std::for_each(spider_ipport_set.begin(), spider_ipport_set.end(), [&](string spider_ip_port)
+  std::for_each(tdbctl_ipport_map.begin(), tdbctl_ipport_map.end(), [&](std::pair<string, string>tdbctl_ip_port)
   {
-    const char *spider_user = spider_user_map[spider_ip_port].c_str();
-    const char *spider_passwd = spider_passwd_map[spider_ip_port].c_str();
-    std::for_each(tdbctl_ipport_map.begin(), tdbctl_ipport_map.end(), [&](std::pair<string, string>tdbctl_ip_port)
-    {
-      string tdbctl_address = tdbctl_ip_port.second;
-      ulong pos = tdbctl_address.find("#");
-      string tdbctl_host = tdbctl_address.substr(0, pos);
-
-      //tdbctl use spider's user, password to connect current spider
-      sprintf(create_sql, "CREATE USER IF NOT EXISTS '%s'@'%s' IDENTIFIED BY '%s';",
-              spider_user, tdbctl_host.c_str(), spider_passwd);
-      sprintf(grant_sql, "GRANT ALL PRIVILEGES ON *.* TO '%s'@'%s' WITH GRANT OPTION;",
-              spider_user, tdbctl_host.c_str());
-      spider_do_sql += create_sql;
-      spider_do_sql += grant_sql;
-    });
+    //tdbctl use spider's user, password to connect current spider
+    TC_GRANT_ITEM item;
+    item.user = spider_user_map[spider_ipport];
+    item.host = tc_grant_host(tdbctl_ip_port.second);
+    item.passwd = spider_passwd_map[spider_ipport];
+    item.all_privileges = TRUE;
+    grant_list.push_back(item);
   });
-
-  return spider_do_sql;
 }
 
 
 /*
-  Generate internal tdbctl GRANT sql according to mysql.servers's info.
-  All tdbctl should do [GRANT ALL PRIVILEGES] sql for all spiders, which use
+  Generate internal grants tdbctl should have.
+  All tdbctl should do [GRANT ALL PRIVILEGES] for all spiders, which use
   to transfer sql from spider to tdbctl.
-  All spiders should do [GRANT ALL PRIVILEGES] sql for other tdbctl, which use
+  All tdbctl should do [GRANT ALL PRIVILEGES] for other tdbctl, which use
   to connect and manager cluster, if not, after failure, new elected primary tdbctl
   may had no privileges to connect other tdbctl
   In replication scenario, only primary/master node need to do this, which ensure to sync privileges
   to other tdbctl.
 */
-string tc_get_tdbctl_grant_sql(
+void tc_get_tdbctl_grant_list(
         set<string> &spider_ipport_set,
-        map<string, string> &spider_user_map,
-        map<string, string> &spider_passwd_map,
         map<string, string> &tdbctl_ipport_map,
         map<string, string> &tdbctl_user_map,
-        map<string, string> &tdbctl_passwd_map)
+        map<string, string> &tdbctl_passwd_map,
+        vector<TC_GRANT_ITEM> &grant_list)
 {
-  string tdbctl_do_sql;
-  char create_sql[FN_REFLEN], grant_sql[FN_REFLEN];
-
   std::for_each(tdbctl_ipport_map.begin(), tdbctl_ipport_map.end(), [&](std::pair<string, string>tdbctl_ip_port)
   {
     string tdbctl_address = tdbctl_ip_port.second;
-    ulong pos = tdbctl_address.find("#");
-    string tdbctl_host = tdbctl_address.substr(0, pos);
-    const char *tdbctl_user = tdbctl_user_map[tdbctl_address].c_str();
-    const char *tdbctl_passwd = tdbctl_passwd_map[tdbctl_address].c_str();
+    TC_GRANT_ITEM item;
+    item.user = tdbctl_user_map[tdbctl_address];
+    item.passwd = tdbctl_passwd_map[tdbctl_address];
+    item.all_privileges = TRUE;
 
     /**
       use tdbctl's user, password to connect other tdbctl.
       It's necessary to do this, otherwise, after failure, new elected primary
       tdbctl may have no privilege to manager cluster.
     */
-    sprintf(create_sql, "CREATE USER IF NOT EXISTS '%s'@'%s' IDENTIFIED BY '%s';",
-      tdbctl_user, tdbctl_host.c_str(), tdbctl_passwd);
-    sprintf(grant_sql, "GRANT ALL PRIVILEGES ON *.* TO '%s'@'%s' WITH GRANT OPTION;",
-      tdbctl_user, tdbctl_host.c_str());
-    tdbctl_do_sql += create_sql;
-    tdbctl_do_sql += grant_sql;
+    item.host = tc_grant_host(tdbctl_address);
+    grant_list.push_back(item);
 
     //spider use tdbctl's user, password to connect tdbctl
     std::for_each(spider_ipport_set.begin(), spider_ipport_set.end(), [&](string spider_ip_port)
     {
-      ulong pos = spider_ip_port.find("#");
-      string spider_host = spider_ip_port.substr(0, pos);
-      sprintf(create_sql, "CREATE USER IF NOT EXISTS '%s'@'%s' IDENTIFIED BY '%s';",
-        tdbctl_user, spider_host.c_str(), tdbctl_passwd);
-      sprintf(grant_sql, "GRANT ALL PRIVILEGES ON *.* TO '%s'@'%s' WITH GRANT OPTION;",
-        tdbctl_user, spider_host.c_str());
-      tdbctl_do_sql += create_sql;
-      tdbctl_do_sql += grant_sql;
+      item.host = tc_grant_host(spider_ip_port);
+      grant_list.push_back(item);
     });
   });
-
-  return tdbctl_do_sql;
 }
 
 /*
-  Generate internal remote GRANT sql according to mysql.servers's info.
-  1. remote should do [GRANT SELECT, INSERT, TRUNCATE PRIVILEGES] sql for all spiders, spider need
-  privileges do DML on remote
+  Generate internal grants one remote should have.
+  1. remote should do [GRANT SELECT, INSERT, DELETE, UPDATE, DROP] for all spiders
+  with its own user, spider need privileges do DML on remote
   2. remote should do [GRANT ALL PRIVILEGES] for all tdbctls, which use to connect remote and
   do DDL. We must do this, if not, after tdbctl(MGR) failover, new primary tdbctl may access denied by remote
-  The generate sqls need to execute on all remotes
 */
-string tc_get_remote_grant_sql(
-        set<string> &spider_ipport_set,
-        map<string, string> &spider_user_map,
-        map<string, string> &spider_passwd_map,
-        map<string, string> &remote_ipport_map,
+void tc_get_remote_grant_list(
+        string remote_ipport,
         map<string, string> &remote_user_map,
         map<string, string> &remote_passwd_map,
+        set<string> &spider_ipport_set,
         map<string, string> &tdbctl_ipport_map,
-        map<string, string> &tdbctl_user_map,
-        map<string, string> &tdbctl_passwd_map)
+        vector<TC_GRANT_ITEM> &grant_list)
 {
-  string remote_do_sql;
-  char create_sql[FN_REFLEN], grant_sql[FN_REFLEN];
+  TC_GRANT_ITEM item;
+  item.user = remote_user_map[remote_ipport];
+  item.passwd = remote_passwd_map[remote_ipport];
 
-  std::for_each(remote_ipport_map.begin(), remote_ipport_map.end(), [&](std::pair<string, string>remote_ip_port)
+  //spider use remote's user, password to connect remote do DML
+  item.all_privileges = FALSE;
+  std::for_each(spider_ipport_set.begin(), spider_ipport_set.end(), [&](string spider_address)
   {
-    string remote_address = remote_ip_port.second;
-    const char *remote_user = remote_user_map[remote_address].c_str();
-    const char *remote_passwd = remote_passwd_map[remote_address].c_str();
-
-    //remote do grants for spider
-    std::for_each(spider_ipport_set.begin(), spider_ipport_set.end(), [&](string spider_address)
-    {
-      ulong pos = spider_address.find("#");
-      string spider_host = spider_address.substr(0, pos);
-
-      //spider use remote's user, password to connect remote do DML
-      sprintf(create_sql, "CREATE USER IF NOT EXISTS '%s'@'%s' IDENTIFIED BY '%s';",
-              remote_user, spider_host.c_str(), remote_passwd);
-      sprintf(grant_sql, "GRANT SELECT, INSERT, DELETE, UPDATE, DROP ON *.* to '%s'@'%s' WITH GRANT OPTION;",
-              remote_user, spider_host.c_str());
-      remote_do_sql += create_sql;
-      remote_do_sql += grant_sql;
-    });
-
-    //remote do grants for tdbctl
-    std::for_each(tdbctl_ipport_map.begin(), tdbctl_ipport_map.end(), [&](std::pair<string, string>tdbctl_ip_port)
-    {
-      string tdbctl_address = tdbctl_ip_port.second;
-      ulong pos = tdbctl_address.find("#");
-      string tdbctl_host = tdbctl_address.substr(0, pos);
+    item.host = tc_grant_host(spider_address);
+    grant_list.push_back(item);
+  });
 
-      //tdbctl use remote's user, password to connect remote do all
-      sprintf(create_sql, "CREATE USER IF NOT EXISTS '%s'@'%s' IDENTIFIED BY '%s';",
-              remote_user, tdbctl_host.c_str(), remote_passwd);
-      sprintf(grant_sql, "GRANT ALL PRIVILEGES ON *.* to '%s'@'%s' WITH GRANT OPTION;",
-              remote_user, tdbctl_host.c_str());
-      remote_do_sql += create_sql;
-      remote_do_sql += grant_sql;
-    });
+  //tdbctl use remote's user, password to connect remote do all
+  item.all_privileges = TRUE;
+  std::for_each(tdbctl_ipport_map.begin(), tdbctl_ipport_map.end(), [&](std::pair<string, string>tdbctl_ip_port)
+  {
+    item.host = tc_grant_host(tdbctl_ip_port.second);
+    grant_list.push_back(item);
   });
+}
+
+/*
+  read internal accounts of grant_list on node, return the state of every
+  account as user@host:password_hash:privileges
+
+  @NOTE:
+    privileges is ALL or DML if the account has all the privileges it should
+    have, otherwise '-'. password of non native password plugin can't be
+    verified, the expected hash is used.
 
-  return remote_do_sql;
+  @retval
+    FALSE ok
+    TRUE error, exec_info is set
+*/
+static bool tc_get_grant_state(
+  MYSQL *mysql,
+  map<string, TC_GRANT_ITEM> &grant_map,
+  map<string, string> &actual_map,
+  tc_exec_info *exec_info)
+{
+  string sql = "select User,Host,plugin,authentication_string,"
+    "Select_priv='Y' and Insert_priv='Y' and Update_priv='Y' and "
+    "Delete_priv='Y' and Drop_priv='Y' and Grant_priv='Y',"
+    "Select_priv='Y' and Insert_priv='Y' and Update_priv='Y' and "
+    "Delete_priv='Y' and Create_priv='Y' and Drop_priv='Y' and "
+    "Alter_priv='Y' and Index_priv='Y' and Super_priv='Y' and "
+    "Grant_priv='Y' from mysql.user where User in (";
+  set<string> user_set;
+  for (auto &grant : grant_map)
+    user_set.insert(grant.second.user);
+  for (auto &user : user_set)
+    sql += "'" + user + "',";
+  sql.erase(sql.end() - 1);
+  sql += ")";
+
+  MYSQL_RES *res = tc_exec_sql_with_result(mysql, sql);
+  MYSQL_RES_GUARD(res);
+  MYSQL_ROW row = NULL;
+  if (!res)
+  {
+    exec_info->err_code = mysql_errno(mysql);
+    exec_info->err_msg = mysql_error(mysql);
+    return TRUE;
+  }
+  actual_map.clear();
+  while ((row = mysql_fetch_row(res)))
+  {
+    string key = string(row[0]) + "@" + row[1];
+    if (!grant_map.count(key))
+      continue;
+    TC_GRANT_ITEM &item = grant_map[key];
+    string auth = row[3] ? row[3] : "";
+    if (!row[2] || strcmp(row[2], "mysql_native_password"))
+      auth = item.passwd_hash;
+    bool priv_ok = atoi(item.all_privileges ? row[5] : row[4]) == 1;
+    actual_map[key] = key + ":" + auth + ":" +
+      (priv_ok ? (item.all_privileges ? "ALL" : "DML") : "-");
+  }
+  return FALSE;
+}
+
+/* digest of grant state, for check whether node converged */
+static ha_checksum tc_grant_digest(map<string, string> &state_map)
+{
+  ha_checksum digest = 0;
+  for (auto &state : state_map)
+    digest = my_checksum(digest, (const uchar*)state.second.c_str(),
+      state.second.length());
+  return digest;
+}
+
+/*
+  do internal grants on one node, only grants missed or changed are sent
+
+  @param
+    prefix_sql: session setting executed before any grant
+    grant_list: accounts the node should have
+
+  @NOTE:
+    accounts are read from mysql.user and compared with grant_list,
+    CREATE USER/ALTER USER/GRANT are sent only for the difference, then
+    accounts are read again and the grant digest must equal the expected.
+    result is written to exec_info, err_code is 0 for success.
+*/
+void tc_do_grants_on_node(
+  MYSQL *mysql,
+  string prefix_sql,
+  vector<TC_GRANT_ITEM> *grant_list,
+  tc_exec_info *exec_info)
+{
+  map<string, TC_GRANT_ITEM> grant_map;
+  map<string, string> expected_map;
+  map<string, string> actual_map;
+  string delta_sql = "";
+  char hash[SCRAMBLED_PASSWORD_CHAR_LENGTH + 1];
+
+  exec_info->err_code = 0;
+  exec_info->err_msg = "";
+  exec_info->row_affect = 0;
+  if (!mysql)
+  {
+    exec_info->err_code = CR_CONNECTION_ERROR;
+    exec_info->err_msg = "connection is null";
+    return;
+  }
+
+  for (auto &item : *grant_list)
+  {
+    string key = item.user + "@" + item.host;
+    auto it = grant_map.find(key);
+    if (it != grant_map.end())
+    {/* same account for spider and tdbctl on one host, the stronger grant */
+      it->second.all_privileges = it->second.all_privileges || item.all_privileges;
+      continue;
+    }
+    my_make_scrambled_password_sha1(hash, item.passwd.c_str(), item.passwd.length());
+    item.passwd_hash = hash;
+    grant_map[key] = item;
+  }
+  if (grant_map.empty())
+    return;
+  for (auto &grant : grant_map)
+    expected_map[grant.first] = grant.first + ":" + grant.second.passwd_hash +
+      ":" + (grant.second.all_privileges ? "ALL" : "DML");
+
+  if ((!prefix_sql.empty() &&
+    tc_exec_sql_without_result(mysql, prefix_sql, exec_info)) ||
+    tc_get_grant_state(mysql, grant_map, actual_map, exec_info))
+    return;
+
+  for (auto &grant : grant_map)
+  {
+    TC_GRANT_ITEM &item = grant.second;
+    string account = "'" + item.user + "'@'" + item.host + "'";
+    auto actual = actual_map.find(grant.first);
+    if (actual == actual_map.end())
+      delta_sql += "CREATE USER IF NOT EXISTS " + account +
+        " IDENTIFIED BY '" + item.passwd + "';";
+    else if (actual->second == expected_map[grant.first])
+      continue;
+    else if (actual->second.find(":" + item.passwd_hash + ":") == string::npos)
+      delta_sql += "ALTER USER " + account + " IDENTIFIED BY '" + item.passwd + "';";
+    if (item.all_privileges)
+      delta_sql += "GRANT ALL PRIVILEGES ON *.* TO " + account + " WITH GRANT OPTION;";
+    else
+      delta_sql += "GRANT SELECT, INSERT, DELETE, UPDATE, DROP ON *.* TO " +
+        account + " WITH GRANT OPTION;";
+    exec_info->row_affect++;
+  }
+  if (delta_sql.empty())
+    return;
+
+  if (tc_exec_sql_without_result(mysql, delta_sql, exec_info) ||
+    tc_get_grant_state(mysql, grant_map, actual_map, exec_info))
+    return;
+  if (tc_grant_digest(actual_map) != tc_grant_digest(expected_map))
+  {
+    exec_info->err_code = ER_TCADMIN_INTERNAL_GRANT_ERROR;
+    exec_info->err_msg = "grants not converged after grant";
+  }
+}
+
+/*
+  do internal grants on nodes parallel
+
+  @param
+    grant_map: ipport-->grants the node should have
+
+  @retval
+    FALSE ok, TRUE error happened on some node, see result_map
+*/
+bool tc_do_grants_paral(
+  string prefix_sql,
+  map<string, MYSQL*> &conn_map,
+  map<string, vector<TC_GRANT_ITEM> > &grant_map,
+  map<string, tc_exec_info> &result_map)
+{
+  bool result = FALSE;
+  list<thread> thread_list;
+
+  for (auto &conn : conn_map)
+  {
+    string ipport = conn.first;
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_do_grants_on_node,
+      conn.second, prefix_sql, &grant_map[ipport], &result_map[ipport]));
+    thread_list.push_back(std::move(tmp_t));
+  }
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+
+  for (auto &conn : conn_map)
+  {
+    tc_exec_info &exec_info = result_map[conn.first];
+    if (exec_info.err_code > 0)
+      result = TRUE;
+    else if (exec_info.row_affect > 0)
+      sql_print_information("TDBCTL: internal grant %llu accounts on %s",
+        exec_info.row_affect, conn.first.c_str());
+  }
+  return result;
 }
 
 /*
@@ -3540,7 +4093,7 @@ map<string, MYSQL_RES*> tc_exec_sql_paral_by_wrapper(
   */
   for (auto & server: server_list)
   {
-    thread tmp_t([&]{
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, [&]{
       MYSQL* mysql;
       MYSQL_RES *res;
       string ipport = string(server->host) + "#" + to_string(server->port);
@@ -3554,7 +4107,7 @@ map<string, MYSQL_RES*> tc_exec_sql_paral_by_wrapper(
       MYSQL_GUARD(mysql);
       res = tc_exec_sql_with_result(mysql, exec_sql);
       result_map.insert(pair<string, MYSQL_RES *>(server->server_name, std::move(res)));
-    });
+    }));
     thread_list.push_back(std::move(tmp_t));
   }
 
@@ -9,9 +9,14 @@
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
 #include <sstream>
 #include <regex>
+#include <thread>
 #include "mysql.h"
+#include "mysql/psi/psi.h"
+#include "tc_latency.h"
+#include "tc_trace.h"
 using namespace std;
 
 //wrapper name map to mysql.servers's Wrapper field
@@ -66,6 +71,68 @@ bool tc_is_with_shard(THD *thd, LEX *lex);
 const char* get_stmt_type_str(int type);
 
 
+/*
+  performance_schema instrumentation of tdbctl
+
+  threads: thread/sql/tc_monitor, tc_xa_repair, tc_partition_admin,
+    tc_routing_repair, tc_table_stats, and tc_worker for threads calling
+    nodes parallel
+  statements: statement/tdbctl/connect, statement/tdbctl/query and
+    statement/tdbctl/execute for every call to a node, SQL_TEXT is the
+    query after a comment of the server name of the node, so that
+    events_statements_* tables show where a DDL or flush spends its time
+*/
+extern PSI_thread_key key_thread_tc_monitor, key_thread_tc_xa_repair,
+  key_thread_tc_partition_admin, key_thread_tc_routing_repair,
+  key_thread_tc_table_stats, key_thread_tc_worker;
+
+enum tc_psi_statement_type
+{
+  TC_PSI_STATEMENT_CONNECT = 0,
+  TC_PSI_STATEMENT_QUERY,
+  TC_PSI_STATEMENT_EXECUTE
+};
+
+/*
+  a call to node, also counted in the latency histograms of tc_latency.h
+  start_time: my_micro_time() when the call starts
+*/
+typedef struct tc_psi_statement
+{
+#ifdef HAVE_PSI_STATEMENT_INTERFACE
+  PSI_statement_locker_state state;
+#endif
+  PSI_statement_locker *locker;
+  tc_psi_statement_type type;
+  string ipport;
+  ulonglong start_time;
+} TC_PSI_STATEMENT;
+
+void init_tc_psi_keys();
+void *tc_psi_thread_init(PSI_thread_key key);
+void tc_psi_thread_end(void *psi);
+void tc_psi_statement_start(TC_PSI_STATEMENT *stmt, tc_psi_statement_type type,
+  const string &ipport, const char *sql, size_t length);
+void tc_psi_statement_end(TC_PSI_STATEMENT *stmt, MYSQL *mysql, bool error,
+  ulonglong rows_sent);
+string tc_mysql_ipport(MYSQL *mysql);
+
+/*
+  std::thread running f(args...), instrumented as key in performance_schema,
+  calls of the thread are counted as the operation of the creating thread
+*/
+template <class F, class... Args>
+std::thread tc_thread_create(PSI_thread_key key, F f, Args... args)
+{
+  tc_latency_op op = tc_latency_cur_op;
+  return std::thread([=]() mutable {
+    void *psi = tc_psi_thread_init(key);
+    tc_latency_cur_op = op;
+    f(args...);
+    tc_psi_thread_end(psi);
+  });
+}
+
 typedef struct tc_exec_info
 {
     uint err_code;
@@ -73,11 +140,26 @@ typedef struct tc_exec_info
     ulonglong row_affect;
 } TC_EXEC_INFO;
 
+/*
+  internal account a node should have
+  all_privileges: ALL PRIVILEGES if TRUE, otherwise DML privileges
+  passwd_hash: native password hash of passwd, filled when do grant
+*/
+typedef struct tc_grant_item
+{
+    string user;
+    string host;
+    string passwd;
+    string passwd_hash;
+    bool all_privileges;
+} TC_GRANT_ITEM;
+
 typedef struct tc_execute_result
 {
     bool result; // TURE, error happened; FALASE, SUCCEED
     map<string, tc_exec_info> spider_result_info;
     map<string, tc_exec_info> remote_result_info;
+    TC_TRACE_JOB_PTR trace; // timeline of tc_ddl_run, NULL if not traced
 } TC_EXEC_RESULT;
 
 typedef struct tc_parse_result
@@ -89,6 +171,7 @@ typedef struct tc_parse_result
     string new_table_name;
     string new_db_name;
     string shard_key;
+    enum_field_types shard_key_type;
     string result_info;
     bool is_with_shard;
     bool is_with_autu;
@@ -129,7 +212,8 @@ bool tc_parse_getkey_for_spider(
   char *result, 
   int buf_len, 
   bool *is_unique_key,
-  bool *is_unsigned_key
+  bool *is_unsigned_key,
+  enum_field_types *key_type
 );
 
 string tc_get_only_spider_ddl_withdb(
@@ -145,6 +229,8 @@ string tc_get_only_spider_ddl(
 string tcadmin_get_shard_range_by_index(
   int index, 
   int shard_count, 
+  longlong min_value,
+  ulonglong width,
   bool is_unsigned
 );
 
@@ -312,6 +398,23 @@ MYSQL* tc_conn_connect(
   string passwd
 );
 
+/*
+  deadline of read only fan-out, such as TDBCTL SHOW, TC_CLUSTER_* tables
+  and xa recover: a node which does not reply within tc_fanout_read_timeout
+  seconds is a straggler, its read fails with CR_SERVER_LOST so that the
+  fan-out returns the results of other nodes instead of waiting for it.
+*/
+ulonglong tc_fanout_deadline(ulong timeout);
+bool tc_fanout_deadline_passed(ulonglong deadline);
+MYSQL* tc_conn_connect_by_deadline(
+  string ipport,
+  string user,
+  string passwd,
+  ulonglong deadline
+);
+bool tc_conn_set_deadline(MYSQL *mysql, ulonglong deadline);
+void tc_conn_reset_deadline(MYSQL *mysql);
+
 map<string, MYSQL*> tc_remote_conn_connect(
   int &ret, 
   map<string, string> remote_ipport_map, 
@@ -392,6 +495,10 @@ bool tc_reconnect(string ipport,
 bool tc_exec_sql_up(MYSQL* mysql, string sql, tc_exec_info* exec_info);
 MYSQL_RES* tc_exec_sql_with_result(MYSQL* mysql, string sql);
 bool tc_exec_sql_without_result(MYSQL* mysql, string sql, tc_exec_info* exec_info);
+string tc_quote_name(const string &name);
+void tc_append_quoted_value(string &sql, const char *value, ulong length);
+string tc_row_greater_sql(const vector<string> &column_list,
+  const vector<string> &value_list);
 MYSQL_RES* tc_exec_sql_up_with_result(MYSQL* mysql, string sql, MYSQL_RES** res);
 MYSQL_RES* tc_exec_sql_with_result(MYSQL* mysql, string sql);
 bool tc_exec_sql_paral_with_result(
@@ -418,32 +525,39 @@ string tc_get_user_name(
 	const char* wrapper,
 	bool with_slave);
 
-string tc_get_spider_grant_sql(
-	set<string> &spider_ipport_set,
+void tc_get_spider_grant_list(
+	string spider_ipport,
 	map<string, string> &spider_user_map,
 	map<string, string> &spider_passwd_map,
 	map<string, string> &tdbctl_ipport_map,
-	map<string, string> &tdbctl_user_map,
-	map<string, string> &tdbctl_passwd_map);
+	vector<TC_GRANT_ITEM> &grant_list);
 
-string tc_get_tdbctl_grant_sql(
+void tc_get_tdbctl_grant_list(
 	set<string> &spider_ipport_set,
-	map<string, string> &spider_user_map,
-	map<string, string> &spider_passwd_map,
 	map<string, string> &tdbctl_ipport_map,
 	map<string, string> &tdbctl_user_map,
-	map<string, string> &tdbctl_passwd_map);
+	map<string, string> &tdbctl_passwd_map,
+	vector<TC_GRANT_ITEM> &grant_list);
 
-string tc_get_remote_grant_sql(
-	set<string> &spider_ipport_set,
-	map<string, string> &spider_user_map,
-	map<string, string> &spider_passwd_map,
-	map<string, string> &remote_ipport_map,
+void tc_get_remote_grant_list(
+	string remote_ipport,
 	map<string, string> &remote_user_map,
 	map<string, string> &remote_passwd_map,
+	set<string> &spider_ipport_set,
 	map<string, string> &tdbctl_ipport_map,
-	map<string, string> &tdbctl_user_map,
-	map<string, string> &tdbctl_passwd_map);
+	vector<TC_GRANT_ITEM> &grant_list);
+
+void tc_do_grants_on_node(
+	MYSQL *mysql,
+	string prefix_sql,
+	vector<TC_GRANT_ITEM> *grant_list,
+	tc_exec_info *exec_info);
+
+bool tc_do_grants_paral(
+	string prefix_sql,
+	map<string, MYSQL*> &conn_map,
+	map<string, vector<TC_GRANT_ITEM> > &grant_map,
+	map<string, tc_exec_info> &result_map);
 
 my_time_t string_to_timestamp(const string s);
 void init_result_map(map<string, tc_exec_info>& result_map, set<string> &ipport_set);
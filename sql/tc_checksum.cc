@@ -0,0 +1,618 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+/*
+  Cluster wide table checksum, see tc_checksum.h
+*/
+#include "sql_base.h"
+#include "sql_class.h"
+#include "tc_base.h"
+#include "log.h"
+#include "sql_servers.h"
+#include "protocol.h"
+#include "tc_checksum.h"
+#include <thread>
+#include <chrono>
+#include <set>
+
+/*
+  connect to node, bounds of chunk are got and sent as bytes
+
+  @retval
+    connection, NULL if error and err_msg is set
+*/
+static MYSQL *tc_checksum_connect(TC_CHECKSUM_NODE &node, string &err_msg)
+{
+  tc_exec_info exec_info;
+  MYSQL *mysql = tc_conn_connect(node.ipport, node.user, node.passwd);
+  if (!mysql)
+  {
+    err_msg = "connect failed";
+    return NULL;
+  }
+  if (tc_exec_sql_without_result(mysql, "SET NAMES binary", &exec_info))
+  {
+    err_msg = exec_info.err_msg;
+    mysql_close(mysql);
+    return NULL;
+  }
+  return mysql;
+}
+
+/*
+  hash rows of chunk by sql of SELECT COUNT(*), BIT_XOR(CRC32(row))
+
+  @retval
+    FALSE ok
+    TRUE error, err_msg is set
+*/
+static bool tc_checksum_chunk(MYSQL *mysql, const string &sql,
+  ulonglong *rows, ulonglong *crc, string &err_msg)
+{
+  MYSQL_RES *res = tc_exec_sql_with_result(mysql, sql);
+  MYSQL_RES_GUARD(res);
+  MYSQL_ROW row;
+  if (!res || !(row = mysql_fetch_row(res)))
+  {
+    err_msg = mysql_error(mysql);
+    return TRUE;
+  }
+  *rows = row[0] ? strtoull(row[0], NULL, 10) : 0;
+  *crc = row[1] ? strtoull(row[1], NULL, 10) : 0;
+  return FALSE;
+}
+
+/*
+  GTID executed on master, got with the table locked so that it
+  contains all changes of the table hashed under the same lock
+
+  @retval
+    FALSE ok
+    TRUE error, err_msg is set
+*/
+static bool tc_checksum_master_gtid(MYSQL *master, string &gtid,
+  string &err_msg)
+{
+  MYSQL_RES *res = tc_exec_sql_with_result(master, "SELECT @@GLOBAL.gtid_executed");
+  MYSQL_RES_GUARD(res);
+  MYSQL_ROW row;
+  gtid = "";
+  if (!res)
+  {
+    err_msg = mysql_error(master);
+    return TRUE;
+  }
+  if ((row = mysql_fetch_row(res)) && row[0])
+    gtid = row[0];
+  return FALSE;
+}
+
+/*
+  wait until slave executed the GTID of master, slave is hashed anyway
+  after TC_CHECKSUM_SLAVE_WAIT seconds
+
+  @retval
+    FALSE ok
+    TRUE error, err_msg is set
+*/
+static bool tc_checksum_wait_slave(MYSQL *slave, const string &gtid,
+  string &err_msg)
+{
+  if (gtid.empty())
+    return FALSE;
+
+  string sql = "SELECT WAIT_FOR_EXECUTED_GTID_SET(";
+  tc_append_quoted_value(sql, gtid.c_str(), gtid.length());
+  sql += ", " + to_string(TC_CHECKSUM_SLAVE_WAIT) + ")";
+  MYSQL_RES *res = tc_exec_sql_with_result(slave, sql);
+  MYSQL_RES_GUARD(res);
+  if (!res)
+  {
+    err_msg = mysql_error(slave);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/*
+  columns and primary key of the table on master, row_sql is the CRC32
+  of all columns
+
+  @retval
+    FALSE ok
+    TRUE error, err_msg is set
+*/
+static bool tc_checksum_get_columns(MYSQL *mysql, const string &db_name,
+  const string &tb_name, string &row_sql, vector<string> &pk_list,
+  string &err_msg)
+{
+  string where_sql = " WHERE TABLE_SCHEMA=";
+  string column_sql = "", null_sql = "";
+  tc_append_quoted_value(where_sql, db_name.c_str(), db_name.length());
+  where_sql += " AND TABLE_NAME=";
+  tc_append_quoted_value(where_sql, tb_name.c_str(), tb_name.length());
+  {
+    MYSQL_RES *res = tc_exec_sql_with_result(mysql,
+      "SELECT COLUMN_NAME FROM information_schema.COLUMNS" + where_sql +
+      " ORDER BY ORDINAL_POSITION");
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row;
+    if (!res)
+    {
+      err_msg = mysql_error(mysql);
+      return TRUE;
+    }
+    while ((row = mysql_fetch_row(res)))
+    {
+      string column = tc_quote_name(row[0]);
+      column_sql += "," + column;
+      null_sql += (null_sql.empty() ? "" : ",") + string("ISNULL(") + column + ")";
+    }
+  }
+  {
+    MYSQL_RES *res = tc_exec_sql_with_result(mysql,
+      "SELECT COLUMN_NAME FROM information_schema.KEY_COLUMN_USAGE" + where_sql +
+      " AND CONSTRAINT_NAME='PRIMARY' ORDER BY ORDINAL_POSITION");
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row;
+    if (!res)
+    {
+      err_msg = mysql_error(mysql);
+      return TRUE;
+    }
+    while ((row = mysql_fetch_row(res)))
+      pk_list.push_back(tc_quote_name(row[0]));
+  }
+  if (column_sql.empty())
+  {
+    err_msg = "table not exists";
+    return TRUE;
+  }
+  /* NULL is skipped by CONCAT_WS, so ISNULL of columns is hashed too */
+  row_sql = "CRC32(CONCAT_WS('#'" + column_sql + ",CONCAT(" + null_sql + ")))";
+  return FALSE;
+}
+
+/* bound of chunk as shown in result, quoted values separated by ',' */
+static string tc_checksum_bound_str(const vector<string> &bound)
+{
+  string str = "";
+  for (auto &value : bound)
+    str += (str.empty() ? "" : ",") + value;
+  return str;
+}
+
+/*
+  upper bounds of chunks, every chunk has chunk_size rows except the
+  last one which has no upper bound, a bound is the quoted values of
+  primary key columns
+
+  @retval
+    FALSE ok
+    TRUE error, err_msg is set
+*/
+static bool tc_checksum_get_bounds(MYSQL *mysql, const string &table,
+  const vector<string> &pk_list, const string &pk_sql, ulong chunk_size,
+  vector<vector<string>> &bound_list, string &err_msg)
+{
+  vector<string> last;
+  while (1)
+  {
+    string sql = "SELECT " + pk_sql + " FROM " + table;
+    if (!last.empty())
+      sql += " WHERE " + tc_row_greater_sql(pk_list, last);
+    sql += " ORDER BY " + pk_sql + " LIMIT " + to_string(chunk_size - 1) + ",1";
+    MYSQL_RES *res = tc_exec_sql_with_result(mysql, sql);
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row;
+    if (!res)
+    {
+      err_msg = mysql_error(mysql);
+      return TRUE;
+    }
+    if (!(row = mysql_fetch_row(res)))
+      return FALSE;
+    ulong *lengths = mysql_fetch_lengths(res);
+    last.assign(mysql_num_fields(res), "");
+    for (uint i = 0; i < mysql_num_fields(res); i++)
+      tc_append_quoted_value(last[i], row[i], lengths[i]);
+    bound_list.push_back(last);
+  }
+}
+
+/*
+  hash all chunks of one shard on master and compare with its slaves
+
+  @NOTE:
+    when compared with slaves, the table is locked on master while the
+    chunk is hashed on master and slaves, GTID of master is got under the
+    lock and slave waits for it, so no change of the table is on slave
+    but not on master or the reverse
+*/
+static void tc_checksum_shard(TC_CHECKSUM_POOL *pool, TC_CHECKSUM_SHARD *shard)
+{
+  string table = tc_quote_name(shard->db_name) + "." + tc_quote_name(pool->tb_name);
+  string row_sql, pk_sql = "";
+  vector<string> pk_list;
+  vector<vector<string>> bound_list;
+  vector<MYSQL*> slave_conns(shard->slave_list.size(), (MYSQL*)NULL);
+  MYSQL *master = tc_checksum_connect(shard->master, shard->error);
+  MYSQL_GUARD(master);
+  if (!master)
+    return;
+  if (tc_checksum_get_columns(master, shard->db_name, pool->tb_name, row_sql,
+    pk_list, shard->error))
+    return;
+  for (auto &pk : pk_list)
+    pk_sql += (pk_sql.empty() ? "" : ",") + pk;
+  /* table without primary key is hashed as one chunk */
+  if (!pk_list.empty() && tc_checksum_get_bounds(master, table, pk_list,
+    pk_sql, pool->chunk_size, bound_list, shard->error))
+    return;
+
+  if (pool->with_slave)
+  {
+    for (size_t i = 0; i < shard->slave_list.size(); i++)
+    {
+      string err_msg;
+      if (!(slave_conns[i] = tc_checksum_connect(shard->slave_list[i], err_msg)))
+        shard->slave_error_map[shard->slave_list[i].server_name] = err_msg;
+    }
+  }
+
+  shard->rows = 0;
+  shard->checksum = 0;
+  shard->chunks = bound_list.size() + 1;
+  for (size_t chunk = 0; chunk <= bound_list.size() && !pool->abort; chunk++)
+  {
+    vector<string> lower = chunk ? bound_list[chunk - 1] : vector<string>();
+    vector<string> upper = chunk < bound_list.size() ? bound_list[chunk] : vector<string>();
+    string sql = "SELECT COUNT(*), BIT_XOR(" + row_sql + ") FROM " + table;
+    string gtid = "";
+    ulonglong master_rows, master_crc;
+    bool locked = FALSE;
+    tc_exec_info exec_info;
+    if (!lower.empty())
+      sql += " WHERE " + tc_row_greater_sql(pk_list, lower);
+    if (!upper.empty())
+      sql += string(lower.empty() ? " WHERE" : " AND") + " NOT " +
+        tc_row_greater_sql(pk_list, upper);
+    for (auto conn : slave_conns)
+    {
+      if (conn)
+        locked = TRUE;
+    }
+    if (locked && tc_exec_sql_without_result(master, "LOCK TABLES " + table + " READ",
+      &exec_info))
+    {
+      shard->error = exec_info.err_msg;
+      break;
+    }
+    if ((locked && tc_checksum_master_gtid(master, gtid, shard->error)) ||
+      tc_checksum_chunk(master, sql, &master_rows, &master_crc, shard->error))
+      break;
+    shard->rows += master_rows;
+    shard->checksum ^= master_crc;
+
+    for (size_t i = 0; i < slave_conns.size(); i++)
+    {
+      TC_CHECKSUM_NODE &slave = shard->slave_list[i];
+      ulonglong slave_rows = 0, slave_crc = 0;
+      string err_msg;
+      if (!slave_conns[i])
+        continue;
+      if (tc_checksum_wait_slave(slave_conns[i], gtid, err_msg) ||
+        tc_checksum_chunk(slave_conns[i], sql, &slave_rows, &slave_crc, err_msg))
+      {
+        shard->slave_error_map[slave.server_name] = err_msg;
+        mysql_close(slave_conns[i]);
+        slave_conns[i] = NULL;
+      }
+      else if (master_rows != slave_rows || master_crc != slave_crc)
+      {
+        TC_CHECKSUM_DIFF diff;
+        diff.slave_name = slave.server_name;
+        diff.chunk = chunk;
+        diff.lower = tc_checksum_bound_str(lower);
+        diff.upper = tc_checksum_bound_str(upper);
+        diff.master_rows = master_rows;
+        diff.master_crc = master_crc;
+        diff.slave_rows = slave_rows;
+        diff.slave_crc = slave_crc;
+        shard->diff_list.push_back(diff);
+      }
+    }
+    if (locked && tc_exec_sql_without_result(master, "UNLOCK TABLES", &exec_info))
+    {
+      shard->error = exec_info.err_msg;
+      break;
+    }
+  }
+
+  for (auto conn : slave_conns)
+  {
+    if (conn)
+      mysql_close(conn);
+  }
+}
+
+/* hosts used to check the shard */
+static set<string> tc_checksum_hosts(TC_CHECKSUM_POOL *pool,
+  TC_CHECKSUM_SHARD *shard)
+{
+  set<string> host_set;
+  host_set.insert(shard->master.ipport.substr(0, shard->master.ipport.find('#')));
+  if (pool->with_slave)
+  {
+    for (auto &slave : shard->slave_list)
+      host_set.insert(slave.ipport.substr(0, slave.ipport.find('#')));
+  }
+  return host_set;
+}
+
+/*
+  checksum worker, takes the first pending shard whose hosts are all used
+  by less than tc_checksum_host_threads workers
+*/
+static void tc_checksum_worker(TC_CHECKSUM_POOL *pool)
+{
+  while (1)
+  {
+    TC_CHECKSUM_SHARD *shard = NULL;
+    set<string> host_set;
+    {
+      std::unique_lock<std::mutex> lock(pool->mtx);
+      while (1)
+      {
+        list<TC_CHECKSUM_SHARD*>::iterator its;
+        for (its = pool->pending_list.begin(); its != pool->pending_list.end(); its++)
+        {
+          bool host_free = true;
+          host_set = tc_checksum_hosts(pool, *its);
+          for (auto &host : host_set)
+            host_free = host_free && pool->host_active_map[host] < tc_checksum_host_threads;
+          if (host_free)
+          {
+            shard = *its;
+            pool->pending_list.erase(its);
+            break;
+          }
+        }
+        if (shard || pool->pending_list.empty())
+          break;
+        pool->cond.wait_for(lock, std::chrono::seconds(1));
+      }
+      if (!shard)
+        return;
+      for (auto &host : host_set)
+        pool->host_active_map[host]++;
+    }
+
+    if (!pool->abort)
+      tc_checksum_shard(pool, shard);
+
+    {
+      std::lock_guard<std::mutex> lock(pool->mtx);
+      for (auto &host : host_set)
+        pool->host_active_map[host]--;
+      pool->cond.notify_all();
+    }
+  }
+}
+
+/* shard index of server name SPT<n> or slave name ending with <n>, -1 if none */
+static long tc_checksum_shard_index(const string &server_name)
+{
+  size_t pos = server_name.find_last_not_of("0123456789");
+  pos = (pos == string::npos ? 0 : pos + 1);
+  if (pos == server_name.length())
+    return -1;
+  return atol(server_name.c_str() + pos);
+}
+
+/*
+  TDBCTL CHECKSUM TABLE db.table [WITH SLAVES]
+
+  @retval
+    FALSE ok
+    TRUE error, my_error is set
+*/
+bool tc_checksum_table(THD *thd, LEX_STRING db, LEX_STRING table, bool with_slave)
+{
+  MEM_ROOT mem_root;
+  list<FOREIGN_SERVER*> remote_list;
+  list<FOREIGN_SERVER*> slave_list;
+  map<long, TC_CHECKSUM_SHARD> shard_map;
+  TC_CHECKSUM_POOL pool;
+  list<thread> thread_list;
+  List<Item> field_list;
+  Item *field;
+  Protocol *protocol = thd->get_protocol();
+  string db_name = (db.str ? string(db.str, db.length) :
+    (thd->db().str ? thd->db().str : ""));
+  size_t prefix_len = strlen(tdbctl_mysql_wrapper_prefix);
+  ulong threads;
+  DBUG_ENTER("tc_checksum_table");
+
+  if (db_name.empty())
+  {
+    my_error(ER_NO_DB_ERROR, MYF(0));
+    DBUG_RETURN(TRUE);
+  }
+
+  init_sql_alloc(key_memory_for_tdbctl, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+  MEM_ROOT_GUARD(mem_root);
+  get_server_by_wrapper(remote_list, &mem_root, MYSQL_WRAPPER, FALSE);
+  if (with_slave)
+    get_server_by_wrapper(slave_list, &mem_root, MYSQL_SLAVE_WRAPPER, FALSE);
+  for (auto &server : remote_list)
+  {
+    long index = tc_checksum_shard_index(server->server_name);
+    TC_CHECKSUM_SHARD &shard = shard_map[index];
+    shard.master.server_name = server->server_name;
+    shard.master.ipport = string(server->host) + "#" + to_string(server->port);
+    shard.master.user = server->username;
+    shard.master.passwd = server->password;
+    shard.db_name = db_name + "_" + shard.master.server_name.substr(prefix_len);
+    shard.rows = 0;
+    shard.checksum = 0;
+    shard.chunks = 0;
+  }
+  for (auto &server : slave_list)
+  {
+    auto it = shard_map.find(tc_checksum_shard_index(server->server_name));
+    if (it == shard_map.end())
+      continue;
+    TC_CHECKSUM_NODE node;
+    node.server_name = server->server_name;
+    node.ipport = string(server->host) + "#" + to_string(server->port);
+    node.user = server->username;
+    node.passwd = server->password;
+    it->second.slave_list.push_back(node);
+  }
+  if (shard_map.empty())
+  {
+    my_error(ER_TCADMIN_NO_REMOTE_DB_FOUND, MYF(0), "No Remote DB has been found");
+    DBUG_RETURN(TRUE);
+  }
+
+  pool.tb_name = string(table.str, table.length);
+  pool.with_slave = with_slave;
+  pool.chunk_size = tc_checksum_chunk_size;
+  pool.abort = false;
+  for (auto &it : shard_map)
+    pool.pending_list.push_back(&it.second);
+  threads = min((ulong)shard_map.size(), tc_checksum_threads);
+  for (ulong i = 0; i < threads; i++)
+  {
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_checksum_worker, &pool));
+    thread_list.push_back(std::move(tmp_t));
+  }
+  /* workers stop taking shards when the statement is killed */
+  while (1)
+  {
+    {
+      std::lock_guard<std::mutex> lock(pool.mtx);
+      bool active = !pool.pending_list.empty();
+      for (auto &host : pool.host_active_map)
+        active = active || host.second > 0;
+      if (!active)
+        break;
+    }
+    if (thd->killed)
+      pool.abort = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+  if (thd->killed)
+  {
+    thd->send_kill_message();
+    DBUG_RETURN(TRUE);
+  }
+
+  field_list.push_back(new Item_empty_string("Server_name", NAME_CHAR_LEN));
+  field_list.push_back(field = new Item_empty_string("Slave_name", NAME_CHAR_LEN));
+  field->maybe_null = 1;
+  field_list.push_back(field = new Item_int(NAME_STRING("Chunk"), 0,
+    MY_INT64_NUM_DECIMAL_DIGITS));
+  field->maybe_null = 1;
+  field_list.push_back(field = new Item_empty_string("Lower_bound", 1024));
+  field->maybe_null = 1;
+  field_list.push_back(field = new Item_empty_string("Upper_bound", 1024));
+  field->maybe_null = 1;
+  field_list.push_back(field = new Item_int(NAME_STRING("Rows"), 0,
+    MY_INT64_NUM_DECIMAL_DIGITS));
+  field->maybe_null = 1;
+  field_list.push_back(field = new Item_int(NAME_STRING("Checksum"), 0,
+    MY_INT64_NUM_DECIMAL_DIGITS));
+  field->maybe_null = 1;
+  field_list.push_back(field = new Item_int(NAME_STRING("Slave_rows"), 0,
+    MY_INT64_NUM_DECIMAL_DIGITS));
+  field->maybe_null = 1;
+  field_list.push_back(field = new Item_int(NAME_STRING("Slave_checksum"), 0,
+    MY_INT64_NUM_DECIMAL_DIGITS));
+  field->maybe_null = 1;
+  field_list.push_back(new Item_empty_string("Status", 1024));
+  if (thd->send_result_metadata(&field_list,
+    Protocol::SEND_NUM_ROWS | Protocol::SEND_EOF))
+    DBUG_RETURN(TRUE);
+
+  for (auto &it : shard_map)
+  {
+    TC_CHECKSUM_SHARD &shard = it.second;
+    /* the shard on master */
+    protocol->start_row();
+    protocol->store(shard.master.server_name.c_str(), system_charset_info);
+    protocol->store_null();
+    protocol->store(shard.chunks);
+    protocol->store_null();
+    protocol->store_null();
+    protocol->store(shard.rows);
+    protocol->store(shard.checksum);
+    protocol->store_null();
+    protocol->store_null();
+    protocol->store(shard.error.empty() ? "OK" : shard.error.c_str(),
+      system_charset_info);
+    if (protocol->end_row())
+      DBUG_RETURN(TRUE);
+
+    /* slaves of the shard, then chunks differ */
+    for (auto &slave : shard.slave_list)
+    {
+      ulonglong diff_count = 0;
+      string status;
+      if (!shard.error.empty())
+        continue;
+      for (auto &diff : shard.diff_list)
+        diff_count += (diff.slave_name == slave.server_name);
+      if (shard.slave_error_map.count(slave.server_name))
+        status = shard.slave_error_map[slave.server_name];
+      else if (diff_count)
+        status = "DIFF " + to_string(diff_count) + " chunks";
+      else
+        status = "OK";
+      protocol->start_row();
+      protocol->store(shard.master.server_name.c_str(), system_charset_info);
+      protocol->store(slave.server_name.c_str(), system_charset_info);
+      protocol->store_null();
+      protocol->store_null();
+      protocol->store_null();
+      protocol->store_null();
+      protocol->store_null();
+      protocol->store_null();
+      protocol->store_null();
+      protocol->store(status.c_str(), system_charset_info);
+      if (protocol->end_row())
+        DBUG_RETURN(TRUE);
+    }
+    for (auto &diff : shard.diff_list)
+    {
+      protocol->start_row();
+      protocol->store(shard.master.server_name.c_str(), system_charset_info);
+      protocol->store(diff.slave_name.c_str(), system_charset_info);
+      protocol->store(diff.chunk);
+      if (diff.lower.empty())
+        protocol->store_null();
+      else
+        protocol->store(diff.lower.c_str(), diff.lower.length(), &my_charset_bin);
+      if (diff.upper.empty())
+        protocol->store_null();
+      else
+        protocol->store(diff.upper.c_str(), diff.upper.length(), &my_charset_bin);
+      protocol->store(diff.master_rows);
+      protocol->store(diff.master_crc);
+      protocol->store(diff.slave_rows);
+      protocol->store(diff.slave_crc);
+      protocol->store("DIFF", system_charset_info);
+      if (protocol->end_row())
+        DBUG_RETURN(TRUE);
+    }
+  }
+  my_eof(thd);
+  DBUG_RETURN(FALSE);
+}
@@ -0,0 +1,99 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+#ifndef TC_CHECKSUM_INCLUDED
+#define TC_CHECKSUM_INCLUDED
+
+/*
+  TDBCTL CHECKSUM TABLE db.table [WITH SLAVES]
+
+  the table on every shard is split into primary key chunks of
+  tc_checksum_chunk_size rows, every chunk is hashed by BIT_XOR of CRC32
+  of its rows. Shards are checked parallel by at most tc_checksum_threads
+  workers, and at most tc_checksum_host_threads of them use the same host.
+
+  WITH SLAVES compares every chunk of the shard with the mysql_slave
+  servers of the shard, the slave of shard N is the mysql_slave server
+  whose name ends with N. The table is locked on master while a chunk is
+  hashed on master and slaves, and slave waits for the GTID executed on
+  master under the lock before its chunk is hashed.
+*/
+
+#include "my_global.h"
+#include "m_string.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+using namespace std;
+
+/* seconds slave waits for the GTID of master before a chunk is hashed */
+#define TC_CHECKSUM_SLAVE_WAIT 10
+
+class THD;
+
+typedef struct tc_checksum_node
+{
+  string server_name;
+  string ipport;
+  string user;
+  string passwd;
+} TC_CHECKSUM_NODE;
+
+/* a chunk differs between master and slave, bounds are (lower, upper] */
+typedef struct tc_checksum_diff
+{
+  string slave_name;
+  ulonglong chunk;
+  string lower;
+  string upper;
+  ulonglong master_rows;
+  ulonglong master_crc;
+  ulonglong slave_rows;
+  ulonglong slave_crc;
+} TC_CHECKSUM_DIFF;
+
+/*
+  one shard to check
+  db_name: database of the table on the shard
+  rows/checksum/chunks: of the table on master
+  error: error of master, the shard is not checked
+  slave_error_map: slave name-->error, the slave is not compared
+*/
+typedef struct tc_checksum_shard
+{
+  TC_CHECKSUM_NODE master;
+  vector<TC_CHECKSUM_NODE> slave_list;
+  string db_name;
+  ulonglong rows;
+  ulonglong checksum;
+  ulonglong chunks;
+  vector<TC_CHECKSUM_DIFF> diff_list;
+  string error;
+  map<string, string> slave_error_map;
+} TC_CHECKSUM_SHARD;
+
+/*
+  work shared by the checksum workers
+  pending_list: shards not checked yet
+  host_active_map: ip-->count of workers using the host
+*/
+typedef struct tc_checksum_pool
+{
+  string tb_name;
+  bool with_slave;
+  ulong chunk_size;
+  list<TC_CHECKSUM_SHARD*> pending_list;
+  map<string, ulong> host_active_map;
+  std::atomic<bool> abort;
+  std::mutex mtx;
+  std::condition_variable cond;
+} TC_CHECKSUM_POOL;
+
+bool tc_checksum_table(THD *thd, LEX_STRING db, LEX_STRING table, bool with_slave);
+
+#endif /* TC_CHECKSUM_INCLUDED */
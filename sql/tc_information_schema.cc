@@ -0,0 +1,583 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+/*
+  Cluster INFORMATION_SCHEMA tables of tdbctl
+*/
+
+#include "tc_information_schema.h"
+#include "sql_class.h"
+#include "sql_show.h"
+#include "sql_servers.h"
+#include "item_cmpfunc.h"
+#include "auth_common.h"
+#include "tc_base.h"
+#include "tc_latency.h"
+#include "tc_trace.h"
+#include "mysql.h"
+#include <thread>
+#include <list>
+#include <vector>
+#include <string>
+
+using namespace std;
+
+ST_FIELD_INFO tc_cluster_processlist_fields_info[]=
+{
+  {"SERVER_NAME", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"ID", 21, MYSQL_TYPE_LONGLONG, 0, MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+  {"USER", USERNAME_CHAR_LENGTH, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"HOST", LIST_PROCESS_HOST_LEN, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"DB", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 1, 0, SKIP_OPEN_TABLE},
+  {"COMMAND", 16, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"TIME", 7, MYSQL_TYPE_LONG, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"STATE", 64, MYSQL_TYPE_STRING, 0, 1, 0, SKIP_OPEN_TABLE},
+  {"INFO", PROCESS_LIST_INFO_WIDTH, MYSQL_TYPE_STRING, 0, 1, 0, SKIP_OPEN_TABLE},
+  {0, 0, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE}
+};
+
+ST_FIELD_INFO tc_cluster_global_status_fields_info[]=
+{
+  {"SERVER_NAME", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"VARIABLE_NAME", 64, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"VARIABLE_VALUE", 1024, MYSQL_TYPE_STRING, 0, 1, 0, SKIP_OPEN_TABLE},
+  {0, 0, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE}
+};
+
+ST_FIELD_INFO tc_cluster_tables_fields_info[]=
+{
+  {"SERVER_NAME", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"TABLE_SCHEMA", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"TABLE_NAME", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"TABLE_TYPE", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"ENGINE", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 1, 0, SKIP_OPEN_TABLE},
+  {"TABLE_ROWS", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   (MY_I_S_MAYBE_NULL | MY_I_S_UNSIGNED), 0, SKIP_OPEN_TABLE},
+  {"AVG_ROW_LENGTH", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   (MY_I_S_MAYBE_NULL | MY_I_S_UNSIGNED), 0, SKIP_OPEN_TABLE},
+  {"DATA_LENGTH", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   (MY_I_S_MAYBE_NULL | MY_I_S_UNSIGNED), 0, SKIP_OPEN_TABLE},
+  {"INDEX_LENGTH", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   (MY_I_S_MAYBE_NULL | MY_I_S_UNSIGNED), 0, SKIP_OPEN_TABLE},
+  {"DATA_FREE", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   (MY_I_S_MAYBE_NULL | MY_I_S_UNSIGNED), 0, SKIP_OPEN_TABLE},
+  {"AUTO_INCREMENT", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   (MY_I_S_MAYBE_NULL | MY_I_S_UNSIGNED), 0, SKIP_OPEN_TABLE},
+  {"CREATE_TIME", 0, MYSQL_TYPE_DATETIME, 0, 1, 0, SKIP_OPEN_TABLE},
+  {"UPDATE_TIME", 0, MYSQL_TYPE_DATETIME, 0, 1, 0, SKIP_OPEN_TABLE},
+  {0, 0, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE}
+};
+
+ST_FIELD_INFO tc_cluster_innodb_trx_fields_info[]=
+{
+  {"SERVER_NAME", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"TRX_ID", 18, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"TRX_STATE", 13, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"TRX_STARTED", 0, MYSQL_TYPE_DATETIME, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"TRX_WAIT_STARTED", 0, MYSQL_TYPE_DATETIME, 0, 1, 0, SKIP_OPEN_TABLE},
+  {"TRX_MYSQL_THREAD_ID", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+  {"TRX_QUERY", 1024, MYSQL_TYPE_STRING, 0, 1, 0, SKIP_OPEN_TABLE},
+  {"TRX_OPERATION_STATE", 64, MYSQL_TYPE_STRING, 0, 1, 0, SKIP_OPEN_TABLE},
+  {"TRX_TABLES_LOCKED", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+  {"TRX_ROWS_LOCKED", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+  {"TRX_ROWS_MODIFIED", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+  {"TRX_ISOLATION_LEVEL", 16, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {0, 0, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE}
+};
+
+ST_FIELD_INFO tc_node_latency_fields_info[]=
+{
+  {"SERVER_NAME", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"HOST", LIST_PROCESS_HOST_LEN, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"OPERATION", 16, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"TIME", TC_LATENCY_TIME_LENGTH, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"COUNT", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+  {"TOTAL", TC_LATENCY_TOTAL_LENGTH, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {0, 0, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE}
+};
+
+ST_FIELD_INFO tc_ddl_trace_fields_info[]=
+{
+  {"JOB_ID", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+  {"THREAD_ID", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0,
+   MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+  {"DB", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"QUERY", TC_TRACE_QUERY_LENGTH, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"STATE", 16, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"DURATION", TC_LATENCY_TIME_LENGTH, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE},
+  {"NODES", 21, MYSQL_TYPE_LONGLONG, 0, MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+  {"FAILED_NODES", 21, MYSQL_TYPE_LONGLONG, 0, MY_I_S_UNSIGNED, 0, SKIP_OPEN_TABLE},
+  {"SLOWEST_NODE", NAME_CHAR_LEN, MYSQL_TYPE_STRING, 0, 1, 0, SKIP_OPEN_TABLE},
+  {"SLOWEST_TIME", TC_LATENCY_TIME_LENGTH, MYSQL_TYPE_STRING, 0, 1, 0,
+   SKIP_OPEN_TABLE},
+  {"TRACE", MAX_FIELD_BLOBLENGTH, MYSQL_TYPE_LONG_BLOB, 0, 0, 0, SKIP_OPEN_TABLE},
+  {0, 0, MYSQL_TYPE_STRING, 0, 0, 0, SKIP_OPEN_TABLE}
+};
+
+/*
+  column on node of every field, NULL for SERVER_NAME
+  query on node must return the columns in the same order
+*/
+static const char *tc_cluster_processlist_columns[]=
+{ NULL, "ID", "USER", "HOST", "DB", "COMMAND", "TIME", "STATE", "INFO" };
+
+static const char *tc_cluster_global_status_columns[]=
+{ NULL, "Variable_name", "Value" };
+
+static const char *tc_cluster_tables_columns[]=
+{ NULL, "TABLE_SCHEMA", "TABLE_NAME", "TABLE_TYPE", "ENGINE", "TABLE_ROWS",
+  "AVG_ROW_LENGTH", "DATA_LENGTH", "INDEX_LENGTH", "DATA_FREE",
+  "AUTO_INCREMENT", "CREATE_TIME", "UPDATE_TIME" };
+
+static const char *tc_cluster_innodb_trx_columns[]=
+{ NULL, "trx_id", "trx_state", "trx_started", "trx_wait_started",
+  "trx_mysql_thread_id", "trx_query", "trx_operation_state",
+  "trx_tables_locked", "trx_rows_locked", "trx_rows_modified",
+  "trx_isolation_level" };
+
+/* the result of one node */
+typedef struct tc_cluster_node
+{
+  string server_name;
+  string ipport;
+  string user;
+  string passwd;
+  MYSQL_RES *res;
+  string error;
+  bool straggler;
+} TC_CLUSTER_NODE;
+
+/*
+  get condition can be pushed down to node from one predicate
+
+  @NOTE:
+    only "field op constant" is supported, op is one of =,<>,<,<=,>,>=,LIKE.
+    SERVER_NAME = constant is not pushed down, it limits the nodes to fetch.
+
+  @retval
+    FALSE ok, node_cond is set or empty for not pushable
+    TRUE predicate filters all nodes out
+*/
+static bool tc_cluster_push_predicate(
+  Item *item,
+  TABLE *table,
+  const char **node_columns,
+  string &node_cond,
+  string &server_name)
+{
+  Item_func *func;
+  Item_field *field;
+  String tmp, *value;
+  const char *op;
+  char *escaped;
+  size_t escaped_len;
+
+  node_cond = "";
+  if (item->type() != Item::FUNC_ITEM)
+    return FALSE;
+  func = (Item_func*)item;
+  switch (func->functype())
+  {
+  case Item_func::EQ_FUNC: op = "="; break;
+  case Item_func::NE_FUNC: op = "<>"; break;
+  case Item_func::LT_FUNC: op = "<"; break;
+  case Item_func::LE_FUNC: op = "<="; break;
+  case Item_func::GT_FUNC: op = ">"; break;
+  case Item_func::GE_FUNC: op = ">="; break;
+  case Item_func::LIKE_FUNC:
+    if (((Item_func_like*)func)->escape_was_used_in_parsing())
+      return FALSE;
+    op = "like";
+    break;
+  default:
+    return FALSE;
+  }
+
+  if (func->argument_count() != 2 ||
+    func->arguments()[0]->type() != Item::FIELD_ITEM ||
+    !func->arguments()[1]->basic_const_item())
+    return FALSE;
+  field = (Item_field*)func->arguments()[0];
+  if (!field->field || field->field->table != table)
+    return FALSE;
+  if (!(value = func->arguments()[1]->val_str(&tmp)))
+    return FALSE;
+
+  if (field->field->field_index == 0)
+  {/* SERVER_NAME, compared as the column: case and trailing spaces ignored */
+    string name(value->ptr(), value->length());
+    if (func->functype() != Item_func::EQ_FUNC)
+      return FALSE;
+    name.erase(name.find_last_not_of(' ') + 1);
+    if (!server_name.empty() &&
+      my_strcasecmp(system_charset_info, server_name.c_str(), name.c_str()))
+      return TRUE;
+    server_name = name;
+    return FALSE;
+  }
+
+  escaped = (char*)sql_alloc(value->length() * 2 + 1);
+  if (!escaped)
+    return FALSE;
+  escaped_len = escape_string_for_mysql(system_charset_info, escaped,
+    value->length() * 2 + 1, value->ptr(), value->length());
+  if (escaped_len == (size_t)-1)
+    return FALSE;
+  node_cond = string("`") + node_columns[field->field->field_index] + "` " +
+    op + " '" + string(escaped, escaped_len) + "'";
+  return FALSE;
+}
+
+/*
+  get WHERE for query on node from condition of the table
+
+  @NOTE:
+    the condition is split by AND, predicates can't be pushed down
+    are skipped. rows are still filtered by the whole condition after
+    filled, so push down only reduces rows fetched from nodes.
+
+  @retval
+    FALSE ok
+    TRUE condition filters all nodes out
+*/
+static bool tc_cluster_push_cond(
+  Item *cond,
+  TABLE *table,
+  const char **node_columns,
+  string &where,
+  string &server_name)
+{
+  list<Item*> item_list;
+  where = "";
+  server_name = "";
+  if (!cond)
+    return FALSE;
+
+  if (cond->type() == Item::COND_ITEM &&
+    ((Item_cond*)cond)->functype() == Item_func::COND_AND_FUNC)
+  {
+    List_iterator<Item> li(*((Item_cond*)cond)->argument_list());
+    Item *item;
+    while ((item = li++))
+      item_list.push_back(item);
+  }
+  else
+    item_list.push_back(cond);
+
+  for (auto item : item_list)
+  {
+    string node_cond;
+    if (tc_cluster_push_predicate(item, table, node_columns, node_cond,
+      server_name))
+      return TRUE;
+    if (node_cond.empty())
+      continue;
+    where += (where.empty() ? " where " : " and ") + node_cond;
+  }
+  return FALSE;
+}
+
+/*
+  fill cluster INFORMATION_SCHEMA table
+
+  @param
+    query: query executed on every node, WHERE pushed down is appended
+    node_columns: column on node of every field
+
+  @NOTE:
+    one thread for every node do connect and query, node failed is
+    reported as warning, node not replied within tc_fanout_read_timeout
+    is reported as straggler and its rows are not returned.
+*/
+static int tc_fill_cluster_table(
+  THD *thd,
+  TABLE_LIST *tables,
+  Item *cond,
+  string query,
+  const char **node_columns)
+{
+  TABLE *table = tables->table;
+  MEM_ROOT mem_root;
+  list<FOREIGN_SERVER*> server_list;
+  vector<TC_CLUSTER_NODE> node_list;
+  list<thread> thread_list;
+  string where, server_name;
+  int ret = 0;
+  ulong timeout = thd->variables.tc_fanout_read_timeout;
+  ulonglong deadline;
+  DBUG_ENTER("tc_fill_cluster_table");
+
+  if (check_global_access(thd, PROCESS_ACL))
+    DBUG_RETURN(1);
+  if (tc_cluster_push_cond(cond, table, node_columns, where, server_name))
+    DBUG_RETURN(0);
+  query += where;
+
+  init_sql_alloc(key_memory_for_tdbctl, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+  MEM_ROOT_GUARD(mem_root);
+  get_server_by_wrapper(server_list, &mem_root, NULL_WRAPPER, TRUE);
+  for (auto &server : server_list)
+  {
+    TC_CLUSTER_NODE node;
+    if (!server_name.empty() &&
+      my_strcasecmp(system_charset_info, server_name.c_str(), server->server_name))
+      continue;
+    node.server_name = server->server_name;
+    node.ipport = string(server->host) + "#" + to_string(server->port);
+    node.user = server->username;
+    node.passwd = server->password;
+    node.res = NULL;
+    node.straggler = FALSE;
+    node_list.push_back(node);
+  }
+
+  deadline = tc_fanout_deadline(timeout);
+  for (auto &node : node_list)
+  {
+    TC_CLUSTER_NODE *p_node = &node;
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, [p_node, query, deadline] {
+      MYSQL *mysql = tc_conn_connect_by_deadline(p_node->ipport, p_node->user,
+        p_node->passwd, deadline);
+      MYSQL_GUARD(mysql);
+      if (!mysql)
+        p_node->error = "failed to connect to " + p_node->ipport;
+      else if (tc_conn_set_deadline(mysql, deadline))
+        p_node->error = "no time left to query";
+      else if (!(p_node->res = tc_exec_sql_with_result(mysql, query)))
+        p_node->error = mysql_error(mysql);
+      p_node->straggler = !p_node->error.empty() &&
+        tc_fanout_deadline_passed(deadline);
+    }));
+    thread_list.push_back(std::move(tmp_t));
+  }
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+
+  for (auto &node : node_list)
+  {
+    MYSQL_RES *res = node.res;
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row;
+    if (node.straggler)
+    {
+      push_warning_printf(thd, Sql_condition::SL_WARNING, ER_TCADMIN_EXECUTE_ERROR,
+        "%s: straggler, no reply within tc_fanout_read_timeout(%lu) seconds: %s",
+        node.server_name.c_str(), timeout, node.error.c_str());
+      continue;
+    }
+    if (!node.error.empty())
+    {
+      push_warning_printf(thd, Sql_condition::SL_WARNING, ER_TCADMIN_EXECUTE_ERROR,
+        "%s: %s", node.server_name.c_str(), node.error.c_str());
+      continue;
+    }
+    while (!ret && res && (row = mysql_fetch_row(res)))
+    {
+      ulong *lengths = mysql_fetch_lengths(res);
+      uint num_fields = min<uint>(mysql_num_fields(res), table->s->fields - 1);
+      restore_record(table, s->default_values);
+      table->field[0]->store(node.server_name.c_str(),
+        node.server_name.length(), system_charset_info);
+      for (uint i = 0; i < num_fields; i++)
+      {
+        Field *field = table->field[i + 1];
+        if (row[i] == NULL)
+        {
+          field->set_null();
+          continue;
+        }
+        field->set_notnull();
+        field->store(row[i], lengths[i], system_charset_info);
+      }
+      if (schema_table_store_record(thd, table))
+        ret = 1;
+    }
+  }
+
+  DBUG_RETURN(ret);
+}
+
+int tc_fill_cluster_processlist(THD *thd, TABLE_LIST *tables, Item *cond)
+{
+  return tc_fill_cluster_table(thd, tables, cond,
+    "select ID,USER,HOST,DB,COMMAND,TIME,STATE,INFO "
+    "from information_schema.PROCESSLIST", tc_cluster_processlist_columns);
+}
+
+int tc_fill_cluster_global_status(THD *thd, TABLE_LIST *tables, Item *cond)
+{
+  return tc_fill_cluster_table(thd, tables, cond,
+    "show global status", tc_cluster_global_status_columns);
+}
+
+int tc_fill_cluster_tables(THD *thd, TABLE_LIST *tables, Item *cond)
+{
+  return tc_fill_cluster_table(thd, tables, cond,
+    "select TABLE_SCHEMA,TABLE_NAME,TABLE_TYPE,ENGINE,TABLE_ROWS,"
+    "AVG_ROW_LENGTH,DATA_LENGTH,INDEX_LENGTH,DATA_FREE,AUTO_INCREMENT,"
+    "CREATE_TIME,UPDATE_TIME from information_schema.TABLES",
+    tc_cluster_tables_columns);
+}
+
+int tc_fill_cluster_innodb_trx(THD *thd, TABLE_LIST *tables, Item *cond)
+{
+  return tc_fill_cluster_table(thd, tables, cond,
+    "select trx_id,trx_state,trx_started,trx_wait_started,"
+    "trx_mysql_thread_id,trx_query,trx_operation_state,trx_tables_locked,"
+    "trx_rows_locked,trx_rows_modified,trx_isolation_level "
+    "from information_schema.INNODB_TRX", tc_cluster_innodb_trx_columns);
+}
+
+/* time in microseconds as seconds, right aligned as in QUERY_RESPONSE_TIME */
+static string tc_format_seconds(ulonglong time)
+{
+  char buf[TC_LATENCY_TIME_LENGTH + 1];
+  my_snprintf(buf, sizeof(buf), "%7llu.%06llu", time / 1000000, time % 1000000);
+  return buf;
+}
+
+/*
+  fill TC_NODE_LATENCY from the latency histograms of this tdbctl, one row
+  for every non empty bucket. TIME is the upper bound of the bucket and
+  TOTAL the sum of call time in seconds, as in QUERY_RESPONSE_TIME.
+  HOST is ip#port, SERVER_NAME is HOST for nodes not in mysql.servers.
+*/
+int tc_fill_node_latency(THD *thd, TABLE_LIST *tables, Item *cond)
+{
+  TABLE *table = tables->table;
+  MEM_ROOT mem_root;
+  list<TC_LATENCY_ROW> row_list;
+  int ret = 0;
+  DBUG_ENTER("tc_fill_node_latency");
+
+  if (check_global_access(thd, PROCESS_ACL))
+    DBUG_RETURN(1);
+
+  init_sql_alloc(key_memory_for_tdbctl, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+  MEM_ROOT_GUARD(mem_root);
+  map<string, string> server_name_map =
+    get_server_name_map(&mem_root, NULL_WRAPPER, TRUE);
+  tc_latency_read(row_list);
+  for (auto &row : row_list)
+  {
+    char total[TC_LATENCY_TOTAL_LENGTH + 1];
+    ulonglong bound = tc_latency_bound(row.bucket);
+    map<string, string>::iterator its = server_name_map.find(row.ipport);
+    const string &server_name =
+      its == server_name_map.end() ? row.ipport : its->second;
+    const char *op_name = tc_latency_op_names[row.op];
+
+    string time = bound ? tc_format_seconds(bound) : "TOO LONG";
+    my_snprintf(total, sizeof(total), "%llu.%06llu",
+      row.total / 1000000, row.total % 1000000);
+
+    restore_record(table, s->default_values);
+    table->field[0]->store(server_name.c_str(), server_name.length(),
+      system_charset_info);
+    table->field[1]->store(row.ipport.c_str(), row.ipport.length(),
+      system_charset_info);
+    table->field[2]->store(op_name, strlen(op_name), system_charset_info);
+    table->field[3]->store(time.c_str(), time.length(), system_charset_info);
+    table->field[4]->store(row.count, TRUE);
+    table->field[5]->store(total, strlen(total), system_charset_info);
+    if (schema_table_store_record(thd, table))
+    {
+      ret = 1;
+      break;
+    }
+  }
+
+  DBUG_RETURN(ret);
+}
+
+/*
+  fill TC_DDL_TRACE from the trace ring of this tdbctl, one row for every
+  job. NODES/FAILED_NODES count queries on nodes, SLOWEST_NODE is the
+  node whose query took longest so far. TRACE is built only if the column
+  is read, a running job is exported up to now.
+*/
+int tc_fill_ddl_trace(THD *thd, TABLE_LIST *tables, Item *cond)
+{
+  TABLE *table = tables->table;
+  MEM_ROOT mem_root;
+  int ret = 0;
+  DBUG_ENTER("tc_fill_ddl_trace");
+
+  if (check_global_access(thd, PROCESS_ACL))
+    DBUG_RETURN(1);
+
+  init_sql_alloc(key_memory_for_tdbctl, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+  MEM_ROOT_GUARD(mem_root);
+  map<string, string> server_name_map =
+    get_server_name_map(&mem_root, NULL_WRAPPER, TRUE);
+  bool with_trace = bitmap_is_set(table->read_set, 10);
+  list<TC_TRACE_JOB_PTR> job_list = tc_trace_jobs();
+  for (auto &job : job_list)
+  {
+    std::lock_guard<std::mutex> lock(job->mtx);
+    ulonglong now = my_micro_time();
+    ulonglong nodes = 0, failed_nodes = 0, slowest_time = 0;
+    string slowest_ipport, trace;
+    for (auto &event : job->event_list)
+    {
+      if (event.ipport.empty())
+        continue;
+      ulonglong time = (event.end ? event.end : now) - event.begin;
+      nodes++;
+      if (event.err_code)
+        failed_nodes++;
+      if (slowest_ipport.empty() || time > slowest_time)
+      {
+        slowest_time = time;
+        slowest_ipport = event.ipport;
+      }
+    }
+    string state = !job->end ? "RUNNING" : (job->failed ? "FAILED" : "OK");
+    string duration = tc_format_seconds((job->end ? job->end : now) - job->begin);
+    if (with_trace)
+      trace = tc_trace_chrome_json(job.get(), server_name_map, now);
+
+    restore_record(table, s->default_values);
+    table->field[0]->store(job->id, TRUE);
+    table->field[1]->store(job->thread_id, TRUE);
+    table->field[2]->store(job->db.c_str(), job->db.length(), system_charset_info);
+    table->field[3]->store(job->query.c_str(), job->query.length(),
+      system_charset_info);
+    table->field[4]->store(state.c_str(), state.length(), system_charset_info);
+    table->field[5]->store(duration.c_str(), duration.length(),
+      system_charset_info);
+    table->field[6]->store(nodes, TRUE);
+    table->field[7]->store(failed_nodes, TRUE);
+    if (!slowest_ipport.empty())
+    {
+      map<string, string>::iterator its = server_name_map.find(slowest_ipport);
+      const string &slowest_node =
+        its == server_name_map.end() ? slowest_ipport : its->second;
+      string slowest = tc_format_seconds(slowest_time);
+      table->field[8]->set_notnull();
+      table->field[8]->store(slowest_node.c_str(), slowest_node.length(),
+        system_charset_info);
+      table->field[9]->set_notnull();
+      table->field[9]->store(slowest.c_str(), slowest.length(),
+        system_charset_info);
+    }
+    table->field[10]->store(trace.c_str(), trace.length(), &my_charset_bin);
+    if (schema_table_store_record(thd, table))
+    {
+      ret = 1;
+      break;
+    }
+  }
+
+  DBUG_RETURN(ret);
+}
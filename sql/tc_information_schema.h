@@ -0,0 +1,44 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+#ifndef TC_INFORMATION_SCHEMA_INCLUDED
+#define TC_INFORMATION_SCHEMA_INCLUDED
+
+/*
+  INFORMATION_SCHEMA tables of the whole cluster, rows are fetched from
+  all nodes in mysql.servers parallel when the table is read, the first
+  column SERVER_NAME is the node the row comes from.
+
+  TC_CLUSTER_PROCESSLIST: information_schema.PROCESSLIST of all nodes
+  TC_CLUSTER_GLOBAL_STATUS: SHOW GLOBAL STATUS of all nodes
+  TC_CLUSTER_TABLES: information_schema.TABLES of all nodes
+  TC_CLUSTER_INNODB_TRX: information_schema.INNODB_TRX of all nodes
+
+  TC_NODE_LATENCY is not fetched from nodes, it shows the latency
+  histograms of calls made by this tdbctl to every node, see tc_latency.h
+  TC_DDL_TRACE is not fetched from nodes either, it shows the timeline of
+  the last cluster DDL of this tdbctl, see tc_trace.h
+*/
+
+#include "my_global.h"
+#include "table.h"
+
+class THD;
+class Item;
+
+extern ST_FIELD_INFO tc_cluster_processlist_fields_info[];
+extern ST_FIELD_INFO tc_cluster_global_status_fields_info[];
+extern ST_FIELD_INFO tc_cluster_tables_fields_info[];
+extern ST_FIELD_INFO tc_cluster_innodb_trx_fields_info[];
+extern ST_FIELD_INFO tc_node_latency_fields_info[];
+extern ST_FIELD_INFO tc_ddl_trace_fields_info[];
+
+int tc_fill_cluster_processlist(THD *thd, TABLE_LIST *tables, Item *cond);
+int tc_fill_cluster_global_status(THD *thd, TABLE_LIST *tables, Item *cond);
+int tc_fill_cluster_tables(THD *thd, TABLE_LIST *tables, Item *cond);
+int tc_fill_cluster_innodb_trx(THD *thd, TABLE_LIST *tables, Item *cond);
+int tc_fill_node_latency(THD *thd, TABLE_LIST *tables, Item *cond);
+int tc_fill_ddl_trace(THD *thd, TABLE_LIST *tables, Item *cond);
+
+#endif /* TC_INFORMATION_SCHEMA_INCLUDED */
@@ -0,0 +1,224 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+#include "tc_latency.h"
+#include "my_sys.h"
+#include "my_atomic.h"
+#include "m_string.h"
+#include "sql_class.h"
+#include "log.h"
+#include "tc_base.h"
+#include <functional>
+#include <thread>
+
+thread_local tc_latency_op tc_latency_cur_op = TC_LATENCY_OP_OTHER;
+
+/* indexed by tc_latency_op */
+const char *tc_latency_op_names[] =
+{
+  "OTHER", "CONNECT", "DDL", "PROBE", "FLUSH", "XA"
+};
+
+/* state of a slot */
+#define TC_LATENCY_SLOT_FREE 0
+/* ipport and counters are being set, by taking or releasing */
+#define TC_LATENCY_SLOT_BUSY 1
+#define TC_LATENCY_SLOT_USED 2
+/* released, can be taken again, lookup goes on over it */
+#define TC_LATENCY_SLOT_RELEASED 3
+
+/*
+  histograms of one node
+  state: TC_LATENCY_SLOT_*, changed by compare and swap
+  ipport: valid only when state is TC_LATENCY_SLOT_USED
+*/
+typedef struct tc_latency_node
+{
+  volatile int32 state;
+  char ipport[TC_LATENCY_IPPORT_LENGTH];
+  int64 count[TC_LATENCY_OP_COUNT][TC_LATENCY_BUCKET_COUNT];
+  int64 total[TC_LATENCY_OP_COUNT][TC_LATENCY_BUCKET_COUNT];
+} TC_LATENCY_NODE;
+
+static TC_LATENCY_NODE tc_latency_nodes[TC_LATENCY_MAX_NODES];
+/* 1 after the warning of full slots is logged, 0 again when a slot is released */
+static volatile int32 tc_latency_full_warned = 0;
+
+/* upper bound in microseconds of bucket, 0 for the overflow bucket */
+ulonglong tc_latency_bound(uint bucket)
+{
+  if (bucket >= TC_LATENCY_BOUND_COUNT)
+    return 0;
+  return 1ULL << bucket;
+}
+
+static void tc_latency_reset_node(TC_LATENCY_NODE *node)
+{
+  for (uint op = 0; op < TC_LATENCY_OP_COUNT; op++)
+  {
+    for (uint i = 0; i < TC_LATENCY_BUCKET_COUNT; i++)
+    {
+      my_atomic_store64(&node->count[op][i], 0);
+      my_atomic_store64(&node->total[op][i], 0);
+    }
+  }
+}
+
+/* state of the slot, wait while it is busy */
+static int32 tc_latency_node_state(TC_LATENCY_NODE *node)
+{
+  int32 state;
+  while ((state = my_atomic_load32(&node->state)) == TC_LATENCY_SLOT_BUSY)
+    std::this_thread::yield();
+  return state;
+}
+
+/*
+  slot of ipport, take a free or released slot if ipport has none
+
+  @NOTE:
+    lookup goes from the hashed slot and stops at the first free slot,
+    the first free or released slot on the way is taken, so an ipport has
+    one slot. Lookup is done again if another thread takes the slot first.
+
+  @retval
+    NULL if all slots are taken by other nodes
+*/
+static TC_LATENCY_NODE *tc_latency_get_node(const string &ipport)
+{
+  size_t start = std::hash<string>()(ipport) % TC_LATENCY_MAX_NODES;
+  if (ipport.length() >= TC_LATENCY_IPPORT_LENGTH)
+    return NULL;
+  while (1)
+  {
+    TC_LATENCY_NODE *reuse = NULL;
+    int32 reuse_state = TC_LATENCY_SLOT_FREE;
+    for (uint i = 0; i < TC_LATENCY_MAX_NODES; i++)
+    {
+      TC_LATENCY_NODE *node = &tc_latency_nodes[(start + i) % TC_LATENCY_MAX_NODES];
+      int32 state = tc_latency_node_state(node);
+      if (state == TC_LATENCY_SLOT_USED)
+      {
+        if (!strcmp(node->ipport, ipport.c_str()))
+          return node;
+        continue;
+      }
+      if (!reuse)
+      {
+        reuse = node;
+        reuse_state = state;
+      }
+      if (state == TC_LATENCY_SLOT_FREE)
+        break;
+    }
+    if (!reuse)
+      return NULL;
+    if (my_atomic_cas32(&reuse->state, &reuse_state, TC_LATENCY_SLOT_BUSY))
+    {
+      strmake(reuse->ipport, ipport.c_str(), TC_LATENCY_IPPORT_LENGTH - 1);
+      tc_latency_reset_node(reuse);
+      my_atomic_store32(&reuse->state, TC_LATENCY_SLOT_USED);
+      return reuse;
+    }
+  }
+}
+
+/* count a call of time microseconds to ipport made for op */
+void tc_latency_collect(const string &ipport, tc_latency_op op, ulonglong time)
+{
+  TC_LATENCY_NODE *node = tc_latency_get_node(ipport);
+  if (!node)
+  {
+    int32 warned = 0;
+    if (my_atomic_cas32(&tc_latency_full_warned, &warned, 1))
+      sql_print_warning("TDBCTL: latency of %s and more nodes is not counted, "
+        "all %d slots are taken, TDBCTL FLUSH ROUTING releases slots of "
+        "dropped nodes", ipport.c_str(), TC_LATENCY_MAX_NODES);
+    return;
+  }
+  uint i = 0;
+  while (i < TC_LATENCY_BOUND_COUNT && tc_latency_bound(i) <= time)
+    i++;
+  my_atomic_add64(&node->count[op][i], 1);
+  my_atomic_add64(&node->total[op][i], (int64)time);
+}
+
+/* non empty buckets of all nodes */
+void tc_latency_read(list<TC_LATENCY_ROW> &row_list)
+{
+  for (uint n = 0; n < TC_LATENCY_MAX_NODES; n++)
+  {
+    TC_LATENCY_NODE *node = &tc_latency_nodes[n];
+    char ipport[TC_LATENCY_IPPORT_LENGTH];
+    if (my_atomic_load32(&node->state) != TC_LATENCY_SLOT_USED)
+      continue;
+    strmake(ipport, node->ipport, TC_LATENCY_IPPORT_LENGTH - 1);
+    for (uint op = 0; op < TC_LATENCY_OP_COUNT; op++)
+    {
+      for (uint i = 0; i < TC_LATENCY_BUCKET_COUNT; i++)
+      {
+        int64 count = my_atomic_load64(&node->count[op][i]);
+        if (!count)
+          continue;
+        TC_LATENCY_ROW row;
+        row.ipport = ipport;
+        row.op = (tc_latency_op)op;
+        row.bucket = i;
+        row.count = (ulonglong)count;
+        row.total = (ulonglong)my_atomic_load64(&node->total[op][i]);
+        row_list.push_back(row);
+      }
+    }
+  }
+}
+
+/*
+  set all counters to 0, slots of nodes not in mysql.servers are released,
+  calls counted while flushing may be partly kept
+*/
+void tc_latency_flush()
+{
+  tc_latency_release_stale();
+  for (uint n = 0; n < TC_LATENCY_MAX_NODES; n++)
+  {
+    TC_LATENCY_NODE *node = &tc_latency_nodes[n];
+    if (my_atomic_load32(&node->state) == TC_LATENCY_SLOT_USED)
+      tc_latency_reset_node(node);
+  }
+}
+
+/*
+  release slots of nodes not in mysql.servers
+
+  @NOTE:
+    a call to the node counted while releasing may be lost.
+*/
+void tc_latency_release_stale()
+{
+  MEM_ROOT mem_root;
+  map<string, string> server_name_map;
+  bool released = false;
+
+  init_sql_alloc(PSI_NOT_INSTRUMENTED, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+  server_name_map = get_server_name_map(&mem_root, NULL_WRAPPER, TRUE);
+  free_root(&mem_root, MYF(0));
+
+  for (uint n = 0; n < TC_LATENCY_MAX_NODES; n++)
+  {
+    TC_LATENCY_NODE *node = &tc_latency_nodes[n];
+    int32 state = TC_LATENCY_SLOT_USED;
+    if (my_atomic_load32(&node->state) != TC_LATENCY_SLOT_USED ||
+        server_name_map.count(node->ipport))
+      continue;
+    if (my_atomic_cas32(&node->state, &state, TC_LATENCY_SLOT_BUSY))
+    {
+      tc_latency_reset_node(node);
+      node->ipport[0] = 0;
+      my_atomic_store32(&node->state, TC_LATENCY_SLOT_RELEASED);
+      released = true;
+    }
+  }
+  if (released)
+    my_atomic_store32(&tc_latency_full_warned, 0);
+}
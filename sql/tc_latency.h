@@ -0,0 +1,95 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+#ifndef TC_LATENCY_INCLUDED
+#define TC_LATENCY_INCLUDED
+
+/*
+  latency histograms of calls from tdbctl to nodes
+
+  every connect or query to a node is counted in the histogram of
+  (ip#port of node, operation of the calling thread). Buckets follow
+  time_collector of query_response_time with base 2: bucket i counts calls
+  shorter than 2^i microseconds and not counted by bucket i-1, the last
+  bucket counts calls longer than the last bound.
+
+  Histograms are kept in a fixed table of TC_LATENCY_MAX_NODES slots, a
+  slot is taken by its ip#port with compare and swap, counters are added
+  atomically, so no lock is taken when a call is counted. Slots of nodes
+  no longer in mysql.servers are released by TDBCTL FLUSH ROUTING and
+  TDBCTL FLUSH LATENCY, calls to a node which gets no slot are not counted
+  and a warning is logged. TDBCTL FLUSH LATENCY sets all counters to 0.
+
+  Read by INFORMATION_SCHEMA.TC_NODE_LATENCY, only non empty buckets.
+*/
+
+#include "my_global.h"
+#include <string>
+#include <list>
+using namespace std;
+
+#define TC_LATENCY_MAX_NODES 4096
+/* ip#port of a slot, with the terminating 0 */
+#define TC_LATENCY_IPPORT_LENGTH 128
+/* bounds 1us, 2us, 4us ... 2^26us(67s) */
+#define TC_LATENCY_BOUND_COUNT 27
+/* with the overflow bucket */
+#define TC_LATENCY_BUCKET_COUNT (TC_LATENCY_BOUND_COUNT + 1)
+/* TIME and TOTAL of INFORMATION_SCHEMA.TC_NODE_LATENCY, in seconds */
+#define TC_LATENCY_TIME_LENGTH 14
+#define TC_LATENCY_TOTAL_LENGTH 26
+
+/* operation a call to node is made for */
+enum tc_latency_op
+{
+  TC_LATENCY_OP_OTHER = 0,
+  TC_LATENCY_OP_CONNECT,
+  TC_LATENCY_OP_DDL,
+  TC_LATENCY_OP_PROBE,
+  TC_LATENCY_OP_FLUSH,
+  TC_LATENCY_OP_XA,
+  TC_LATENCY_OP_COUNT
+};
+
+/*
+  operation of calls made by current thread, threads created by
+  tc_thread_create inherit it from the creating thread
+*/
+extern thread_local tc_latency_op tc_latency_cur_op;
+
+/* set tc_latency_cur_op in a scope */
+class Tc_latency_op_guard
+{
+public:
+  Tc_latency_op_guard(tc_latency_op op) : m_old_op(tc_latency_cur_op)
+  {
+    tc_latency_cur_op = op;
+  }
+  ~Tc_latency_op_guard()
+  {
+    tc_latency_cur_op = m_old_op;
+  }
+private:
+  tc_latency_op m_old_op;
+};
+
+/* one non empty bucket */
+typedef struct tc_latency_row
+{
+  string ipport;
+  tc_latency_op op;
+  uint bucket;
+  ulonglong count;
+  ulonglong total;
+} TC_LATENCY_ROW;
+
+extern const char *tc_latency_op_names[];
+
+void tc_latency_collect(const string &ipport, tc_latency_op op, ulonglong time);
+void tc_latency_read(list<TC_LATENCY_ROW> &row_list);
+void tc_latency_flush();
+void tc_latency_release_stale();
+ulonglong tc_latency_bound(uint bucket);
+
+#endif /* TC_LATENCY_INCLUDED */
@@ -23,6 +23,9 @@
 #include <regex>
 #include <thread>
 #include <mutex>
+#include <deque>
+#include <cmath>
+#include "errmsg.h"
 #include "tc_monitor.h"
 
 static int64 current_id = 0;
@@ -46,6 +49,14 @@ map<string, string> tdbctl_passwd_map;
 string  tdbctl_server_name="";
 MYSQL *tdbctl_primary_conn = NULL;
 MEM_ROOT mem_root;
+/*
+key:ip#port
+value:state of failure detector for the spider node
+
+keep across tc_init_connect, so that the heartbeat history
+is not lost when connections are re-inited
+*/
+map<string, TC_MONITOR_NODE_STATE> spider_node_state_map;
 
 
 void tc_free_connect()
@@ -67,6 +78,51 @@ void tc_free_connect()
   free_root(&mem_root, MYF(0));
 }
 
+/*
+  timeout(seconds) of connection used by monitor,
+  all limited by tc_check_availability_interval
+*/
+static void get_monitor_timeouts(ulong *read_timeout, ulong *write_timeout,
+  ulong *connect_timeout)
+{
+  *read_timeout = 600 < tc_check_availability_interval ?
+    600 : tc_check_availability_interval;
+  *write_timeout = 600 < tc_check_availability_interval ?
+    600 : tc_check_availability_interval;
+  *connect_timeout = 60 < tc_check_availability_interval ?
+    60 : tc_check_availability_interval;
+}
+
+/*
+  set options and session variables for one spider connection
+
+  @retval
+    FALSE ok
+    TRUE  error, detail in exec_info
+*/
+static bool set_spider_conn_options(MYSQL *spider_conn, tc_exec_info *exec_info)
+{
+  stringstream ss;
+  ulong read_timeout, write_timeout, connect_timeout;
+  string  spider_session_variables_sql = "";
+  get_monitor_timeouts(&read_timeout, &write_timeout, &connect_timeout);
+  ss.str("");
+  ss << tc_check_availability_interval;
+
+  /*init for spider_session_variables_sql*/
+  spider_session_variables_sql += "set lock_wait_timeout=" + ss.str();
+  spider_session_variables_sql += ";";
+  spider_session_variables_sql += "set spider_net_read_timeout=" + ss.str();
+  spider_session_variables_sql += ";";
+  spider_session_variables_sql += "set spider_net_write_timeout=" + ss.str();
+  spider_session_variables_sql += ";";
+
+  mysql_options(spider_conn, MYSQL_OPT_READ_TIMEOUT, &read_timeout);
+  mysql_options(spider_conn, MYSQL_OPT_WRITE_TIMEOUT, &write_timeout);
+  mysql_options(spider_conn, MYSQL_OPT_CONNECT_TIMEOUT, &connect_timeout);
+  return tc_exec_sql_without_result(spider_conn, spider_session_variables_sql, exec_info);
+}
+
 int set_mysql_options(int &error_code, string &message) 
 {
   int result = 0;
@@ -74,37 +130,17 @@ int set_mysql_options(int &error_code, string &message)
   tc_exec_info exec_info;
   MYSQL* spider_conn;
   string  tdbctl_session_variable_sql = "";
-  string  spider_session_variables_sql = "";
   string  lock_time_sql = "set lock_wait_timeout=";
-  string  spider_net_read_timeout_sql = "set spider_net_read_timeout=";
-  string  spider_net_write_timeout_sql = "set spider_net_write_timeout=";
-  ulong read_timeout = 600;
-  ulong write_timeout = 600;
-  ulong connect_timeout = 60;
-  read_timeout = read_timeout < tc_check_availability_interval ?
-    read_timeout : tc_check_availability_interval;
-  write_timeout = write_timeout < tc_check_availability_interval ?
-    write_timeout : tc_check_availability_interval;
-  connect_timeout = connect_timeout < tc_check_availability_interval ?
-    connect_timeout : tc_check_availability_interval;
+  ulong read_timeout, write_timeout, connect_timeout;
+  get_monitor_timeouts(&read_timeout, &write_timeout, &connect_timeout);
   ss.str("");
   ss << tc_check_availability_interval;
   lock_time_sql += ss.str();
-  spider_net_read_timeout_sql += ss.str();
-  spider_net_write_timeout_sql += ss.str();
 
   /*init for tdbctl_session_variable_sql*/
   tdbctl_session_variable_sql = "set sql_log_bin=0;";
   tdbctl_session_variable_sql += lock_time_sql;
 
-  /*init for spider_session_variables_sql*/
-  spider_session_variables_sql += lock_time_sql;
-  spider_session_variables_sql += ";";
-  spider_session_variables_sql += spider_net_read_timeout_sql;
-  spider_session_variables_sql += ";";
-  spider_session_variables_sql += spider_net_write_timeout_sql;
-  spider_session_variables_sql += ";";
-
   /*set variables for tdbctl_primary_conn*/
   mysql_options(tdbctl_primary_conn, MYSQL_OPT_READ_TIMEOUT, &read_timeout);
   mysql_options(tdbctl_primary_conn, MYSQL_OPT_WRITE_TIMEOUT, &write_timeout);
@@ -125,10 +161,7 @@ int set_mysql_options(int &error_code, string &message)
   for (its = spider_conn_map.begin(); its != spider_conn_map.end(); its++)
   {
     spider_conn = its->second;
-    mysql_options(spider_conn, MYSQL_OPT_READ_TIMEOUT, &read_timeout);
-    mysql_options(spider_conn, MYSQL_OPT_WRITE_TIMEOUT, &write_timeout);
-    mysql_options(spider_conn, MYSQL_OPT_CONNECT_TIMEOUT, &connect_timeout);
-    if (tc_exec_sql_without_result(spider_conn, spider_session_variables_sql, &exec_info))
+    if (set_spider_conn_options(spider_conn, &exec_info))
     {
       result = 2;
       error_code = exec_info.err_code;
@@ -190,6 +223,7 @@ int tc_init_connect(ulong& server_version)
   server_version = get_modify_server_version();
   current_id_init = FALSE;
   current_chunk_id_init = FALSE;
+  tc_init_node_state();
   return ret;
 finish:
   tc_free_connect();
@@ -204,7 +238,8 @@ finish:
 
 void create_check_cluster_availability_thread()
 {
-  std::thread t(tc_check_cluster_availability_thread);
+  std::thread t(tc_thread_create(key_thread_tc_monitor,
+    tc_check_cluster_availability_thread));
   t.detach();
 }
 
@@ -263,6 +298,34 @@ int tc_check_cluster_availability_init(string& err_msg)
     " remote_hash_algorithm char(64) DEFAULT 'list', is_partitioned int(11) DEFAULT '0',"
     " updatetime timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE  CURRENT_TIMESTAMP,"
     " PRIMARY KEY (`db_name`,`tb_name`)) ENGINE=InnoDB STATS_PERSISTENT=0;";
+  tdbclt_init_sql += "CREATE TABLE IF NOT EXISTS cluster_admin.tc_schema_catalog_log"
+    " ( version bigint NOT NULL AUTO_INCREMENT, db_name char(64) NOT NULL DEFAULT '',"
+    " tb_name char(64) NOT NULL DEFAULT '', sql_type char(64) NOT NULL DEFAULT '',"
+    " query mediumtext, create_time timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,"
+    " KEY `idx_db_tb` (`db_name`,`tb_name`), PRIMARY KEY (`version`)) ENGINE=InnoDB STATS_PERSISTENT=0;";
+  tdbclt_init_sql += "CREATE TABLE IF NOT EXISTS cluster_admin.tc_schema_catalog"
+    " ( db_name char(64) NOT NULL DEFAULT '', tb_name char(64) NOT NULL DEFAULT '',"
+    " server_name char(64) NOT NULL DEFAULT '', version bigint NOT NULL DEFAULT 0,"
+    " create_sql mediumtext,"
+    " updatetime timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE  CURRENT_TIMESTAMP,"
+    " PRIMARY KEY (`db_name`,`tb_name`,`server_name`)) ENGINE=InnoDB STATS_PERSISTENT=0;";
+  tdbclt_init_sql += "CREATE TABLE IF NOT EXISTS cluster_admin.tc_table_stats"
+    " ( db_name char(64) NOT NULL DEFAULT '', tb_name char(64) NOT NULL DEFAULT '',"
+    " server_name char(64) NOT NULL DEFAULT '', host char(255) NOT NULL DEFAULT '',"
+    " table_rows bigint unsigned NOT NULL DEFAULT 0, data_length bigint unsigned NOT NULL DEFAULT 0,"
+    " index_length bigint unsigned NOT NULL DEFAULT 0, data_free bigint unsigned NOT NULL DEFAULT 0,"
+    " update_time datetime DEFAULT NULL,"
+    " collect_time timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE  CURRENT_TIMESTAMP,"
+    " PRIMARY KEY (`db_name`,`tb_name`,`server_name`)) ENGINE=InnoDB STATS_PERSISTENT=0;";
+  tdbclt_init_sql += "create or replace view cluster_admin.v_tc_table_skew as"
+    " select db_name,tb_name,count(*) as shards,sum(table_rows) as table_rows,"
+    " sum(data_length+index_length) as total_length,"
+    " max(data_length+index_length) as max_length,"
+    " avg(data_length+index_length) as avg_length,"
+    " substring_index(group_concat(server_name order by data_length+index_length desc),',',1)"
+    " as max_server_name,"
+    " round(max(data_length+index_length)/nullif(avg(data_length+index_length),0),2) as skew_ratio"
+    " from cluster_admin.tc_table_stats group by db_name,tb_name;";
 
   //init sql for create schema on spider
   string sql = "set ddl_execute_by_ctl = on";
@@ -449,121 +512,271 @@ finish:
 }
 
 /*
-  check availability of one spider node
+  calculate phi of the accrual failure detector
+
+  @NOTE:
+    phi = -log10(1 - F(elapsed)), F is the cumulative distribution
+    function of normal distribution with mean and standard deviation
+    of the heartbeat history, the logistic approximation is used.
+    the bigger phi is, the more the spider node is suspected.
+
+  @retval
+    phi value of the spider node at time now(millisecond)
+*/
+double tc_monitor_phi(TC_MONITOR_NODE_STATE *state, ulonglong now)
+{
+  double mean = 0;
+  double variance = 0;
+  double std_deviation;
+  double elapsed, y, e;
+  size_t count = state->heartbeat_history.size();
+
+  if (state->last_ok_time == 0 || count == 0)
+    return 0;
+
+  for (auto &interval : state->heartbeat_history)
+    mean += interval;
+  mean /= count;
+  for (auto &interval : state->heartbeat_history)
+    variance += (interval - mean) * (interval - mean);
+  variance /= count;
+  std_deviation = sqrt(variance);
+  if (std_deviation < TC_MONITOR_MIN_STD_DEVIATION)
+    std_deviation = TC_MONITOR_MIN_STD_DEVIATION;
+
+  elapsed = now > state->last_ok_time ? (double)(now - state->last_ok_time) : 0;
+  y = (elapsed - mean) / std_deviation;
+  e = exp(-y * (1.5976 + 0.070566 * y * y));
+  if (elapsed > mean)
+    return -log10(e / (1.0 + e));
+  return -log10(1.0 - 1.0 / (1.0 + e));
+}
+
+/*
+  whether the spider node is available in view of current TDBCTL
+
+  @NOTE:
+    a spider node never probed ok is unavailable if the last probe failed,
+    otherwise the node is unavailable when phi reaches
+    tc_check_availability_phi_threshold, so that a transient failed probe
+    does not flap the result.
+*/
+bool tc_monitor_node_available(TC_MONITOR_NODE_STATE *state, ulonglong now)
+{
+  if (state->last_ok_time == 0)
+    return state->last_err_code == 0;
+  return tc_monitor_phi(state, now) < tc_check_availability_phi_threshold;
+}
 
-  @param(out): result:
-    0 for ok
-    1 for the spider is not available
-    2 for log failed 
+/*
+  max probe interval(second) of a spider node probed ok
+
+  @NOTE:
+    limited by half of tc_check_availability_interval, so that with
+    TC_MONITOR_MIN_STD_DEVIATION phi of a down node reaches the default
+    tc_check_availability_phi_threshold within one monitor cycle,
+    no later than the fixed check every tc_check_availability_interval.
+*/
+ulong tc_monitor_max_probe_interval()
+{
+  ulong max_interval = tc_check_availability_interval / 2;
+  if (max_interval > tc_check_availability_max_interval)
+    max_interval = tc_check_availability_max_interval;
+  return max_interval ? max_interval : 1;
+}
+
+/*
+  sync spider_node_state_map with spider_conn_map after tc_init_connect
+  state of the spider node which still exists is kept
+*/
+void tc_init_node_state()
+{
+  map<string, TC_MONITOR_NODE_STATE>::iterator its;
+  for (its = spider_node_state_map.begin(); its != spider_node_state_map.end();)
+  {
+    if (spider_conn_map.find(its->first) == spider_conn_map.end())
+      spider_node_state_map.erase(its++);
+    else
+      ++its;
+  }
+  for (auto &conn : spider_conn_map)
+  {
+    if (spider_node_state_map.find(conn.first) == spider_node_state_map.end())
+    {
+      TC_MONITOR_NODE_STATE state;
+      state.last_ok_time = 0;
+      state.next_probe_time = 0;
+      state.probe_interval = tc_monitor_max_probe_interval();
+      state.last_err_code = 0;
+      state.last_err_msg = "";
+      spider_node_state_map.insert(pair<string, TC_MONITOR_NODE_STATE>(conn.first, state));
+    }
+    else
+    {//probe immediately after re-init
+      spider_node_state_map[conn.first].next_probe_time = 0;
+    }
+  }
+}
+
+/*
+  probe one spider node, and update state of the failure detector
 
   @NOTE:
     1.update cluster cluster_admin.cluster_heartbeat table
-    2.log result in TDBCTL: cluster_admin.cluster_heartbeat_log
+    2.reconnect if the connection is lost
+    3.a node probed ok is probed less frequently, up to
+      tc_monitor_max_probe_interval();
+      a node probed failed is probed every second
 */
-void tc_exec_check_sql(MYSQL* mysql, string check_heartbeat_sql,
-  string host, string spider_server_name, int* result, 
-  tc_exec_info* exec_info)
+void tc_exec_check_sql(MYSQL** mysql, string check_heartbeat_sql,
+  string host, TC_MONITOR_NODE_STATE* state)
 {
-  string error_code = "0";
-  string message = "";
-  if (mysql)
+  tc_exec_info exec_info;
+  ulonglong start_time;
+  ulonglong now;
+  exec_info.err_code = 0;
+  exec_info.row_affect = 0;
+  exec_info.err_msg = "";
+
+  start_time = my_micro_time() / 1000;
+  if (*mysql == NULL)
+  {
+    exec_info.err_code = 2013;
+    exec_info.err_msg = "mysql is an null pointer";
+  }
+  else
+  {
+    tc_exec_sql_without_result(*mysql, check_heartbeat_sql, &exec_info);
+  }
+  now = my_micro_time() / 1000;
+
+  if (exec_info.err_code == 0)
   {
-    stringstream ss;
-    if (tc_exec_sql_without_result(mysql, check_heartbeat_sql, exec_info))
+    if (state->last_ok_time)
     {
-      *result = *result ? *result : 1;
-      ss.str("");
-      ss << exec_info->err_code;
-      error_code = ss.str();
-      message = exec_info->err_msg;
-      exec_info->err_code = 0;
-      exec_info->row_affect = 0;
-      exec_info->err_msg = "";
+      state->heartbeat_history.push_back((double)(now - state->last_ok_time));
+      if (state->heartbeat_history.size() > TC_MONITOR_HISTORY_SIZE)
+        state->heartbeat_history.pop_front();
+    }
+    else if (state->heartbeat_history.empty())
+    {//first heartbeat, use probe interval as estimate
+      state->heartbeat_history.push_back((double)state->probe_interval * 1000);
     }
+    state->last_ok_time = now;
+    state->last_err_code = 0;
+    state->last_err_msg = "";
+    state->probe_interval = state->probe_interval * 2;
+    if (state->probe_interval > tc_monitor_max_probe_interval())
+      state->probe_interval = tc_monitor_max_probe_interval();
   }
   else
   {
-    error_code = "2013";
-    message = "mysql is an null pointer";
-    *result = 2;
+    state->last_err_code = exec_info.err_code;
+    state->last_err_msg = exec_info.err_msg;
+    state->probe_interval = 1;
+    if (exec_info.err_code == CR_SERVER_GONE_ERROR ||
+      exec_info.err_code == CR_SERVER_LOST)
+    {
+      tc_exec_info conn_info;
+      if (*mysql)
+      {
+        mysql_close(*mysql);
+        *mysql = NULL;
+      }
+      if ((*mysql = tc_conn_connect(host, spider_user_map[host], spider_passwd_map[host])) &&
+        set_spider_conn_options(*mysql, &conn_info))
+      {
+        sql_print_warning("TDBCTL MONITOR: set options for %s failed: %d %s",
+          host.c_str(), conn_info.err_code, (char*)(conn_info.err_msg.data()));
+      }
+    }
   }
+  state->next_probe_time = start_time + state->probe_interval * 1000;
 }
 
 /*
-  check availability of all spider node in parallel mode
-   
+  probe spider nodes which are due or suspected in parallel mode
+*/
+void tc_probe_cluster_nodes(string check_heartbeat_sql)
+{
+  ulonglong now = my_micro_time() / 1000;
+  list<thread> thread_list;
+  for (auto &node : spider_node_state_map)
+  {
+    string host = node.first;
+    TC_MONITOR_NODE_STATE *state = &node.second;
+    if (state->next_probe_time > now &&
+      tc_monitor_phi(state, now) < TC_MONITOR_SUSPECT_PHI)
+      continue;
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_exec_check_sql,
+      &spider_conn_map[host], check_heartbeat_sql, host, state));
+    thread_list.push_back(std::move(tmp_t));
+  }
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+}
+
+/*
+  check availability of all spider node in one monitor cycle
+
   @NOTE:
-    do tc_exec_check_sql parallel
+    probe spider nodes every second if due or suspected,
+    then log result of the failure detector for each node
+    in cluster_admin.cluster_heartbeat_log
+
+  @retval:
+    0 ok
+    2 log failed
 */
 int tc_check_cluster_availability()
 {
   int result = 0;
-  int count = spider_conn_map.size();
-  int i = 0;
   stringstream ss;
 
   //init for sql
   string check_heartbeat_sql = "update cluster_admin.cluster_heartbeat set k=(k+1)%1024";
   string spider_server_name = "";
-  string host = "";
 
-
-  /* init for exec result: result_map */
-  map<string, MYSQL*>::iterator its;
-  map<string, tc_exec_info> result_map;
-  for (its = spider_conn_map.begin(); its != spider_conn_map.end(); its++)
+  for (ulong t = 0; t + 2 < tc_check_availability_interval && tc_check_availability; ++t)
   {
-    string host = its->first;
-    tc_exec_info exec_info;
-    exec_info.err_code = 0;
-    exec_info.row_affect = 0;
-    exec_info.err_msg = "";
-    result_map.insert(pair<string, tc_exec_info>(host, exec_info));
+    tc_probe_cluster_nodes(check_heartbeat_sql);
+    sleep(1);
   }
 
-  MYSQL* spider_conn;
-  thread* thread_array = new thread[count];
-  for (its = spider_conn_map.begin(); its != spider_conn_map.end(); its++)
-  {
-    host = its->first;
-    spider_conn = its->second;
-    spider_server_name = spider_server_name_map[host];
-    thread tmp_t(tc_exec_check_sql, spider_conn, check_heartbeat_sql, host,
-      spider_server_name, &result, &result_map[host]);
-    thread_array[i] = move(tmp_t);
-    i++;
-  }
-
-  for (int i = 0; i < count; i++)
-  {
-    if (thread_array[i].joinable())
-      thread_array[i].join();
-  }
   //get result and log
-  map<string, tc_exec_info>::iterator its2;
-  for (its2 = result_map.begin(); its2 != result_map.end(); its2++)
+  ulonglong now = my_micro_time() / 1000;
+  map<string, TC_MONITOR_NODE_STATE>::iterator its;
+  for (its = spider_node_state_map.begin(); its != spider_node_state_map.end(); its++)
   {
-    string host = its2->first;
-    tc_exec_info exec_info = its2->second;
-    ss.str("");
-    ss << exec_info.err_code;
-    string error_code = ss.str();
+    string host = its->first;
+    TC_MONITOR_NODE_STATE *state = &its->second;
+    string error_code = "0";
+    string message = "";
+    if (!tc_monitor_node_available(state, now))
+    {
+      ss.str("");
+      ss << (state->last_err_code ? state->last_err_code : 1);
+      error_code = ss.str();
+      ss.str("");
+      ss << state->last_err_msg << " phi: " << tc_monitor_phi(state, now);
+      message = ss.str();
+    }
     spider_server_name = spider_server_name_map[host];
     if (tc_monitor_log(tdbctl_server_name, spider_server_name, host,
-      error_code, exec_info.err_msg))
+      error_code, message))
     {
       result = 2;
     }
   }
 
-
   if (result == 2)
   {
     sql_print_warning("TDBCTL MONITOR: select or replace"
       " cluster_heartbeat_log failed");
   }
-  delete[] thread_array;
-  result_map.clear();
   return result;
 }
 
@@ -981,6 +1194,7 @@ tc_check_cluster_availability do check work and log in cluster_admin.cluster_hea
 */
 void tc_check_cluster_availability_thread()
 {
+  tc_latency_cur_op = TC_LATENCY_OP_PROBE;
   /*
   flag of whether need to re-init connect
   0 means not re-init
@@ -1050,13 +1264,10 @@ void tc_check_cluster_availability_thread()
       */
       if (!res)
       {
-        //check available for cluster
+        //check available for cluster, take one monitor cycle
         res = tc_check_cluster_availability();
         if (tdbctl_is_primary && tc_process_monitor_log())
           res = 1;
-
-        for (ulong i = 0; i < tc_check_availability_interval - 2; ++i)
-          sleep(1);
       }
     }
     else
@@ -11,8 +11,35 @@
 #include <set>
 #include <sstream>
 #include <regex>
+#include <deque>
 #include "mysql.h"
 using namespace std;
+
+//max number of heartbeat intervals kept for each spider node
+#define TC_MONITOR_HISTORY_SIZE 100
+//lower bound of standard deviation(millisecond) when calculating phi
+#define TC_MONITOR_MIN_STD_DEVIATION 500.0
+//phi above which a spider node is probed every second
+#define TC_MONITOR_SUSPECT_PHI 1.0
+
+/*
+  state of the accrual failure detector for one spider node
+  all times are in millisecond
+*/
+typedef struct tc_monitor_node_state
+{
+  deque<double> heartbeat_history; // intervals between successful probes
+  ulonglong last_ok_time;          // time of last successful probe, 0 for never
+  ulonglong next_probe_time;       // time of next scheduled probe
+  ulong probe_interval;            // current probe interval in second
+  uint last_err_code;              // error of last probe, 0 for ok
+  string last_err_msg;
+} TC_MONITOR_NODE_STATE;
+
+double tc_monitor_phi(TC_MONITOR_NODE_STATE *state, ulonglong now);
+bool tc_monitor_node_available(TC_MONITOR_NODE_STATE *state, ulonglong now);
+ulong tc_monitor_max_probe_interval();
+void tc_init_node_state();
 int tc_check_cluster_availability();
 void create_check_cluster_availability_thread();
 void tc_check_cluster_availability_thread();
@@ -10,102 +10,493 @@ Add for node's control
 #include "log.h"
 #include "tc_base.h"
 #include <thread>
+#include <mutex>
+#include <vector>
+#include <list>
+#include <set>
+
+/* quote string value with single quote */
+static string tc_quote_value(string value)
+{
+  string res = "'";
+  for (size_t i = 0; i < value.length(); i++)
+  {
+    if (value[i] == '\'' || value[i] == '\\')
+      res += '\\';
+    res += value[i];
+  }
+  res += "'";
+  return res;
+}
 
 /*
- use mysqldump to backup node's schema
- return value
+  execute statements as multi-statement batches of TC_NODE_SCHEMA_BATCH_SIZE
+
+  @NOTE:
+    the remote stops executing a batch at the first error, if the error
+    is in ignore_errno_set the batch is resent from the next statement.
+
+  @retval
     0 ok
-    1 error
+    1 error, exec_info is set
 */
-int tc_dump_node_schema(
-        const char *host,
-        uint port,
-        const char *user,
-        const char *password,
-        const char *file)
+static int tc_exec_sql_pipeline(
+  MYSQL *mysql,
+  vector<string> &sql_list,
+  set<uint> &ignore_errno_set,
+  tc_exec_info *exec_info)
 {
-  string space = " ";
-  string dump_cmd, dump_bin, dump_options;
-  string ipport = string(host) + "#" + to_string(port);
-
-#if defined (_WIN32)
-  dump_bin = "mysqldump";
-#else
-  dump_bin = mysql_home_ptr;
-  dump_bin += "/bin/mysqldump";
-#endif
-  dump_options = "--single-transaction --no-autocommit=FALSE  --skip-opt --create-options --routines "
-                "--quick --no-data --all-databases --add-not-exists";
-  dump_options += space + "-r" + file + space + "--log-error=" + file;
-	dump_options += space + "-u" + user + space + "-p" + password + space + "-P" + to_string(port) + space+ "-h" + host;
-  if (tc_skip_dump_db_list)
+  size_t begin = 0;
+  while (begin < sql_list.size())
   {
-    size_t pos = 0;
-    string dbs = tc_skip_dump_db_list;
-    string delimiter = ",";
-    string token;
-    while ((pos = dbs.find(delimiter)) != std::string::npos) {
-      token = dbs.substr(0, pos);
-      dump_options += space + "--ignore-database=" + token;
-      dbs.erase(0, pos + delimiter.length());
+    size_t end = begin + TC_NODE_SCHEMA_BATCH_SIZE;
+    size_t done = 0;
+    string exec_sql = "";
+    int ret;
+    TC_PSI_STATEMENT stmt;
+    if (end > sql_list.size())
+      end = sql_list.size();
+    for (size_t i = begin; i < end; i++)
+      exec_sql += sql_list[i] + ";";
+
+    tc_psi_statement_start(&stmt, TC_PSI_STATEMENT_EXECUTE, tc_mysql_ipport(mysql),
+      exec_sql.c_str(), exec_sql.length());
+    ret = mysql_real_query(mysql, exec_sql.c_str(), exec_sql.length());
+    while (!ret)
+    {
+      MYSQL_RES *res = mysql_store_result(mysql);
+      if (res)
+        mysql_free_result(res);
+      done++;
+      ret = tc_mysql_next_result(mysql);
     }
-    dump_options += space + "--ignore-database=" + token;
+    tc_psi_statement_end(&stmt, mysql, ret != -1, 0);
+    if (ret == -1)
+    {
+      begin = end;
+      continue;
+    }
+    if (!ignore_errno_set.count(mysql_errno(mysql)))
+    {
+      exec_info->err_code = mysql_errno(mysql);
+      exec_info->err_msg = string(mysql_error(mysql)) + ", sql is " +
+        sql_list[begin + done];
+      return 1;
+    }
+    begin = begin + done + 1;
   }
+  return 0;
+}
 
-  MYSQL *conn = tc_conn_connect(ipport, user, password);
-  if (conn == NULL)
+/*
+  get create statements from node by SHOW CREATE, as multi-statement batches
+
+  @param
+    show_sql_list: SHOW CREATE statements
+    create_col: column of the create statement in result
+    mode_col: column of sql_mode in result, 0 for not need, character_set_client
+              and collation_connection are the 2 columns after create_col
+  @param (out)
+    create_list: create statements, sql_mode, character_set_client and
+                 collation_connection are set before create statement
+                 if mode_col is not 0
+  @retval
+    0 ok
+    1 error, exec_info is set
+*/
+static int tc_fetch_create_sql(
+  MYSQL *mysql,
+  vector<string> &show_sql_list,
+  uint create_col,
+  uint mode_col,
+  vector<string> &create_list,
+  tc_exec_info *exec_info)
+{
+  size_t begin = 0;
+  while (begin < show_sql_list.size())
   {
-    my_error(ER_TCADMIN_DUMP_NODE_ERROR, MYF(0), user, port);
+    size_t end = begin + TC_NODE_SCHEMA_BATCH_SIZE;
+    size_t done = 0;
+    string exec_sql = "";
+    int ret;
+    TC_PSI_STATEMENT stmt;
+    if (end > show_sql_list.size())
+      end = show_sql_list.size();
+    for (size_t i = begin; i < end; i++)
+      exec_sql += show_sql_list[i] + ";";
+
+    tc_psi_statement_start(&stmt, TC_PSI_STATEMENT_QUERY, tc_mysql_ipport(mysql),
+      exec_sql.c_str(), exec_sql.length());
+    ret = mysql_real_query(mysql, exec_sql.c_str(), exec_sql.length());
+    while (!ret)
+    {
+      MYSQL_RES *res = mysql_store_result(mysql);
+      MYSQL_RES_GUARD(res);
+      MYSQL_ROW row = NULL;
+      if (res && (row = mysql_fetch_row(res)) &&
+        mysql_num_fields(res) > create_col && row[create_col])
+      {
+        if (mode_col && row[mode_col])
+        {
+          string set_sql = "set session sql_mode=" + tc_quote_value(row[mode_col]);
+          if (mysql_num_fields(res) > create_col + 2 &&
+            row[create_col + 1] && row[create_col + 2])
+            set_sql += ", character_set_client=" + tc_quote_value(row[create_col + 1]) +
+              ", collation_connection=" + tc_quote_value(row[create_col + 2]);
+          create_list.push_back(set_sql);
+        }
+        create_list.push_back(row[create_col]);
+      }
+      else
+      {/* no privilege to see the definition */
+        sql_print_warning("TDBCTL: can't get definition by %s",
+          show_sql_list[begin + done].c_str());
+      }
+      done++;
+      ret = tc_mysql_next_result(mysql);
+    }
+    tc_psi_statement_end(&stmt, mysql, ret != -1, 0);
+    if (ret != -1)
+    {
+      exec_info->err_code = mysql_errno(mysql);
+      exec_info->err_msg = string(mysql_error(mysql)) + ", sql is " +
+        show_sql_list[begin + done];
+      return 1;
+    }
+    begin = end;
+  }
+  return 0;
+}
+
+/* get first column of all rows */
+static int tc_fetch_name_list(
+  MYSQL *mysql,
+  string sql,
+  vector<string> &name_list,
+  tc_exec_info *exec_info)
+{
+  MYSQL_RES *res = tc_exec_sql_with_result(mysql, sql);
+  MYSQL_RES_GUARD(res);
+  MYSQL_ROW row = NULL;
+  if (!res)
+  {
+    exec_info->err_code = mysql_errno(mysql);
+    exec_info->err_msg = string(mysql_error(mysql)) + ", sql is " + sql;
     return 1;
   }
-  MYSQL_GUARD(conn);
-  string charset = tc_get_variable_value(conn, "character_set_server");
-  dump_options += space + "--default-character-set=" + charset;
+  while ((row = mysql_fetch_row(res)))
+  {
+    if (row[0])
+      name_list.push_back(row[0]);
+  }
+  return 0;
+}
+
+/*
+  copy schema of one database: tables, routines and triggers
+  views are returned by view_list and created after all databases
+
+  @retval
+    0 ok
+    1 error when read from source node
+    2 error when write to target node
+*/
+static int tc_copy_database_schema(
+  MYSQL *src_conn,
+  MYSQL *dst_conn,
+  string db,
+  vector<string> &view_list,
+  tc_exec_info *exec_info)
+{
+  string qdb = tc_quote_name(db);
+  vector<string> name_list;
+  vector<string> show_sql_list;
+  vector<string> create_list;
+  set<uint> ignore_errno_set;
+  MYSQL_ROW row = NULL;
 
-  dump_cmd = dump_bin + space + dump_options;
-  if (system(dump_cmd.c_str()) != 0)
+  /* ERROR 1304 (42000): PROCEDURE/FUNCTION already exists */
+  ignore_errno_set.insert(ER_SP_ALREADY_EXISTS);
+  /* ERROR 1359 (HY000): Trigger already exists */
+  ignore_errno_set.insert(ER_TRG_ALREADY_EXISTS);
+
+  /* tables and views */
+  MYSQL_RES *res = tc_exec_sql_with_result(src_conn, "show full tables from " + qdb);
+  MYSQL_RES_GUARD(res);
+  if (!res)
   {
-    sql_print_warning(ER(ER_TCADMIN_DUMP_NODE_ERROR), host, port);
-    sql_print_warning("detail information in file %s.", file);
+    exec_info->err_code = mysql_errno(src_conn);
+    exec_info->err_msg = mysql_error(src_conn);
     return 1;
   }
+  while ((row = mysql_fetch_row(res)))
+  {
+    string name = qdb + "." + tc_quote_name(row[0]);
+    if (row[1] && !strcasecmp(row[1], "VIEW"))
+      name_list.push_back("show create view " + name);
+    else
+      show_sql_list.push_back("show create table " + name);
+  }
+
+  create_list.push_back("use " + qdb);
+  create_list.push_back("set session foreign_key_checks=0");
+  if (tc_fetch_create_sql(src_conn, show_sql_list, 1, 0, create_list, exec_info))
+    return 1;
+  for (size_t i = 2; i < create_list.size(); i++)
+  {/* CREATE TABLE --> CREATE TABLE IF NOT EXISTS */
+    if (!strncasecmp(create_list[i].c_str(), "CREATE TABLE ", 13))
+      create_list[i].insert(13, "IF NOT EXISTS ");
+  }
+  if (tc_fetch_create_sql(src_conn, name_list, 1, 0, view_list, exec_info))
+    return 1;
+
+  /* routines */
+  name_list.clear();
+  show_sql_list.clear();
+  MYSQL_RES *routine_res = tc_exec_sql_with_result(src_conn, "select ROUTINE_TYPE, "
+    " ROUTINE_NAME from information_schema.ROUTINES where ROUTINE_SCHEMA=" + tc_quote_value(db));
+  MYSQL_RES_GUARD(routine_res);
+  if (!routine_res)
+  {
+    exec_info->err_code = mysql_errno(src_conn);
+    exec_info->err_msg = mysql_error(src_conn);
+    return 1;
+  }
+  while ((row = mysql_fetch_row(routine_res)))
+  {
+    show_sql_list.push_back(string("show create ") + row[0] + " " + qdb + "." +
+      tc_quote_name(row[1]));
+  }
 
-  sql_print_information("success dump schema to file %s.", file);
+  /* triggers, in order of action to keep their order */
+  if (tc_fetch_name_list(src_conn, "select TRIGGER_NAME from information_schema.TRIGGERS "
+    " where TRIGGER_SCHEMA=" + tc_quote_value(db) + " order by EVENT_OBJECT_TABLE, "
+    " EVENT_MANIPULATION, ACTION_TIMING, ACTION_ORDER", name_list, exec_info))
+    return 1;
+  for (auto &name : name_list)
+    show_sql_list.push_back("show create trigger " + qdb + "." + tc_quote_name(name));
+
+  /*
+    session of routines and triggers is restored after them like mysqldump,
+    the connection is reused for next database
+  */
+  create_list.push_back("set @tc_old_sql_mode=@@session.sql_mode, "
+    "@tc_old_character_set_client=@@session.character_set_client, "
+    "@tc_old_collation_connection=@@session.collation_connection");
+  if (tc_fetch_create_sql(src_conn, show_sql_list, 2, 1, create_list, exec_info))
+    return 1;
+  create_list.push_back("set session sql_mode=@tc_old_sql_mode, "
+    "character_set_client=@tc_old_character_set_client, "
+    "collation_connection=@tc_old_collation_connection");
 
+  if (tc_exec_sql_pipeline(dst_conn, create_list, ignore_errno_set, exec_info))
+    return 2;
   return 0;
 }
 
 /*
- use mysql client to restore node's schema
- return value
-   0 ok
-   1 error
+  get databases need to copy, exclude tc_skip_dump_db_list
 */
-int tc_restore_node_schema(
-        const char *host,
-        uint port,
-        const char *user,
-        const char *password,
-        const char *file)
+static int tc_get_copy_database_list(
+  MYSQL *src_conn,
+  vector<string> &db_list,
+  tc_exec_info *exec_info)
 {
-  string space = " ";
-  string restore_cmd, restore_bin, restore_options;
-#if defined (_WIN32)
-  restore_bin = "mysql";
-#else
-  restore_bin = mysql_home_ptr;
-  restore_bin += "/bin/mysql";
-#endif
-  restore_options += space + "-u" + user + space + "-p" + password + space + "-P" + to_string(port) + space + "-h" + host + "<" + file;
-  restore_cmd = restore_bin + restore_options + space + ">&" + file + ".err";
-
-  if (system(restore_cmd.c_str()) != 0)
-  {
-    sql_print_warning(ER(ER_TCADMIN_RESTORE_NODE_ERROR), host, port);
-    sql_print_warning("detail information in file %s.err", file);
+  set<string> skip_db_set;
+  vector<string> all_db_list;
+
+  skip_db_set.insert("information_schema");
+  skip_db_set.insert("performance_schema");
+  if (tc_skip_dump_db_list)
+  {
+    size_t pos = 0;
+    string dbs = tc_skip_dump_db_list;
+    string delimiter = ",";
+    while ((pos = dbs.find(delimiter)) != std::string::npos) {
+      skip_db_set.insert(dbs.substr(0, pos));
+      dbs.erase(0, pos + delimiter.length());
+    }
+    skip_db_set.insert(dbs);
+  }
+  if (tc_fetch_name_list(src_conn, "show databases", all_db_list, exec_info))
     return 1;
+  for (auto &db : all_db_list)
+  {
+    if (!skip_db_set.count(db))
+      db_list.push_back(db);
   }
-
-  sql_print_information("success restore schema to node %s#%d", host, port);
   return 0;
 }
+
+/*
+  copy node's schema to another node over client connection
+
+  @NOTE:
+    databases are copied by TC_NODE_SCHEMA_THREADS workers in parallel,
+    each with its own connection to both nodes. definitions are read by
+    SHOW CREATE and written to target node as multi-statement batches.
+    views are created at last and retried until all dependencies exist.
+
+  @retval
+    0 ok
+    1 error when read from source node
+    2 error when write to target node
+*/
+int tc_copy_node_schema(
+        const char *src_host,
+        uint src_port,
+        const char *src_user,
+        const char *src_password,
+        const char *dst_host,
+        uint dst_port,
+        const char *dst_user,
+        const char *dst_password)
+{
+  string src_ipport = string(src_host) + "#" + to_string(src_port);
+  string dst_ipport = string(dst_host) + "#" + to_string(dst_port);
+  vector<string> db_list;
+  vector<string> show_db_list;
+  vector<string> create_db_list;
+  vector<string> view_list;
+  set<uint> ignore_errno_set;
+  tc_exec_info exec_info;
+  string charset;
+  int result = 0;
+  size_t next_db = 0;
+  std::mutex mtx;
+  list<thread> thread_list;
+
+  MYSQL *src_conn = tc_conn_connect(src_ipport, src_user, src_password);
+  if (src_conn == NULL)
+  {
+    sql_print_warning(ER(ER_TCADMIN_DUMP_NODE_ERROR), src_host, src_port);
+    return 1;
+  }
+  MYSQL_GUARD(src_conn);
+  MYSQL *dst_conn = tc_conn_connect(dst_ipport, dst_user, dst_password);
+  if (dst_conn == NULL)
+  {
+    sql_print_warning(ER(ER_TCADMIN_RESTORE_NODE_ERROR), dst_host, dst_port);
+    return 2;
+  }
+  MYSQL_GUARD(dst_conn);
+  charset = tc_get_variable_value(src_conn, "character_set_server");
+
+  /* databases */
+  if (tc_exec_sql_without_result(src_conn, "set names " + charset, &exec_info) ||
+    tc_get_copy_database_list(src_conn, db_list, &exec_info))
+  {
+    result = 1;
+    goto finish;
+  }
+  for (auto &db : db_list)
+    show_db_list.push_back("show create database if not exists " + tc_quote_name(db));
+  create_db_list.push_back("set names " + charset);
+  if (tc_fetch_create_sql(src_conn, show_db_list, 1, 0, create_db_list, &exec_info))
+  {
+    result = 1;
+    goto finish;
+  }
+  if (tc_exec_sql_pipeline(dst_conn, create_db_list, ignore_errno_set, &exec_info))
+  {
+    result = 2;
+    goto finish;
+  }
+
+  /* tables, routines and triggers of every database */
+  for (ulong i = 0; i < TC_NODE_SCHEMA_THREADS && i < db_list.size(); i++)
+  {
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, [&]() {
+      tc_exec_info worker_info;
+      vector<string> worker_view_list;
+      int ret = 0;
+      MYSQL *src = tc_conn_connect(src_ipport, src_user, src_password);
+      MYSQL_GUARD(src);
+      MYSQL *dst = tc_conn_connect(dst_ipport, dst_user, dst_password);
+      MYSQL_GUARD(dst);
+      if (!src)
+      {
+        ret = 1;
+        worker_info.err_msg = "failed to connect to " + src_ipport;
+      }
+      else if (!dst)
+      {
+        ret = 2;
+        worker_info.err_msg = "failed to connect to " + dst_ipport;
+      }
+      else if (tc_exec_sql_without_result(src, "set names " + charset, &worker_info))
+        ret = 1;
+      else if (tc_exec_sql_without_result(dst, "set names " + charset, &worker_info))
+        ret = 2;
+
+      while (!ret)
+      {
+        string db;
+        {
+          std::lock_guard<std::mutex> lock(mtx);
+          if (result || next_db >= db_list.size())
+            break;
+          db = db_list[next_db++];
+        }
+        ret = tc_copy_database_schema(src, dst, db, worker_view_list, &worker_info);
+      }
+
+      std::lock_guard<std::mutex> lock(mtx);
+      view_list.insert(view_list.end(), worker_view_list.begin(), worker_view_list.end());
+      if (ret && !result)
+      {
+        result = ret;
+        exec_info = worker_info;
+      }
+    }));
+    thread_list.push_back(std::move(tmp_t));
+  }
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+  if (result)
+    goto finish;
+
+  /* views, retry the failed ones while some view is created in last round */
+  while (!view_list.empty())
+  {
+    vector<string> failed_list;
+    for (auto &view : view_list)
+    {/* CREATE ALGORITHM=... --> CREATE OR REPLACE ALGORITHM=... */
+      string create_sql = view;
+      if (!strncasecmp(create_sql.c_str(), "CREATE ", 7))
+        create_sql.insert(7, "OR REPLACE ");
+      if (tc_exec_sql_without_result(dst_conn, create_sql, &exec_info))
+        failed_list.push_back(view);
+    }
+    if (failed_list.size() == view_list.size())
+    {
+      exec_info.err_msg += ", sql is " + view_list.front();
+      result = 2;
+      goto finish;
+    }
+    view_list.swap(failed_list);
+  }
+
+finish:
+  if (result == 1)
+  {
+    sql_print_warning(ER(ER_TCADMIN_DUMP_NODE_ERROR), src_host, src_port);
+    sql_print_warning("TDBCTL: copy schema error %d %s", exec_info.err_code,
+      exec_info.err_msg.c_str());
+  }
+  else if (result == 2)
+  {
+    sql_print_warning(ER(ER_TCADMIN_RESTORE_NODE_ERROR), dst_host, dst_port);
+    sql_print_warning("TDBCTL: copy schema error %d %s", exec_info.err_code,
+      exec_info.err_msg.c_str());
+  }
+  else
+  {
+    sql_print_information("success copy schema of %lu databases from node %s#%d to node %s#%d",
+      (ulong)db_list.size(), src_host, src_port, dst_host, dst_port);
+  }
+  return result;
+}
@@ -8,7 +8,13 @@
 #include "my_global.h"
 #include "mysql.h"
 
-int tc_dump_node_schema(const char *host, uint port, const char *user, const char *password, const char *file);
-int tc_restore_node_schema(const char *host, uint port, const char *user, const char *password, const char *file);
+/* max threads to copy schema between nodes */
+#define TC_NODE_SCHEMA_THREADS 16
+/* max statements of one batch sent to node when copy schema */
+#define TC_NODE_SCHEMA_BATCH_SIZE 500
+
+int tc_copy_node_schema(const char *src_host, uint src_port, const char *src_user,
+  const char *src_password, const char *dst_host, uint dst_port, const char *dst_user,
+  const char *dst_password);
 
 #endif
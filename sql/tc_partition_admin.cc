@@ -23,12 +23,18 @@
 #include <regex>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <chrono>
 #include "tc_partition_admin.h"
 
 static PSI_memory_key key_memory_partition;
+/* TRUE while a round of add and delete partition is running */
+static std::atomic<bool> tc_partition_admin_round_running(false);
+
 void create_partition_admin_thread()
 {
-  std::thread t(tc_partition_admin_thread);
+  std::thread t(tc_thread_create(key_thread_tc_partition_admin,
+    tc_partition_admin_thread));
   t.detach();
 }
 
@@ -37,7 +43,7 @@ void create_partition_admin_thread()
 ADMIN partition for remote
 
 @input
-    step   0 for init ,1 for init ,add and delete
+    step   0 for init ,1 for add and delete
 */
 int tc_partition_admin_worker(int step)
 {
@@ -76,11 +82,8 @@ int tc_partition_admin_worker(int step)
   remote_conn_map = tc_remote_conn_connect(ret, remote_ipport_map,
     remote_user_map, remote_passwd_map);
   remote_server_name_map = get_server_name_map(&mem_root, MYSQL_WRAPPER, false);
-  tc_remote_admin_partition(tdbctl_primary_conn, remote_conn_map, remote_server_name_map, 0);
-  if (step)
-  {
-    tc_remote_admin_partition(tdbctl_primary_conn, remote_conn_map, remote_server_name_map, 1);
-  }
+  tc_remote_admin_partition(tdbctl_primary_conn, remote_conn_map,
+    remote_server_name_map, step);
 finish:
   tc_conn_free(remote_conn_map);
   if (tdbctl_primary_conn)
@@ -104,6 +107,255 @@ finish:
 
 
 
+/*
+  get partitions of all the configured tables on one remote in one query
+
+  @param
+    remote_db_list: remote_db of every config, same order as config_list
+  @param (out)
+    meta_map: key is remote_db.tb_name, value is PARTITION_DESCRIPTION in order,
+              tables without partition are not in the map
+  @retval
+    0 for ok, 2 for error and exec_info is set
+*/
+int tc_get_remote_partition_meta(MYSQL* mysql,
+  vector<TC_PARTITION_ADMIN_CONFIG>& config_list, vector<string>& remote_db_list,
+  map<string, vector<string> >& meta_map, tc_exec_info* exec_info)
+{
+  int result = 0;
+  string quotation = "\"";
+  set<string> db_set;
+  set<string> tb_set;
+  string db_in = "";
+  string tb_in = "";
+  for (size_t i = 0; i < config_list.size(); i++)
+  {
+    db_set.insert(remote_db_list[i]);
+    tb_set.insert(config_list[i].tb_name);
+  }
+  for (auto &db : db_set)
+    db_in += (db_in.empty() ? "" : ",") + quotation + db + quotation;
+  for (auto &tb : tb_set)
+    tb_in += (tb_in.empty() ? "" : ",") + quotation + tb + quotation;
+
+  string get_partition_sql = "select TABLE_SCHEMA,TABLE_NAME,PARTITION_DESCRIPTION "
+    " from information_schema.PARTITIONS where TABLE_SCHEMA in (" + db_in + ")"
+    " and TABLE_NAME in (" + tb_in + ") and PARTITION_NAME is NOT NULL and "
+    " PARTITION_EXPRESSION is NOT NULL order by TABLE_SCHEMA,TABLE_NAME,PARTITION_DESCRIPTION";
+
+  MYSQL_RES* res = tc_exec_sql_with_result(mysql, get_partition_sql);
+  //use to free result.
+  MYSQL_RES_GUARD(res);
+  if (res)
+  {
+    MYSQL_ROW row = NULL;
+    while ((row = mysql_fetch_row(res)))
+    {
+      if (!row[2])
+        continue;
+      meta_map[string(row[0]) + "." + row[1]].push_back(row[2]);
+    }
+  }
+  else
+  {
+    result = 2;
+    exec_info->err_code = mysql_errno(mysql);
+    exec_info->err_msg = mysql_error(mysql);
+  }
+  return result;
+}
+
+/*
+  check whether the remote is too busy to admin partition now
+
+  @param (out)
+    reason: why the remote is busy
+  @retval
+    true if Threads_running exceeds tc_partition_admin_max_threads_running
+    or replication lag exceeds tc_partition_admin_max_slave_lag
+*/
+bool tc_partition_admin_remote_busy(MYSQL *mysql, string &reason)
+{
+  bool busy = false;
+  if (tc_partition_admin_max_threads_running)
+  {
+    MYSQL_RES* res = tc_exec_sql_with_result(mysql,
+      "show global status like 'Threads_running'");
+    //use to free result.
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row = NULL;
+    if (res && (row = mysql_fetch_row(res)) && row[1] &&
+      strtoul(row[1], NULL, 10) > tc_partition_admin_max_threads_running)
+    {
+      reason = string("Threads_running is ") + row[1];
+      busy = true;
+    }
+  }
+  if (!busy && tc_partition_admin_max_slave_lag)
+  {
+    MYSQL_RES* res = tc_exec_sql_with_result(mysql, "show slave status");
+    //use to free result.
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row = NULL;
+    if (res && (row = mysql_fetch_row(res)))
+    {
+      MYSQL_FIELD *fields = mysql_fetch_fields(res);
+      for (uint i = 0; i < mysql_num_fields(res); i++)
+      {
+        if (!strcasecmp(fields[i].name, "Seconds_Behind_Master") && row[i] &&
+          strtoul(row[i], NULL, 10) > tc_partition_admin_max_slave_lag)
+        {
+          reason = string("Seconds_Behind_Master is ") + row[i];
+          busy = true;
+        }
+      }
+    }
+  }
+  return busy;
+}
+
+/*
+  start time of the remote in the partition admin window
+
+  @NOTE:
+    offset is derived from ip#port, so the remote starts at the same
+    point of the window in every round.
+*/
+time_t tc_partition_admin_start_time(time_t round_start, string ipport)
+{
+  if (tc_partition_admin_window == 0)
+    return round_start;
+  ha_checksum crc = my_checksum(0, (const uchar*)ipport.c_str(), ipport.length());
+  return round_start + (time_t)(crc % tc_partition_admin_window);
+}
+
+/*
+  admin partition for the tables on one remote
+
+  @NOTE:
+    every remote is handled by one worker at a time because the MYSQL*
+    can't be shared, and at most tc_partition_admin_host_threads remotes
+    of the same host are handled at the same time.
+    partitions of all the tables are got by one query per remote.
+    for add and delete, every remote starts at its jittered time in
+    tc_partition_admin_window, a busy remote is deferred by
+    TC_PARTITION_DEFER_TIME for at most TC_PARTITION_MAX_DEFER times,
+    then skipped in this round.
+*/
+static void tc_partition_admin_pool_worker(TC_PARTITION_ADMIN_POOL *pool)
+{
+  regex pattern(tdbctl_mysql_wrapper_prefix);
+  while (1)
+  {
+    string ipport = "";
+    string host = "";
+    {
+      std::unique_lock<std::mutex> lock(pool->mtx);
+      while (1)
+      {
+        list<string>::iterator its;
+        time_t now = time(0);
+        for (its = pool->pending_list.begin(); its != pool->pending_list.end(); its++)
+        {
+          string tmp_host = its->substr(0, its->find('#'));
+          if (pool->start_time_map[*its] <= now &&
+            pool->host_active_map[tmp_host] < tc_partition_admin_host_threads)
+          {
+            ipport = *its;
+            host = tmp_host;
+            pool->pending_list.erase(its);
+            break;
+          }
+        }
+        if (!ipport.empty() || pool->pending_list.empty())
+          break;
+        /* wake up for host released or start time of remote reached */
+        pool->cond.wait_for(lock, std::chrono::seconds(1));
+      }
+      if (ipport.empty())
+        return;
+      pool->host_active_map[host]++;
+    }
+
+    MYSQL *mysql = pool->remote_conn_map[ipport];
+    string server_name = pool->remote_server_name_map[ipport];
+    string busy_reason = "";
+    if (pool->step == 1 && tc_partition_admin_remote_busy(mysql, busy_reason))
+    {
+      std::lock_guard<std::mutex> lock(pool->mtx);
+      pool->host_active_map[host]--;
+      if (++pool->defer_count_map[ipport] <= TC_PARTITION_MAX_DEFER)
+      {/* defer the remote, try again later */
+        pool->start_time_map[ipport] = time(0) + TC_PARTITION_DEFER_TIME;
+        pool->pending_list.push_back(ipport);
+        pool->cond.notify_all();
+        continue;
+      }
+      /* skip the remote in this round, partitions are created ahead */
+      pool->skip_list.push_back(pair<string, string>(ipport, busy_reason));
+      tc_partition_admin_done += pool->config_list.size();
+      pool->cond.notify_all();
+      continue;
+    }
+
+    string hash_value = regex_replace(server_name, pattern, "");
+    vector<string> remote_db_list;
+    map<string, vector<string> > meta_map;
+    tc_exec_info exec_info;
+    int meta_ret = 0;
+    for (auto &config : pool->config_list)
+      remote_db_list.push_back(config.db_name + "_" + hash_value);
+    meta_ret = tc_get_remote_partition_meta(mysql, pool->config_list,
+      remote_db_list, meta_map, &exec_info);
+
+    for (size_t i = 0; i < pool->config_list.size(); i++)
+    {
+      TC_PARTITION_ADMIN_CONFIG &config = pool->config_list[i];
+      string remote_db = remote_db_list[i];
+      vector<string> &partition_list = meta_map[remote_db + "." + config.tb_name];
+      int ret = 0;
+      if (meta_ret)
+      {
+        tc_exec_info log_info;
+        ret = 2;
+        tc_partiton_log(pool->tdbctl_primary_conn, &log_info, remote_db,
+          config.tb_name, server_name, ipport, to_string(exec_info.err_code),
+          exec_info.err_msg, 0);
+      }
+      else if (pool->step == 0)
+      {
+        ret = tc_remote_new_partition(mysql, pool->tdbctl_primary_conn,
+          remote_db, config.tb_name, config.partition_column,
+          config.partition_column_type, config.interval_time,
+          config.remote_hash_algorithm, ipport, server_name, partition_list);
+      }
+      else if (pool->step == 1)
+      {
+        ret = tc_remote_add_del_partition(mysql, pool->tdbctl_primary_conn,
+          remote_db, config.tb_name, config.partition_column,
+          config.partition_column_type, config.interval_time,
+          config.remote_hash_algorithm, ipport, server_name,
+          config.expiration_time, partition_list);
+      }
+      else
+      {
+        ret = 1;
+      }
+      std::lock_guard<std::mutex> lock(pool->mtx);
+      if (ret)
+        pool->result_list[i] = ret;
+      if (pool->step == 1)
+        tc_partition_admin_done++;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(pool->mtx);
+      pool->host_active_map[host]--;
+    }
+    pool->cond.notify_all();
+  }
+}
+
 /*
  ADMIN partition for remote from  cluster_admin.tc_partiton_admin_config
 
@@ -114,6 +366,10 @@ finish:
       step                   : 0 for init ,1 for add and delete
   output:
       result                 : 0 for ok 
+
+  @NOTE:
+    (table, remote) items are handled by at most tc_partition_admin_threads
+    workers, progress of add and delete is shown by Tc_partition_admin_done/total
 */
 int tc_remote_admin_partition(MYSQL *tdbctl_primary_conn,
   map<string, MYSQL*> remote_conn_map,
@@ -122,7 +378,10 @@ int tc_remote_admin_partition(MYSQL *tdbctl_primary_conn,
 {
   int result = 0;
   map<string, MYSQL*>::iterator its;
-  regex pattern(tdbctl_mysql_wrapper_prefix); 
+  TC_PARTITION_ADMIN_POOL pool;
+  list<thread> thread_list;
+  ulong thread_num = tc_partition_admin_threads;
+  time_t round_start = time(0);
 
   /*
   init for update SQL in TDBCTL
@@ -161,77 +420,99 @@ int tc_remote_admin_partition(MYSQL *tdbctl_primary_conn,
   MYSQL_RES* res = tc_exec_sql_with_result(tdbctl_primary_conn, get_partition_sql);
   //use to free result.
   MYSQL_RES_GUARD(res);
-  if (res)
+  if (!res)
   {
-    MYSQL_ROW row = NULL;
-    /*
-    new partition for every unpartitioned table
-    */
-    while ((row = mysql_fetch_row(res)))
+    result = 2;
+    sql_print_warning("PARTITION_ADMIN:fail to select cluster_admin.tc_partiton_admin_config");
+    return result;
+  }
+
+  MYSQL_ROW row = NULL;
+  while ((row = mysql_fetch_row(res)))
+  {
+    TC_PARTITION_ADMIN_CONFIG config;
+    config.db_name = row[0];
+    config.tb_name = row[1];
+    config.partition_column = row[2];
+    config.expiration_time = atoi(row[3]);
+    config.partition_column_type = row[4];
+    config.interval_time = atoi(row[5]);
+    config.remote_hash_algorithm = row[6];
+    pool.config_list.push_back(config);
+    pool.result_list.push_back(0);
+  }
+  if (pool.config_list.empty())
+    return result;
+
+  pool.step = step;
+  pool.tdbctl_primary_conn = tdbctl_primary_conn;
+  pool.remote_conn_map = remote_conn_map;
+  pool.remote_server_name_map = remote_server_name_map;
+  for (its = remote_conn_map.begin(); its != remote_conn_map.end(); its++)
+  {
+    pool.pending_list.push_back(its->first);
+    pool.start_time_map[its->first] = step == 1 ?
+      tc_partition_admin_start_time(round_start, its->first) : round_start;
+  }
+
+  if (step == 1)
+  {
+    tc_partition_admin_total = pool.config_list.size() * remote_conn_map.size();
+    tc_partition_admin_done = 0;
+  }
+
+  /*
+  new/add/delete partition for every (table, remote)
+  */
+  if (thread_num > remote_conn_map.size())
+    thread_num = remote_conn_map.size();
+  for (ulong i = 0; i < thread_num; i++)
+  {
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_partition_admin_pool_worker,
+      &pool));
+    thread_list.push_back(std::move(tmp_t));
+  }
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+
+  for (auto &skip : pool.skip_list)
+  {
+    regex pattern(tdbctl_mysql_wrapper_prefix);
+    string server_name = remote_server_name_map[skip.first];
+    string hash_value = regex_replace(server_name, pattern, "");
+    sql_print_warning("PARTITION_ADMIN: skip %s in this round, %s",
+      skip.first.c_str(), skip.second.c_str());
+    for (auto &config : pool.config_list)
     {
-      string db_name = row[0];
-      string tb_name = row[1];
-      string db_partition_columnname = row[2];
-      int expiration_time = atoi(row[3]);
-      string partition_column_type = row[4];
-      int interval_time = atoi(row[5]);
-      string remote_hash_algorithm = row[6];
       tc_exec_info exec_info;
-      update_config_sql = "";
+      tc_partiton_log(tdbctl_primary_conn, &exec_info,
+        config.db_name + "_" + hash_value, config.tb_name, server_name,
+        skip.first, "1", "skipped, remote is busy: " + skip.second, 0);
+    }
+  }
 
+  for (size_t i = 0; i < pool.config_list.size(); i++)
+  {
+    TC_PARTITION_ADMIN_CONFIG &config = pool.config_list[i];
+    tc_exec_info exec_info;
+    result = pool.result_list[i] ? pool.result_list[i] : result;
+    if (pool.result_list[i] == 0 && step == 0)
+    {
       /*
-      new partition for every  remote
+      init for update config SQL in TDBCTL
       */
-      for (its = remote_conn_map.begin(); its != remote_conn_map.end(); its++) 
+      update_config_sql = update_sql_cur + quotation + config.db_name + quotation + " and tb_name= "
+        + quotation + config.tb_name + quotation;
+      if (tc_exec_sql_without_result(tdbctl_primary_conn, update_config_sql, &exec_info))
       {
-        string ipport = its->first;
-        MYSQL* mysql = its->second;
-        string server_name = remote_server_name_map[ipport];        
-        string hash_value = regex_replace(server_name, pattern, "");
-        string remote_db = db_name + "_" + hash_value;
-        int ret = 0;
-        if (step == 0)
-        {
-          ret = tc_remote_new_partition(mysql, tdbctl_primary_conn,
-            remote_db, tb_name, db_partition_columnname, partition_column_type,
-              interval_time, remote_hash_algorithm, ipport, server_name);
-        }
-        else if (step == 1)
-        {
-          ret = tc_remote_add_del_partition(mysql, tdbctl_primary_conn,
-            remote_db, tb_name, db_partition_columnname, partition_column_type,
-            interval_time, remote_hash_algorithm, ipport, server_name, expiration_time);
-        }
-        else
-        {
-          ret = 1;
-        }
-        result = ret ? ret : result;      
-      }
-
-      if (result ==0 && step==0)
-      {
-        /*
-        init for update config SQL in TDBCTL
-        */
-        update_config_sql = update_sql_cur + quotation + db_name + quotation + " and tb_name= "
-          + quotation + tb_name + quotation;
-        if (tc_exec_sql_without_result(tdbctl_primary_conn, update_config_sql, &exec_info))
-        {
-          sql_print_warning("PARTITION_ADMIN:fail to  update  in  cluster_admin.tc_partiton_admin_config : %02d %s",
-            exec_info.err_code, (char*)(exec_info.err_msg.data()));
-          exec_info.err_code = 0;
-          exec_info.row_affect = 0;
-          exec_info.err_msg = "";
-        }     
+        sql_print_warning("PARTITION_ADMIN:fail to  update  in  cluster_admin.tc_partiton_admin_config : %02d %s",
+          exec_info.err_code, (char*)(exec_info.err_msg.data()));
       }
     }
   }
-  else
-  {
-    result = 2;
-    sql_print_warning("PARTITION_ADMIN:fail to select cluster_admin.tc_partiton_admin_config");
-  }
   return result;
 }
 
@@ -268,69 +549,10 @@ PARTITION_ALGORITHM_TYPE get_partition_algorithm_type(string remote_hash_algorit
   return partition_type;
 }
 
-int get_min_partition(MYSQL* mysql, string remote_db, string tb_name, string& min_partition) 
-{
-  int result = 0;
-  string quotation = "\"";
-  //init for select min partition sql
-  string get_min_partition_sql = "select min(PARTITION_DESCRIPTION) "
-    " from information_schema.PARTITIONS where TABLE_SCHEMA=";
-  get_min_partition_sql += quotation + remote_db + quotation;
-  get_min_partition_sql += " and TABLE_NAME= " + quotation + tb_name + quotation;
-  get_min_partition_sql += " and PARTITION_NAME is NOT NULL and PARTITION_EXPRESSION is "
-    " NOT NULL order by PARTITION_DESCRIPTION";
-
-  MYSQL_RES* res = tc_exec_sql_with_result(mysql, get_min_partition_sql);
-  //use to free result.
-  MYSQL_RES_GUARD(res);
-  MYSQL_ROW row = NULL;
-  if (res && (row = mysql_fetch_row(res)))
-  {
-    min_partition = row[0];
-  }
-  else
-  {
-    result = 2;
-  }
-  return result;
-}
-
-
-int get_min_max_partition(MYSQL* mysql, string remote_db, string tb_name, string& min_partition,
-  string& max_partition) 
-{
-  int result = 0;
-  string quotation = "\"";
-  //init for select min max partition sql
-  string get_min_max_partition_sql = "select min(PARTITION_DESCRIPTION),max(PARTITION_DESCRIPTION) "
-    " from information_schema.PARTITIONS where TABLE_SCHEMA=";
-  get_min_max_partition_sql += quotation + remote_db + quotation;
-  get_min_max_partition_sql += " and TABLE_NAME= " + quotation + tb_name + quotation;
-  get_min_max_partition_sql += " and PARTITION_NAME is NOT NULL and PARTITION_EXPRESSION is "
-    " NOT NULL order by PARTITION_DESCRIPTION";
-
-  MYSQL_RES* res = tc_exec_sql_with_result(mysql, get_min_max_partition_sql);
-  //use to free result.
-  MYSQL_RES_GUARD(res);
-  MYSQL_ROW row = NULL;
-  if (res && (row = mysql_fetch_row(res)))
-  {
-    min_partition = row[0];
-    max_partition = row[1];
-  }
-  else
-  {
-    result = 2;
-  }
-  return result;
-}
-
-
-
 /*
 get time diff(unit:day),between str and now
 */
-int get_time_diff(string str)
+int get_time_diff_signed(string str)
 {
   time_t to_tm_time = (time_t)time((time_t*)0);
   time_t timer_new;
@@ -355,20 +577,29 @@ int get_time_diff(string str)
   //get time_diff
   double diff_t = difftime(to_tm_time, timer_new);
   int t1 = static_cast<int>(diff_t / TERM);
-  t1 = abs(t1);
   return t1;
 }
 
+/*
+get time diff(unit:day),between str and now
+*/
+int get_time_diff(string str)
+{
+  return abs(get_time_diff_signed(str));
+}
+
 /*
 add and delete partition for remote from  cluster_admin.tc_partiton_admin_config
 */
 int tc_remote_add_del_partition(MYSQL* mysql, MYSQL* tdbctl_primary_conn,
   string remote_db, string tb_name, string  db_partition_columnname,
   string partition_column_type, int interval_time, string remote_hash_algorithm,
-  string ipport, string server_name, int expiration_time)
+  string ipport, string server_name, int expiration_time,
+  vector<string>& partition_list)
 {
   int result = 0;
-  int count = 0;
+  int count = partition_list.size();
+  ulonglong start_time = my_micro_time();
   tc_exec_info exec_info;
   stringstream ss;
 
@@ -385,45 +616,32 @@ int tc_remote_add_del_partition(MYSQL* mysql, MYSQL* tdbctl_primary_conn,
   int inter_min = 0;
   int inter_max = 0;
 
-  if (check_table_is_partitioned(mysql, remote_db, tb_name, &exec_info, count))
-  {
-    ss.str("");
-    ss << exec_info.err_code;
-    error_code = ss.str();
-    message = exec_info.err_msg;
-    exec_info.err_code = 0;
-    exec_info.row_affect = 0;
-    exec_info.err_msg = "";
-    result = 2;
-    goto finish;
-  }
-  else if (count <= 0)
+  if (count <= 0)
   {
     error_code = "1";
     message = "no partition";
     result = 2;
     goto finish;
   }
-  if (get_min_max_partition(mysql, remote_db, tb_name, min_partition, max_partition))
-  {
-    ss.str("");
-    ss << exec_info.err_code;
-    error_code = ss.str();
-    message = exec_info.err_msg;
-    exec_info.err_code = 0;
-    exec_info.row_affect = 0;
-    exec_info.err_msg = "";
-    result = 2;
-    goto finish;
-  }
+  min_partition = partition_list.front();
+  max_partition = partition_list.back();
 
   inter_min = get_time_diff(min_partition);
-  inter_max = get_time_diff(max_partition);
-  if (inter_max <= 40)
+  /* days the max partition is ahead of now, negative if behind */
+  inter_max = -get_time_diff_signed(max_partition);
+  if (inter_max <= (int)tc_partition_admin_precreate_days)
   {
+    /*
+      add at least 3 partitions, and enough to cover
+      tc_partition_admin_precreate_days after missed runs
+    */
+    int add_num = ((int)tc_partition_admin_precreate_days - inter_max) /
+      (interval_time > 0 ? interval_time : 1) + 1;
+    add_num = add_num < 3 ? 3 : add_num;
+    add_num = add_num > TC_PARTITION_MAX_ADD_NUM ? TC_PARTITION_MAX_ADD_NUM : add_num;
     add_partition_sql = tc_create_add_partition_sql(remote_db, tb_name, 
       db_partition_columnname, partition_column_type, interval_time,
-      remote_hash_algorithm, max_partition);
+      remote_hash_algorithm, max_partition, add_num);
     if (tc_exec_sql_without_result(mysql, add_partition_sql, &exec_info))
     {
       result = 2;
@@ -446,16 +664,11 @@ int tc_remote_add_del_partition(MYSQL* mysql, MYSQL* tdbctl_primary_conn,
       del_total = 1;
     }
     del_total = del_total - 3 > 0 ? 3 : del_total;
-    while (del_total>0) {
-      if(tc_create_del_partition_sql(mysql, remote_db, tb_name,
-        db_partition_columnname, partition_column_type,
-        interval_time, remote_hash_algorithm, del_partition_sql))
-      {
-        error_code = 1;
-        message = "fail to get min from information_schema.PARTITIONS";
-        result = 2;
-        goto finish;
-      }
+    //keep the last partition
+    del_total = del_total >= count ? count - 1 : del_total;
+    for (int i = 0; i < del_total; i++) {
+      del_partition_sql = tc_create_del_partition_sql(remote_db, tb_name,
+        partition_list[i]);
       retry = 3;
       while (retry > 0)
       {
@@ -480,13 +693,12 @@ int tc_remote_add_del_partition(MYSQL* mysql, MYSQL* tdbctl_primary_conn,
       {
         goto finish;
       }
-      --del_total;
     }
   }
 
 finish:
   if (tc_partiton_log(tdbctl_primary_conn, &exec_info, remote_db, tb_name,
-    server_name, ipport, error_code, message))
+    server_name, ipport, error_code, message, my_micro_time() - start_time))
   {
     result = 2;
     exec_info.err_code = 0;
@@ -553,14 +765,14 @@ init SQL for add partition
 */
 string tc_create_add_partition_sql(string remote_db, string tb_name,
   string db_partition_columnname, string partition_column_type,
-  int interval_time, string remote_hash_algorithm, string max_partition) 
+  int interval_time, string remote_hash_algorithm, string max_partition,
+  int add_partition_num) 
 {
   string alter_sql = "alter table " + remote_db + "." + tb_name + " add partition(";
   string partition_sql = " partition by " + remote_hash_algorithm;
   string values_sql = "";
   string add_partition_sql = "";
 
-  int add_partition_num = 3;
   struct tm l_time_new ;
 
   char time_string[30] = { 0 };
@@ -620,31 +832,34 @@ string tc_create_add_partition_sql(string remote_db, string tb_name,
 
 /*
 init sql for delete partition
+partition_description is PARTITION_DESCRIPTION of the partition to drop
 */
-int tc_create_del_partition_sql(MYSQL* mysql, string remote_db, string tb_name,
-  string db_partition_columnname, string partition_column_type,
-  int interval_time, string remote_hash_algorithm, string& del_sql)
+string tc_create_del_partition_sql(string remote_db, string tb_name,
+  string partition_description)
 {
-  int result = 0;
-  string quotation = "\"";
-  string min_partition = "";
-  if (get_min_partition(mysql, remote_db, tb_name, min_partition))
-  {
-    result = 2;
-    return result;
-  }
-  min_partition=get_time_string(min_partition);
-  del_sql = "alter table ";
+  string del_sql = "alter table ";
   del_sql += remote_db + "." + tb_name;
-  del_sql += " drop partition p"+ min_partition;
-  return result;
+  del_sql += " drop partition p" + get_time_string(partition_description);
+  return del_sql;
 }
 
+/*
+  log the result of one (table, remote) item
+
+  @NOTE:
+    called by the partition admin workers, tdbctl_primary_conn is shared
+    between them, so the insert is serialized.
+
+  @param
+    cost: time used by the item, in microseconds
+*/
 int tc_partiton_log(MYSQL* tdbctl_primary_conn, tc_exec_info* exec_info,
   string db, string tb_name, string server_name, string ipport,
-  string error_code, string message) 
+  string error_code, string message, ulonglong cost) 
 {
+  static std::mutex log_mutex;
   int result = 0;
+  char cost_buf[64];
   //cluster_admin.tc_partiton_admin_log need not sync to slave
   string log_sql = "set sql_log_bin=0;insert into cluster_admin.tc_partiton_admin_log( "
     " db_name,tb_name,server_name,host,code,message) values(";
@@ -655,8 +870,10 @@ int tc_partiton_log(MYSQL* tdbctl_primary_conn, tc_exec_info* exec_info,
   log_sql += quotation + server_name + quotation + ",";
   log_sql += quotation + ipport + quotation + ",";
   log_sql += error_code + ",";
-  log_sql += quotation + message + quotation + ")";
+  snprintf(cost_buf, sizeof(cost_buf), " (cost %llums)", cost / 1000);
+  log_sql += quotation + message + cost_buf + quotation + ")";
 
+  std::lock_guard<std::mutex> lock(log_mutex);
   if (tc_exec_sql_without_result(tdbctl_primary_conn, log_sql, exec_info))
   {
     result = 2;
@@ -672,10 +889,11 @@ init partition for remote from  cluster_admin.tc_partiton_admin_config
 int tc_remote_new_partition(MYSQL* mysql, MYSQL* tdbctl_primary_conn,
   string remote_db, string tb_name, string  db_partition_columnname,
   string partition_column_type, int interval_time, string remote_hash_algorithm,
-  string ipport,string server_name) 
+  string ipport,string server_name, vector<string>& partition_list) 
 {
   int result = 0;
-  int count = 0;
+  int count = partition_list.size();
+  ulonglong start_time = my_micro_time();
   tc_exec_info exec_info;
   stringstream ss;
   
@@ -686,19 +904,7 @@ int tc_remote_new_partition(MYSQL* mysql, MYSQL* tdbctl_primary_conn,
   //init for alter sql
   string alter_sql = "";
 
-  if (check_table_is_partitioned(mysql, remote_db, tb_name, &exec_info, count)) 
-  {
-    ss.str("");
-    ss << exec_info.err_code;
-    error_code = ss.str();
-    message = exec_info.err_msg;
-    exec_info.err_code = 0;
-    exec_info.row_affect = 0;
-    exec_info.err_msg = "";
-    result = 2;
-    goto finish;
-  }
-  else if (count > 0)
+  if (count > 0)
   {
     message = "already has partition,do nothing";
     goto finish;
@@ -721,7 +927,7 @@ int tc_remote_new_partition(MYSQL* mysql, MYSQL* tdbctl_primary_conn,
 
 finish:
   if (tc_partiton_log(tdbctl_primary_conn,&exec_info, remote_db, tb_name,
-    server_name, ipport, error_code, message))
+    server_name, ipport, error_code, message, my_micro_time() - start_time))
   {
     result = 2;
     exec_info.err_code = 0;
@@ -809,34 +1015,6 @@ string tc_create_alter_sql(string remote_db, string tb_name,
   return alter_sql;
 }
 
-int check_table_is_partitioned(MYSQL* mysql, string remote_db, string tb_name,
-  tc_exec_info *exec_info,int& count)
-{
-  int result = 0;
-  string quotation = "\"";
-  string check_sql_cur1 = "select count(*) from information_schema.PARTITIONS "
-    "where TABLE_SCHEMA=";
-  string check_sql_cur2 = " and PARTITION_NAME is NOT NULL and "
-    " PARTITION_EXPRESSION is NOT NULL order by PARTITION_DESCRIPTION";
-  string remote_db_table_sql = quotation + remote_db +
-    quotation + " and TABLE_NAME=" + quotation + tb_name + quotation;
-  string check_sql = check_sql_cur1 + remote_db_table_sql + check_sql_cur2;
-  MYSQL_RES* res = tc_exec_sql_with_result(mysql, check_sql);
-  //use to free result.
-  MYSQL_RES_GUARD(res);
-  MYSQL_ROW row = NULL;
-  if (res && (row = mysql_fetch_row(res)))
-  {
-    count = row[0] ? atoi(row[0]) : 0;
-  }
-  else
-  {
-    result = 2;
-    tc_exec_sql_without_result(mysql, check_sql, exec_info);
-  } 
-  return result;
-}
-
 /*
 do tc_partition_admin_worker if current time equals to  tc_partition_admin_time
 */
@@ -857,14 +1035,26 @@ bool get_time_flag()
   return flag;
 }
 
+/*
+  a round of add and delete partition, run apart from
+  tc_partition_admin_thread so that init partition is not blocked by
+  tc_partition_admin_window and the deferral of busy remotes
+*/
+static void tc_partition_admin_round()
+{
+  tc_partition_admin_worker(1);
+  tc_partition_admin_round_running = false;
+}
+
 /*
 ADMIN partition for remote
 1.read config table
 2.if no partition,init partition
-3.if multi-partition , add and delete partition
+3.if multi-partition , add and delete partition, at most one round at a time
 */
 void tc_partition_admin_thread()
 {
+  tc_latency_cur_op = TC_LATENCY_OP_DDL;
   while (1)
   {
     /* TODO:get tc_tdbctl_conn_primary by host and port */
@@ -885,7 +1075,18 @@ void tc_partition_admin_thread()
         if (i == tc_partition_admin_interval || get_time_flag())
         {
           //ADMIN partition for cluster
-          tc_partition_admin_worker(1);
+          tc_partition_admin_worker(0);
+          if (tc_partition_admin_round_running.exchange(true))
+          {
+            sql_print_warning("PARTITION_ADMIN: last round of add and delete "
+              "partition is still running, skip this round");
+          }
+          else
+          {
+            std::thread t(tc_thread_create(key_thread_tc_partition_admin,
+              tc_partition_admin_round));
+            t.detach();
+          }
           i = 0;
         }
         sleep(1);
@@ -11,6 +11,10 @@
 #include <set>
 #include <sstream>
 #include <regex>
+#include <list>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
 #include "mysql.h"
 using namespace std;
 
@@ -39,6 +43,51 @@ PARTITION_ALGORITHM_TYPE get_partition_algorithm_type(string remote_hash_algorit
 //second of one day
 const int TERM = 86400;
 
+/* seconds to wait before check a busy remote again */
+#define TC_PARTITION_DEFER_TIME 60
+/* times a busy remote is deferred before skipped in the round */
+#define TC_PARTITION_MAX_DEFER 10
+/* max partitions added to a table in one round */
+#define TC_PARTITION_MAX_ADD_NUM 31
+
+/* one row of cluster_admin.tc_partiton_admin_config */
+typedef struct tc_partition_admin_config
+{
+  string db_name;
+  string tb_name;
+  string partition_column;
+  string partition_column_type;
+  string remote_hash_algorithm;
+  int expiration_time;
+  int interval_time;
+} TC_PARTITION_ADMIN_CONFIG;
+
+/*
+work shared by the partition admin workers
+pending_list: ip#port of remotes not handled yet
+host_active_map: ip-->count of remotes being handled on the host
+start_time_map: ip#port-->time the remote can be handled from
+defer_count_map: ip#port-->times the remote is deferred for busy
+skip_list: ip#port and reason of remotes skipped for busy
+result_list: result of every config, 0 for ok on all remotes
+*/
+typedef struct tc_partition_admin_pool
+{
+  int step;
+  MYSQL *tdbctl_primary_conn;
+  map<string, MYSQL*> remote_conn_map;
+  map<string, string> remote_server_name_map;
+  vector<TC_PARTITION_ADMIN_CONFIG> config_list;
+  vector<int> result_list;
+  list<string> pending_list;
+  map<string, ulong> host_active_map;
+  map<string, time_t> start_time_map;
+  map<string, int> defer_count_map;
+  list<pair<string, string> > skip_list;
+  std::mutex mtx;
+  std::condition_variable cond;
+} TC_PARTITION_ADMIN_POOL;
+
 void create_partition_admin_thread();
 void tc_partition_admin_thread();
 int tc_partition_admin_worker(int step);
@@ -57,7 +106,7 @@ init partition for remote from  mysql.tc_partiton_admin_config
 int tc_remote_new_partition(MYSQL* mysql, MYSQL* tdbctl_primary_conn,
   string remote_db, string tb_name, string  db_partition_columnname,
   string partition_column_type, int interval_time, string remote_hash_algorithm,
-  string ipport, string server_name);
+  string ipport, string server_name, vector<string>& partition_list);
 
 /*
 add and delete partition for remote from  mysql.tc_partiton_admin_config
@@ -65,26 +114,31 @@ add and delete partition for remote from  mysql.tc_partiton_admin_config
 int tc_remote_add_del_partition(MYSQL* mysql, MYSQL* tdbctl_primary_conn,
   string remote_db, string tb_name, string  db_partition_columnname,
   string partition_column_type, int interval_time, string remote_hash_algorithm,
-  string ipport, string server_name, int expiration_time);
+  string ipport, string server_name, int expiration_time,
+  vector<string>& partition_list);
 
-int check_table_is_partitioned(MYSQL* mysql, string remote_db, string tb_name,
-  tc_exec_info *exec_info, int& count);
-int get_min_max_partition(MYSQL* mysql, string remote_db, string tb_name,
-  string& min_partition, string& max_partition, tc_exec_info* exec_info);
+/*
+get partitions of all the configured tables on a remote in one query
+*/
+int tc_get_remote_partition_meta(MYSQL* mysql,
+  vector<TC_PARTITION_ADMIN_CONFIG>& config_list, vector<string>& remote_db_list,
+  map<string, vector<string> >& meta_map, tc_exec_info* exec_info);
 int tc_partiton_log(MYSQL* tdbctl_primary_conn, tc_exec_info* exec_info, string db, string tb_name,
-  string server_name, string ipport, string error_code, string message);
+  string server_name, string ipport, string error_code, string message,
+  ulonglong cost);
 
 /*
 init sql for add partition 
 */
 string tc_create_add_partition_sql(string remote_db, string tb_name, string db_partition_columnname,
-  string partition_column_type, int interval_time, string remote_hash_algorithm, string max_partition);
+  string partition_column_type, int interval_time, string remote_hash_algorithm, string max_partition,
+  int add_partition_num);
 
 /*
 init sql for delete partition
 */
-int tc_create_del_partition_sql(MYSQL* mysql, string remote_db, string tb_name, string db_partition_columnname,
-  string partition_column_type, int interval_time, string remote_hash_algorithm, string& del_sql);
+string tc_create_del_partition_sql(string remote_db, string tb_name,
+  string partition_description);
 
 /*
 init sql for new partition
@@ -92,5 +146,8 @@ init sql for new partition
 string tc_create_alter_sql(string remote_db, string tb_name, string partition_column_type,
   int interval_time, string remote_hash_algorithm, string  db_partition_columnname);
 
+bool tc_partition_admin_remote_busy(MYSQL *mysql, string &reason);
+time_t tc_partition_admin_start_time(time_t round_start, string ipport);
+
 string get_time_string(string str);
 #endif /* TC_PARTITION_ADMIN_INCLUDED */
\ No newline at end of file
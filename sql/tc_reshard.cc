@@ -0,0 +1,1025 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+/*
+  Online reshard of spider table, see tc_reshard.h
+*/
+#include "sql_base.h"
+#include "sql_class.h"
+#include "sql_parse.h"
+#include "tc_base.h"
+#include "log.h"
+#include "sql_servers.h"
+#include "protocol.h"
+#include "tc_schema_catalog.h"
+#include "tc_reshard.h"
+#include <thread>
+#include <chrono>
+#include <list>
+#include <set>
+#include <algorithm>
+
+/*
+  connect to node, rows are copied as bytes without charset conversion
+
+  @retval
+    connection, NULL if error and err_msg is set
+*/
+static MYSQL *tc_reshard_connect(TC_RESHARD_NODE &node, string &err_msg)
+{
+  tc_exec_info exec_info;
+  MYSQL *mysql = tc_conn_connect(node.ipport, node.user, node.passwd);
+  if (!mysql)
+  {
+    err_msg = node.server_name + ": connect failed";
+    return NULL;
+  }
+  if (tc_exec_sql_without_result(mysql, "SET NAMES binary", &exec_info))
+  {
+    err_msg = node.server_name + ": " + exec_info.err_msg;
+    mysql_close(mysql);
+    return NULL;
+  }
+  return mysql;
+}
+
+/*
+  execute sql on node by a new connection
+
+  @retval
+    FALSE ok
+    TRUE error, err_msg is set
+*/
+static bool tc_reshard_exec(TC_RESHARD_NODE &node, string sql, string &err_msg)
+{
+  tc_exec_info exec_info;
+  MYSQL *mysql = tc_reshard_connect(node, err_msg);
+  MYSQL_GUARD(mysql);
+  if (!mysql)
+    return TRUE;
+  if (tc_exec_sql_without_result(mysql, sql, &exec_info))
+  {
+    err_msg = node.server_name + ": " + exec_info.err_msg;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/* new shard of the shard key value, -1 if no shard */
+static longlong tc_reshard_shard_of(TC_RESHARD_CONTEXT *ctx, const char *key,
+  ulong length)
+{
+  longlong shard;
+  if (!key)
+    return -1;
+  shard = tc_route_shard_by_str(ctx->rule, key, length, ctx->key_cs);
+  if (shard >= (longlong)ctx->target_list.size())
+    return -1;
+  return shard;
+}
+
+/* append row as (v1, v2, ...) to the values of its new shard */
+static bool tc_reshard_route_row(TC_RESHARD_CONTEXT *ctx, MYSQL_ROW row,
+  ulong *lengths, vector<string> &values_list, string &err_msg)
+{
+  longlong shard = tc_reshard_shard_of(ctx, row[ctx->key_pos],
+    lengths[ctx->key_pos]);
+  if (shard < 0)
+  {
+    err_msg = "no new shard for key " +
+      (row[ctx->key_pos] ? string(row[ctx->key_pos], lengths[ctx->key_pos]) : "NULL");
+    return TRUE;
+  }
+
+  string &values = values_list[shard];
+  values += (values.empty() ? "(" : ",(");
+  for (size_t i = 0; i < ctx->column_list.size(); i++)
+  {
+    if (i)
+      values += ",";
+    tc_append_quoted_value(values, row[i], lengths[i]);
+  }
+  values += ")";
+  return FALSE;
+}
+
+/*
+  write rows to new shards by REPLACE, values_list is cleared
+
+  @retval
+    FALSE ok
+    TRUE error, err_msg is set
+*/
+static bool tc_reshard_write_rows(TC_RESHARD_CONTEXT *ctx,
+  vector<MYSQL*> &target_conns, vector<string> &values_list, string &err_msg)
+{
+  tc_exec_info exec_info;
+  for (size_t i = 0; i < values_list.size(); i++)
+  {
+    if (values_list[i].empty())
+      continue;
+    TC_RESHARD_NODE &target = ctx->target_list[i];
+    if (!target_conns[i] &&
+      !(target_conns[i] = tc_reshard_connect(target, err_msg)))
+      return TRUE;
+    string sql = "REPLACE INTO " + tc_quote_name(target.db_name) + "." +
+      tc_quote_name(TC_RESHARD_NEW_PREFIX + ctx->tb_name) +
+      " (" + ctx->column_sql + ") VALUES " + values_list[i];
+    if (tc_exec_sql_without_result(target_conns[i], sql, &exec_info))
+    {
+      err_msg = target.server_name + ": " + exec_info.err_msg;
+      return TRUE;
+    }
+    values_list[i].clear();
+  }
+  return FALSE;
+}
+
+/*
+  copy rows of old shard by primary key chunks
+
+  @retval
+    FALSE ok
+    TRUE error, src->error is set
+*/
+static bool tc_reshard_copy(TC_RESHARD_CONTEXT *ctx, TC_RESHARD_SOURCE *src,
+  MYSQL *src_conn, vector<MYSQL*> &target_conns)
+{
+  string table = tc_quote_name(src->node.db_name) + "." +
+    tc_quote_name(ctx->src_tb_name);
+  vector<string> values_list(ctx->target_list.size());
+  vector<string> pk_column_list;
+  vector<string> last_pk;
+
+  for (auto &column : ctx->pk_list)
+    pk_column_list.push_back(tc_quote_name(column));
+  while (!ctx->abort)
+  {
+    ulonglong rows = 0;
+    string sql = "SELECT " + ctx->column_sql + " FROM " + table;
+    if (!last_pk.empty())
+      sql += " WHERE " + tc_row_greater_sql(pk_column_list, last_pk);
+    sql += " ORDER BY " + ctx->pk_sql + " LIMIT " + to_string(ctx->chunk_size);
+
+    MYSQL_RES *res = tc_exec_sql_with_result(src_conn, sql);
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row;
+    ulong *lengths;
+    if (!res)
+    {
+      src->error = src->node.server_name + ": " + mysql_error(src_conn);
+      return TRUE;
+    }
+    while ((row = mysql_fetch_row(res)))
+    {
+      lengths = mysql_fetch_lengths(res);
+      if (tc_reshard_route_row(ctx, row, lengths, values_list, src->error))
+        return TRUE;
+      rows++;
+    }
+    if (tc_reshard_write_rows(ctx, target_conns, values_list, src->error))
+      return TRUE;
+    src->rows_copied += rows;
+    if (rows < ctx->chunk_size)
+      return FALSE;
+
+    /* primary key of the last row is where the next chunk begins */
+    mysql_data_seek(res, rows - 1);
+    row = mysql_fetch_row(res);
+    lengths = mysql_fetch_lengths(res);
+    last_pk.assign(ctx->pk_pos.size(), "");
+    for (size_t i = 0; i < ctx->pk_pos.size(); i++)
+      tc_append_quoted_value(last_pk[i], row[ctx->pk_pos[i]],
+        lengths[ctx->pk_pos[i]]);
+  }
+  return FALSE;
+}
+
+/*
+  apply one batch of change log of old shard, rows of the logged primary
+  keys are deleted from new shards and copied again from old shard, then
+  the log rows are removed
+
+  @NOTE:
+    log rows are removed by id instead of range, id of transaction not
+    committed yet may be less than ids applied
+
+  @retval
+    FALSE ok, applied is the log rows applied
+    TRUE error, src->error is set
+*/
+static bool tc_reshard_apply_log(TC_RESHARD_CONTEXT *ctx, TC_RESHARD_SOURCE *src,
+  MYSQL *src_conn, vector<MYSQL*> &target_conns, ulonglong *applied)
+{
+  tc_exec_info exec_info;
+  string db = tc_quote_name(src->node.db_name);
+  string log_table = db + "." +
+    tc_quote_name(TC_RESHARD_LOG_PREFIX + ctx->tb_name);
+  string table = db + "." + tc_quote_name(ctx->src_tb_name);
+  vector<string> delete_list(ctx->target_list.size());
+  vector<string> values_list(ctx->target_list.size());
+  set<string> pk_set;
+  string id_list = "";
+  string pk_in = "";
+  string sql;
+
+  *applied = 0;
+  {
+    sql = "SELECT id, " + ctx->pk_sql + " FROM " + log_table +
+      " ORDER BY id LIMIT " + to_string(ctx->chunk_size);
+    MYSQL_RES *res = tc_exec_sql_with_result(src_conn, sql);
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row;
+    if (!res)
+    {
+      src->error = src->node.server_name + ": " + mysql_error(src_conn);
+      return TRUE;
+    }
+    while ((row = mysql_fetch_row(res)))
+    {
+      ulong *lengths = mysql_fetch_lengths(res);
+      string pk = "(";
+      longlong shard;
+      id_list += (id_list.empty() ? "" : ",") + string(row[0], lengths[0]);
+      (*applied)++;
+      for (size_t i = 0; i < ctx->pk_list.size(); i++)
+      {
+        if (i)
+          pk += ",";
+        tc_append_quoted_value(pk, row[i + 1], lengths[i + 1]);
+      }
+      pk += ")";
+      if (!pk_set.insert(pk).second)
+        continue;
+      if ((shard = tc_reshard_shard_of(ctx, row[ctx->key_pk_pos + 1],
+        lengths[ctx->key_pk_pos + 1])) < 0)
+      {
+        src->error = "no new shard for key of " + pk;
+        return TRUE;
+      }
+      delete_list[shard] += (delete_list[shard].empty() ? "" : ",") + pk;
+      pk_in += (pk_in.empty() ? "" : ",") + pk;
+    }
+  }
+  if (id_list.empty())
+    return FALSE;
+
+  for (size_t i = 0; i < delete_list.size(); i++)
+  {
+    if (delete_list[i].empty())
+      continue;
+    TC_RESHARD_NODE &target = ctx->target_list[i];
+    if (!target_conns[i] &&
+      !(target_conns[i] = tc_reshard_connect(target, src->error)))
+      return TRUE;
+    sql = "DELETE FROM " + tc_quote_name(target.db_name) + "." +
+      tc_quote_name(TC_RESHARD_NEW_PREFIX + ctx->tb_name) +
+      " WHERE (" + ctx->pk_sql + ") IN (" + delete_list[i] + ")";
+    if (tc_exec_sql_without_result(target_conns[i], sql, &exec_info))
+    {
+      src->error = target.server_name + ": " + exec_info.err_msg;
+      return TRUE;
+    }
+  }
+
+  {
+    sql = "SELECT " + ctx->column_sql + " FROM " + table +
+      " WHERE (" + ctx->pk_sql + ") IN (" + pk_in + ")";
+    MYSQL_RES *res = tc_exec_sql_with_result(src_conn, sql);
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row;
+    if (!res)
+    {
+      src->error = src->node.server_name + ": " + mysql_error(src_conn);
+      return TRUE;
+    }
+    while ((row = mysql_fetch_row(res)))
+    {
+      if (tc_reshard_route_row(ctx, row, mysql_fetch_lengths(res),
+        values_list, src->error))
+        return TRUE;
+    }
+  }
+  if (tc_reshard_write_rows(ctx, target_conns, values_list, src->error))
+    return TRUE;
+
+  sql = "DELETE FROM " + log_table + " WHERE id IN (" + id_list + ")";
+  if (tc_exec_sql_without_result(src_conn, sql, &exec_info))
+  {
+    src->error = src->node.server_name + ": " + exec_info.err_msg;
+    return TRUE;
+  }
+  src->changes_applied += *applied;
+  return FALSE;
+}
+
+/*
+  copy thread of one old shard: copy rows and apply change log until
+  ctx->cutover is set, or until the change log is empty if final is TRUE
+*/
+static void tc_reshard_run_source(TC_RESHARD_CONTEXT *ctx,
+  TC_RESHARD_SOURCE *src, bool final)
+{
+  vector<MYSQL*> target_conns(ctx->target_list.size(), (MYSQL*)NULL);
+  string log_table = tc_quote_name(src->node.db_name) + "." +
+    tc_quote_name(TC_RESHARD_LOG_PREFIX + ctx->tb_name);
+  MYSQL *src_conn = tc_reshard_connect(src->node, src->error);
+  MYSQL_GUARD(src_conn);
+  if (!src_conn)
+    goto error;
+
+  if (!src->copied)
+  {
+    auto start = std::chrono::steady_clock::now();
+    if (tc_reshard_copy(ctx, src, src_conn, target_conns))
+      goto error;
+    src->copy_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start).count();
+    src->copied = true;
+  }
+
+  while (!ctx->abort)
+  {
+    ulonglong applied = 0;
+    if (tc_reshard_apply_log(ctx, src, src_conn, target_conns, &applied))
+      goto error;
+    if (applied == 0)
+    {
+      src->lag = 0;
+      src->caught_up = true;
+      if (final || ctx->cutover)
+        break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      continue;
+    }
+
+    MYSQL_RES *res = tc_exec_sql_with_result(src_conn,
+      "SELECT COUNT(*) FROM " + log_table);
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row;
+    if (!res || !(row = mysql_fetch_row(res)))
+    {
+      src->error = src->node.server_name + ": " + mysql_error(src_conn);
+      goto error;
+    }
+    src->lag = strtoull(row[0], NULL, 10);
+    if (src->lag < ctx->chunk_size)
+      src->caught_up = true;
+    if (!final && ctx->cutover)
+      break;
+  }
+  goto finish;
+
+error:
+  ctx->abort = true;
+finish:
+  for (auto conn : target_conns)
+  {
+    if (conn)
+      mysql_close(conn);
+  }
+}
+
+/* run copy thread of every old shard and wait for them */
+static void tc_reshard_run_sources(TC_RESHARD_CONTEXT *ctx,
+  list<TC_RESHARD_SOURCE> &source_list, bool final)
+{
+  list<thread> thread_list;
+  for (auto &src : source_list)
+  {
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_reshard_run_source,
+      ctx, &src, final));
+    thread_list.push_back(std::move(tmp_t));
+  }
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+}
+
+/*
+  columns, primary key and key charset of the table on the first old shard
+
+  @retval
+    FALSE ok
+    TRUE error, err_msg is set
+*/
+static bool tc_reshard_get_columns(TC_RESHARD_CONTEXT *ctx,
+  TC_RESHARD_NODE &node, string key_name, string &pk_def, string &err_msg)
+{
+  MYSQL *mysql = tc_reshard_connect(node, err_msg);
+  MYSQL_GUARD(mysql);
+  map<string, string> type_map;
+  string key_collation = "";
+  string where_sql;
+  if (!mysql)
+    return TRUE;
+
+  where_sql = " WHERE TABLE_SCHEMA=";
+  tc_append_quoted_value(where_sql, node.db_name.c_str(), node.db_name.length());
+  where_sql += " AND TABLE_NAME=";
+  tc_append_quoted_value(where_sql, ctx->tb_name.c_str(), ctx->tb_name.length());
+  {
+    MYSQL_RES *res = tc_exec_sql_with_result(mysql,
+      "SELECT COLUMN_NAME, COLUMN_TYPE, COLLATION_NAME, EXTRA "
+      "FROM information_schema.COLUMNS" + where_sql + " ORDER BY ORDINAL_POSITION");
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row;
+    if (!res)
+    {
+      err_msg = node.server_name + ": " + mysql_error(mysql);
+      return TRUE;
+    }
+    while ((row = mysql_fetch_row(res)))
+    {
+      /* generated columns are computed on new shard */
+      if (row[3] && strstr(row[3], "GENERATED"))
+        continue;
+      type_map[row[0]] = string(row[1]) +
+        (row[2] ? string(" COLLATE ") + row[2] : "");
+      if (!strcmp(row[0], key_name.c_str()))
+      {
+        ctx->key_pos = ctx->column_list.size();
+        key_collation = row[2] ? row[2] : "";
+      }
+      ctx->column_list.push_back(row[0]);
+    }
+  }
+  {
+    MYSQL_RES *res = tc_exec_sql_with_result(mysql,
+      "SELECT COLUMN_NAME FROM information_schema.KEY_COLUMN_USAGE" + where_sql +
+      " AND CONSTRAINT_NAME='PRIMARY' ORDER BY ORDINAL_POSITION");
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row;
+    if (!res)
+    {
+      err_msg = node.server_name + ": " + mysql_error(mysql);
+      return TRUE;
+    }
+    while ((row = mysql_fetch_row(res)))
+      ctx->pk_list.push_back(row[0]);
+  }
+
+  if (ctx->column_list.empty())
+  {
+    err_msg = node.server_name + ": table not exists";
+    return TRUE;
+  }
+  if (ctx->pk_list.empty())
+  {
+    err_msg = "table without primary key can't be resharded";
+    return TRUE;
+  }
+
+  ctx->key_pk_pos = ctx->pk_list.size();
+  ctx->column_sql = "";
+  ctx->pk_sql = "";
+  pk_def = "";
+  for (auto &column : ctx->column_list)
+    ctx->column_sql += (ctx->column_sql.empty() ? "" : ",") + tc_quote_name(column);
+  for (size_t i = 0; i < ctx->pk_list.size(); i++)
+  {
+    string &column = ctx->pk_list[i];
+    auto it = std::find(ctx->column_list.begin(), ctx->column_list.end(), column);
+    if (it == ctx->column_list.end())
+    {
+      err_msg = "generated column " + column + " in primary key";
+      return TRUE;
+    }
+    if (column == key_name)
+      ctx->key_pk_pos = i;
+    ctx->pk_pos.push_back(it - ctx->column_list.begin());
+    ctx->pk_sql += (i ? "," : "") + tc_quote_name(column);
+    pk_def += "," + tc_quote_name(column) + " " + type_map[column];
+  }
+  if (ctx->key_pk_pos == ctx->pk_list.size())
+  {
+    err_msg = "shard key " + key_name + " is not part of primary key";
+    return TRUE;
+  }
+  ctx->key_cs = &my_charset_bin;
+  if (!key_collation.empty() &&
+    !(ctx->key_cs = get_charset_by_name(key_collation.c_str(), MYF(0))))
+  {
+    err_msg = "unknown collation " + key_collation;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/*
+  first result of sql on node
+
+  @retval
+    FALSE ok
+    TRUE error, err_msg is set
+*/
+static bool tc_reshard_get_value(TC_RESHARD_NODE &node, string sql,
+  uint column, string &value, string &err_msg)
+{
+  MYSQL *mysql = tc_reshard_connect(node, err_msg);
+  MYSQL_GUARD(mysql);
+  if (!mysql)
+    return TRUE;
+  MYSQL_RES *res = tc_exec_sql_with_result(mysql, sql);
+  MYSQL_RES_GUARD(res);
+  MYSQL_ROW row;
+  if (!res)
+  {
+    err_msg = node.server_name + ": " + mysql_error(mysql);
+    return TRUE;
+  }
+  value = ((row = mysql_fetch_row(res)) && row[column]) ? row[column] : "";
+  return FALSE;
+}
+
+/*
+  objects used while reshard, new_sql is executed to create them and
+  drop_sql to remove them if reshard failed before cutover
+*/
+typedef struct tc_reshard_setup
+{
+  TC_RESHARD_NODE *node;
+  string new_sql;
+  string drop_sql;
+} TC_RESHARD_SETUP;
+
+/* drop objects created for reshard */
+static void tc_reshard_cleanup(list<TC_RESHARD_SETUP> &setup_list)
+{
+  for (auto &setup : setup_list)
+  {
+    string err_msg;
+    if (tc_reshard_exec(*setup.node, setup.drop_sql, err_msg))
+      sql_print_warning("tc reshard cleanup failed: %s", err_msg.c_str());
+  }
+}
+
+/*
+  TDBCTL RESHARD db.table
+
+  @retval
+    FALSE ok
+    TRUE error, my_error is set
+*/
+bool tc_reshard_table(THD *thd, LEX_STRING db, LEX_STRING table)
+{
+  MEM_ROOT mem_root;
+  list<FOREIGN_SERVER*> spider_server_list;
+  list<FOREIGN_SERVER*> remote_server_list;
+  map<string, FOREIGN_SERVER*> remote_server_map;
+  vector<TC_RESHARD_NODE> spider_list;
+  list<TC_RESHARD_SOURCE> source_list;
+  list<TC_RESHARD_SETUP> setup_list;
+  TC_RESHARD_CONTEXT ctx;
+  TC_ROUTE_RULE old_rule;
+  List<Item> field_list;
+  Protocol *protocol = thd->get_protocol();
+  string db_name = (db.str ? string(db.str, db.length) :
+    (thd->db().str ? thd->db().str : ""));
+  string tb_name(table.str, table.length);
+  string qdb = tc_quote_name(db_name);
+  string new_tb = tc_quote_name(TC_RESHARD_NEW_PREFIX + tb_name);
+  string old_tb = tc_quote_name(TC_RESHARD_OLD_PREFIX + tb_name);
+  string log_tb = tc_quote_name(TC_RESHARD_LOG_PREFIX + tb_name);
+  string pk_def, remote_create_sql, spider_create_sql, db_charset, err_msg;
+  char proc_info[2][256];
+  uint proc_info_idx = 0;
+  time_t last_report = 0;
+  ulonglong cutover_time = 0;
+  size_t renamed = 0;
+  const char *prefix = tdbctl_mysql_wrapper_prefix;
+  DBUG_ENTER("tc_reshard_table");
+
+  if (db_name.empty())
+  {
+    my_error(ER_NO_DB_ERROR, MYF(0));
+    DBUG_RETURN(TRUE);
+  }
+  /* trigger is named by TC_RESHARD_LOG_PREFIX<tb>_i */
+  if (tb_name.length() + strlen(TC_RESHARD_LOG_PREFIX) + 2 > NAME_CHAR_LEN)
+  {
+    my_error(ER_TOO_LONG_IDENT, MYF(0), tb_name.c_str());
+    DBUG_RETURN(TRUE);
+  }
+  /* block routing flush and other DDL of the table */
+  if (lock_statement_by_name(thd, server_uuid_ptr, MDL_SHARED) ||
+    xlock_dbtb_name(thd, db_name.c_str(), tb_name.c_str()))
+    DBUG_RETURN(TRUE);
+
+  tc_route_clear_rule(db_name, tb_name);
+  if (tc_route_get_rule(db_name, tb_name, old_rule))
+    DBUG_RETURN(TRUE);
+  if (!old_rule.is_list || old_rule.shard_count <= 0 || old_rule.key_name.empty())
+  {
+    my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0),
+      "only table of list partition by key%N or crc32(key)%N can be resharded");
+    DBUG_RETURN(TRUE);
+  }
+
+  init_sql_alloc(key_memory_for_tdbctl, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+  MEM_ROOT_GUARD(mem_root);
+  get_server_by_wrapper(spider_server_list, &mem_root, SPIDER_WRAPPER, TRUE);
+  get_server_by_wrapper(remote_server_list, &mem_root, MYSQL_WRAPPER, FALSE);
+  for (auto &server : remote_server_list)
+    remote_server_map[server->server_name] = server;
+  for (auto &server : spider_server_list)
+  {
+    TC_RESHARD_NODE node;
+    node.server_name = server->server_name;
+    node.ipport = string(server->host) + "#" + to_string(server->port);
+    node.user = server->username;
+    node.passwd = server->password;
+    node.db_name = db_name;
+    spider_list.push_back(node);
+  }
+  if (spider_list.empty())
+  {
+    my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), "no spider found");
+    DBUG_RETURN(TRUE);
+  }
+
+  if ((longlong)remote_server_list.size() < old_rule.shard_count)
+  {
+    err_msg = "shard count can't be reduced, table has " +
+      to_string(old_rule.shard_count) + " shards and there are " +
+      to_string(remote_server_list.size()) + " MYSQL wrapper servers";
+    my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), err_msg.c_str());
+    DBUG_RETURN(TRUE);
+  }
+
+  /* new shards: SPT0 ... SPT<n-1> of all MYSQL wrapper servers */
+  for (size_t i = 0; i < remote_server_list.size(); i++)
+  {
+    string server_name = prefix + to_string(i);
+    auto it = remote_server_map.find(server_name);
+    if (it == remote_server_map.end())
+    {
+      err_msg = "server " + server_name + " not found";
+      my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), err_msg.c_str());
+      DBUG_RETURN(TRUE);
+    }
+    TC_RESHARD_NODE node;
+    node.server_name = server_name;
+    node.ipport = string(it->second->host) + "#" + to_string(it->second->port);
+    node.user = it->second->username;
+    node.passwd = it->second->password;
+    node.db_name = db_name + "_" + to_string(i);
+    ctx.target_list.push_back(node);
+  }
+  if ((longlong)ctx.target_list.size() == old_rule.shard_count)
+  {
+    my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0),
+      "shard count is the same as the number of MYSQL wrapper servers");
+    DBUG_RETURN(TRUE);
+  }
+
+  /* old shards, by partition of spider table */
+  for (size_t i = 0; i < old_rule.server_list.size(); i++)
+  {
+    auto it = remote_server_map.find(old_rule.server_list[i]);
+    if (it == remote_server_map.end())
+    {
+      err_msg = "server " + old_rule.server_list[i] + " not found";
+      my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), err_msg.c_str());
+      DBUG_RETURN(TRUE);
+    }
+    source_list.emplace_back();
+    TC_RESHARD_SOURCE &src = source_list.back();
+    src.node.server_name = it->first;
+    src.node.ipport = string(it->second->host) + "#" + to_string(it->second->port);
+    src.node.user = it->second->username;
+    src.node.passwd = it->second->password;
+    src.node.db_name = db_name + "_" + it->first.substr(strlen(prefix));
+    src.rows_copied = 0;
+    src.changes_applied = 0;
+    src.lag = 0;
+    src.caught_up = false;
+    src.copied = false;
+    src.copy_time = 0;
+  }
+
+  ctx.tb_name = tb_name;
+  ctx.src_tb_name = tb_name;
+  ctx.chunk_size = tc_reshard_chunk_size;
+  ctx.abort = false;
+  ctx.cutover = false;
+  ctx.rule = old_rule;
+  ctx.rule.shard_count = ctx.target_list.size();
+  ctx.rule.bound_list.clear();
+  ctx.rule.is_maxvalue.clear();
+  ctx.rule.server_list.clear();
+  for (size_t i = 0; i < ctx.target_list.size(); i++)
+  {
+    ctx.rule.bound_list.push_back(i);
+    ctx.rule.is_maxvalue.push_back(false);
+    ctx.rule.server_list.push_back(ctx.target_list[i].server_name);
+  }
+
+  {
+    TC_RESHARD_NODE &first = source_list.front().node;
+    string sql = "SELECT DEFAULT_COLLATION_NAME FROM information_schema.SCHEMATA "
+      "WHERE SCHEMA_NAME=";
+    tc_append_quoted_value(sql, first.db_name.c_str(), first.db_name.length());
+    if (tc_reshard_get_columns(&ctx, first, old_rule.key_name, pk_def, err_msg) ||
+      tc_reshard_get_value(first, "SHOW CREATE TABLE " +
+        tc_quote_name(first.db_name) + "." + tc_quote_name(tb_name),
+        1, remote_create_sql, err_msg) ||
+      tc_reshard_get_value(first, sql, 0, db_charset, err_msg) ||
+      tc_reshard_get_value(spider_list[0],
+        "SHOW CREATE TABLE " + qdb + "." + tc_quote_name(tb_name),
+        1, spider_create_sql, err_msg))
+    {
+      my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), err_msg.c_str());
+      DBUG_RETURN(TRUE);
+    }
+
+    /* table on new shards must not exist except the old shards */
+    for (size_t i = old_rule.server_list.size(); i < ctx.target_list.size(); i++)
+    {
+      string exists;
+      TC_RESHARD_NODE &target = ctx.target_list[i];
+      sql = "SELECT COUNT(*) FROM information_schema.TABLES WHERE TABLE_SCHEMA=";
+      tc_append_quoted_value(sql, target.db_name.c_str(), target.db_name.length());
+      sql += " AND TABLE_NAME=";
+      tc_append_quoted_value(sql, tb_name.c_str(), tb_name.length());
+      if (tc_reshard_get_value(target, sql, 0, exists, err_msg))
+      {
+        my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), err_msg.c_str());
+        DBUG_RETURN(TRUE);
+      }
+      if (exists != "0")
+      {
+        err_msg = target.server_name + ": table " + target.db_name + "." +
+          tb_name + " already exists";
+        my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), err_msg.c_str());
+        DBUG_RETURN(TRUE);
+      }
+    }
+  }
+
+  /* new shard tables */
+  for (auto &target : ctx.target_list)
+  {
+    TC_RESHARD_SETUP setup;
+    string qtdb = tc_quote_name(target.db_name);
+    string create_sql = remote_create_sql;
+    string from = "CREATE TABLE " + tc_quote_name(tb_name);
+    size_t pos = create_sql.find(from);
+    if (pos != string::npos)
+      create_sql.replace(pos, from.length(), "CREATE TABLE " + qtdb + "." + new_tb);
+    setup.node = &target;
+    setup.new_sql = "CREATE DATABASE IF NOT EXISTS " + qtdb +
+      (db_charset.empty() ? "" : " DEFAULT COLLATE " + db_charset) + ";" +
+      "DROP TABLE IF EXISTS " + qtdb + "." + new_tb + ";" + create_sql;
+    setup.drop_sql = "DROP TABLE IF EXISTS " + qtdb + "." + new_tb;
+    setup_list.push_back(setup);
+  }
+  /* change log and triggers on old shards */
+  for (auto &src : source_list)
+  {
+    TC_RESHARD_SETUP setup;
+    string qsdb = tc_quote_name(src.node.db_name);
+    string log_table = qsdb + "." + log_tb;
+    string new_values = "", old_values = "";
+    for (auto &column : ctx.pk_list)
+    {
+      new_values += (new_values.empty() ? "NEW." : ",NEW.") + tc_quote_name(column);
+      old_values += (old_values.empty() ? "OLD." : ",OLD.") + tc_quote_name(column);
+    }
+    string on_table = " ON " + qsdb + "." + tc_quote_name(tb_name) +
+      " FOR EACH ROW INSERT INTO " + log_table + " (" + ctx.pk_sql + ") VALUES ";
+    string trigger_ins = qsdb + "." + tc_quote_name(TC_RESHARD_LOG_PREFIX + tb_name + "_i");
+    string trigger_upd = qsdb + "." + tc_quote_name(TC_RESHARD_LOG_PREFIX + tb_name + "_u");
+    string trigger_del = qsdb + "." + tc_quote_name(TC_RESHARD_LOG_PREFIX + tb_name + "_d");
+    string drop_sql = "DROP TRIGGER IF EXISTS " + trigger_ins + ";" +
+      "DROP TRIGGER IF EXISTS " + trigger_upd + ";" +
+      "DROP TRIGGER IF EXISTS " + trigger_del + ";" +
+      "DROP TABLE IF EXISTS " + log_table;
+    setup.node = &src.node;
+    setup.new_sql = drop_sql + ";" +
+      "CREATE TABLE " + log_table + " (id bigint unsigned NOT NULL AUTO_INCREMENT" +
+      pk_def + ", PRIMARY KEY (id)) ENGINE=InnoDB;" +
+      "CREATE TRIGGER " + trigger_ins + " AFTER INSERT" + on_table +
+      "(" + new_values + ");" +
+      "CREATE TRIGGER " + trigger_upd + " AFTER UPDATE" + on_table +
+      "(" + old_values + "),(" + new_values + ");" +
+      "CREATE TRIGGER " + trigger_del + " AFTER DELETE" + on_table +
+      "(" + old_values + ")";
+    setup.drop_sql = drop_sql;
+    setup_list.push_back(setup);
+  }
+  /* spider table of new partition */
+  {
+    TC_PARSE_RESULT parse_result;
+    size_t pos = spider_create_sql.find("/*!50100 PARTITION BY");
+    if (pos == string::npos)
+      pos = spider_create_sql.find("PARTITION BY");
+    spider_create_sql = spider_create_sql.substr(0, pos);
+    string from = "CREATE TABLE " + tc_quote_name(tb_name);
+    if ((pos = spider_create_sql.find(from)) != string::npos)
+      spider_create_sql.replace(pos, from.length(), "CREATE TABLE " + new_tb);
+    tc_parse_result_init(&parse_result);
+    parse_result.query_string.str = spider_create_sql.c_str();
+    parse_result.query_string.length = spider_create_sql.length();
+    parse_result.db_name = db_name;
+    parse_result.table_name = tb_name;
+    parse_result.shard_key = old_rule.key_name;
+    spider_create_sql = tc_get_spider_create_table(&parse_result,
+      ctx.target_list.size(),
+      old_rule.func == TC_ROUTE_FUNC_CRC32 ? tspider_shard_func_crc32 :
+      (old_rule.func == TC_ROUTE_FUNC_CRC32_CI ? tspider_shard_func_crc32_ci :
+        tspider_shard_func_none),
+      tspider_shard_type_list, false);
+    for (auto &spider : spider_list)
+    {
+      TC_RESHARD_SETUP setup;
+      setup.node = &spider;
+      setup.new_sql = "DROP TABLE IF EXISTS " + qdb + "." + new_tb + ";" +
+        spider_create_sql;
+      setup.drop_sql = "DROP TABLE IF EXISTS " + qdb + "." + new_tb;
+      setup_list.push_back(setup);
+    }
+  }
+  for (auto &setup : setup_list)
+  {
+    if (tc_reshard_exec(*setup.node, setup.new_sql, err_msg))
+      goto setup_error;
+  }
+  sql_print_information("tc reshard %s.%s from %lld to %lu shards begin",
+    db_name.c_str(), tb_name.c_str(), old_rule.shard_count,
+    (ulong)ctx.target_list.size());
+
+  /* copy and catch up, progress is shown in processlist */
+  {
+    thread copy_thread(tc_thread_create(key_thread_tc_worker, tc_reshard_run_sources,
+      &ctx, std::ref(source_list), false));
+    auto start = std::chrono::steady_clock::now();
+    while (true)
+    {
+      bool caught_up = true;
+      ulonglong copied = 0, applied = 0, lag = 0;
+      ulonglong seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - start).count();
+      for (auto &src : source_list)
+      {
+        caught_up = caught_up && src.caught_up;
+        copied += src.rows_copied;
+        applied += src.changes_applied;
+        lag += src.lag;
+      }
+      if (thd->killed)
+        ctx.abort = true;
+      if (caught_up || ctx.abort)
+        break;
+      snprintf(proc_info[proc_info_idx], sizeof(proc_info[0]),
+        "reshard copied %llu rows, %llu rows/s, applied %llu changes, lag %llu",
+        copied, copied / (seconds ? seconds : 1), applied, lag);
+      thd_proc_info(thd, proc_info[proc_info_idx]);
+      proc_info_idx = 1 - proc_info_idx;
+      if (time(NULL) - last_report >= 10)
+      {
+        sql_print_information("tc reshard %s.%s: %s", db_name.c_str(),
+          tb_name.c_str(), thd->proc_info);
+        last_report = time(NULL);
+      }
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    ctx.cutover = true;
+    copy_thread.join();
+    thd_proc_info(thd, NULL);
+  }
+  if (ctx.abort)
+    goto copy_error;
+
+  /* cutover, writes to the table fail until new shard tables are renamed */
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (auto &src : source_list)
+    {
+      string qsdb = tc_quote_name(src.node.db_name);
+      if (tc_reshard_exec(src.node, "RENAME TABLE " + qsdb + "." +
+        tc_quote_name(tb_name) + " TO " + qsdb + "." + old_tb, err_msg))
+        goto cutover_error;
+      renamed++;
+    }
+    ctx.src_tb_name = TC_RESHARD_OLD_PREFIX + tb_name;
+    tc_reshard_run_sources(&ctx, source_list, true);
+    if (ctx.abort)
+      goto copy_error;
+
+    for (auto &spider : spider_list)
+    {
+      if (tc_reshard_exec(spider, "RENAME TABLE " + qdb + "." +
+        tc_quote_name(tb_name) + " TO " + qdb + "." + old_tb + ", " +
+        qdb + "." + new_tb + " TO " + qdb + "." + tc_quote_name(tb_name),
+        err_msg))
+        goto switch_error;
+    }
+    for (auto &target : ctx.target_list)
+    {
+      string qtdb = tc_quote_name(target.db_name);
+      if (tc_reshard_exec(target, "RENAME TABLE " + qtdb + "." + new_tb + " TO " +
+        qtdb + "." + tc_quote_name(tb_name), err_msg))
+        goto switch_error;
+    }
+    cutover_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+  /* old tables, triggers are dropped with old tables */
+  for (auto &src : source_list)
+  {
+    string qsdb = tc_quote_name(src.node.db_name);
+    if (tc_reshard_exec(src.node, "DROP TABLE IF EXISTS " + qsdb + "." + old_tb +
+      ";DROP TABLE IF EXISTS " + qsdb + "." + log_tb, err_msg))
+      sql_print_warning("tc reshard cleanup failed: %s", err_msg.c_str());
+  }
+  for (auto &spider : spider_list)
+  {
+    if (tc_reshard_exec(spider, "DROP TABLE IF EXISTS " + qdb + "." + old_tb, err_msg))
+      sql_print_warning("tc reshard cleanup failed: %s", err_msg.c_str());
+  }
+  tc_route_clear_rule(db_name, tb_name);
+  {
+    TC_PARSE_RESULT parse_result;
+    tc_parse_result_init(&parse_result);
+    parse_result.query_string = thd->query();
+    parse_result.db_name = db_name;
+    parse_result.table_name = tb_name;
+    tc_schema_catalog_update(thd, SQLCOM_ALTER_TABLE, &parse_result);
+    if (thd->is_error())
+      thd->clear_error();
+  }
+  sql_print_information("tc reshard %s.%s done, cutover takes %llu ms",
+    db_name.c_str(), tb_name.c_str(), cutover_time);
+
+  field_list.push_back(new Item_empty_string("Server_name", NAME_CHAR_LEN));
+  field_list.push_back(new Item_int(NAME_STRING("Rows_copied"), 0,
+    MY_INT64_NUM_DECIMAL_DIGITS));
+  field_list.push_back(new Item_int(NAME_STRING("Changes_applied"), 0,
+    MY_INT64_NUM_DECIMAL_DIGITS));
+  field_list.push_back(new Item_int(NAME_STRING("Copy_ms"), 0,
+    MY_INT64_NUM_DECIMAL_DIGITS));
+  field_list.push_back(new Item_int(NAME_STRING("Rows_per_second"), 0,
+    MY_INT64_NUM_DECIMAL_DIGITS));
+  field_list.push_back(new Item_int(NAME_STRING("Cutover_ms"), 0,
+    MY_INT64_NUM_DECIMAL_DIGITS));
+  if (thd->send_result_metadata(&field_list,
+    Protocol::SEND_NUM_ROWS | Protocol::SEND_EOF))
+    DBUG_RETURN(TRUE);
+  for (auto &src : source_list)
+  {
+    protocol->start_row();
+    protocol->store(src.node.server_name.c_str(), system_charset_info);
+    protocol->store((ulonglong)src.rows_copied);
+    protocol->store((ulonglong)src.changes_applied);
+    protocol->store(src.copy_time);
+    protocol->store(src.rows_copied * 1000 / (src.copy_time ? src.copy_time : 1));
+    protocol->store(cutover_time);
+    if (protocol->end_row())
+      DBUG_RETURN(TRUE);
+  }
+  my_eof(thd);
+  DBUG_RETURN(FALSE);
+
+copy_error:
+  for (auto &src : source_list)
+  {
+    if (!src.error.empty())
+    {
+      err_msg = src.error;
+      break;
+    }
+  }
+  if (err_msg.empty())
+    err_msg = "reshard is killed";
+cutover_error:
+  /* writes to old shards are allowed again */
+  for (auto &src : source_list)
+  {
+    string qsdb = tc_quote_name(src.node.db_name);
+    string rename_err;
+    if (renamed-- == 0)
+      break;
+    if (tc_reshard_exec(src.node, "RENAME TABLE " + qsdb + "." + old_tb + " TO " +
+      qsdb + "." + tc_quote_name(tb_name), rename_err))
+      sql_print_error("tc reshard rename back failed: %s", rename_err.c_str());
+  }
+setup_error:
+  tc_reshard_cleanup(setup_list);
+  my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), err_msg.c_str());
+  DBUG_RETURN(TRUE);
+
+switch_error:
+  /* spider or new shard partly switched, can't rollback automatically */
+  err_msg = "reshard cutover failed, tables " + string(TC_RESHARD_NEW_PREFIX) +
+    tb_name + " and " + TC_RESHARD_OLD_PREFIX + tb_name +
+    " are kept for manual repair: " + err_msg;
+  sql_print_error("tc reshard %s.%s: %s", db_name.c_str(), tb_name.c_str(),
+    err_msg.c_str());
+  my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), err_msg.c_str());
+  DBUG_RETURN(TRUE);
+}
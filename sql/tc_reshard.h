@@ -0,0 +1,98 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+#ifndef TC_RESHARD_INCLUDED
+#define TC_RESHARD_INCLUDED
+
+/*
+  TDBCTL RESHARD db.table: move a list sharded spider table from its
+  current shard count to the number of MYSQL wrapper servers online
+
+  1. create the table as _tcrs_new_<tb> on every new shard, a change log
+     table _tcrs_log_<tb> and triggers writing primary keys of changed rows
+     to it on every old shard, and the spider table _tcrs_new_<tb> of the
+     new partition on every spider
+  2. copy rows of every old shard by primary key chunks parallel, each row
+     goes to the new shard of its key, then apply the change log until
+     the lag is less than tc_reshard_chunk_size
+  3. cutover: rename <tb> to _tcrs_old_<tb> on old shards to stop writes,
+     apply the rest of change log, switch spider tables and rename new
+     shard tables to <tb>
+*/
+
+#include "my_global.h"
+#include "m_ctype.h"
+#include "m_string.h"
+#include "tc_route.h"
+#include <string>
+#include <vector>
+#include <atomic>
+using namespace std;
+
+#define TC_RESHARD_NEW_PREFIX "_tcrs_new_"
+#define TC_RESHARD_OLD_PREFIX "_tcrs_old_"
+#define TC_RESHARD_LOG_PREFIX "_tcrs_log_"
+
+class THD;
+
+/* a spider or remote node, db_name is the database of the shard */
+typedef struct tc_reshard_node
+{
+  string server_name;
+  string ipport;
+  string user;
+  string passwd;
+  string db_name;
+} TC_RESHARD_NODE;
+
+/*
+  state of one old shard
+  rows_copied: rows copied by chunk
+  changes_applied: rows of change log applied to new shards
+  lag: rows of change log not applied yet
+  caught_up: copy is done and lag is less than tc_reshard_chunk_size
+  copy_time: milliseconds spent in copy
+*/
+typedef struct tc_reshard_source
+{
+  TC_RESHARD_NODE node;
+  std::atomic<ulonglong> rows_copied;
+  std::atomic<ulonglong> changes_applied;
+  std::atomic<ulonglong> lag;
+  std::atomic<bool> caught_up;
+  bool copied;
+  ulonglong copy_time;
+  string error;
+} TC_RESHARD_SOURCE;
+
+/*
+  shared by all copy threads of one reshard
+  src_tb_name: table read on old shards, renamed in cutover
+  column_list: columns copied, generated columns are excluded
+  pk_pos: position of every primary key column in column_list
+  key_pos/key_pk_pos: position of shard key in column_list/pk_list
+  rule: routing rule of the new partition
+*/
+typedef struct tc_reshard_context
+{
+  string tb_name;
+  string src_tb_name;
+  vector<string> column_list;
+  vector<string> pk_list;
+  vector<uint> pk_pos;
+  uint key_pos;
+  uint key_pk_pos;
+  string column_sql;
+  string pk_sql;
+  const CHARSET_INFO *key_cs;
+  TC_ROUTE_RULE rule;
+  vector<TC_RESHARD_NODE> target_list;
+  ulong chunk_size;
+  std::atomic<bool> abort;
+  std::atomic<bool> cutover;
+} TC_RESHARD_CONTEXT;
+
+bool tc_reshard_table(THD *thd, LEX_STRING db, LEX_STRING table);
+
+#endif /* TC_RESHARD_INCLUDED */
@@ -0,0 +1,484 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+/*
+  Shard routing of keys for spider tables
+*/
+
+#include "tc_route.h"
+#include "sql_class.h"
+#include "sql_servers.h"
+#include "protocol.h"
+#include "tc_base.h"
+#include "sql_time.h"
+#include "tztime.h"
+#include "mysql.h"
+#include "zlib.h"
+#include <map>
+#include <list>
+#include <mutex>
+#include <regex>
+#include <ctime>
+
+using namespace std;
+
+/* db.tb-->(fetch time, rule) */
+static map<string, pair<time_t, TC_ROUTE_RULE> > tc_route_rule_map;
+static ulong tc_route_server_version = 0;
+static std::mutex tc_route_mutex;
+
+/*
+  parse routing rule from SHOW CREATE TABLE of spider table
+
+  @retval
+    FALSE ok
+    TRUE not a spider table created by tdbctl
+*/
+static bool tc_route_parse_rule(string create_sql, TC_ROUTE_RULE &rule)
+{
+  smatch match;
+  regex partition_by("PARTITION BY (LIST|RANGE)\\s*\\((.*?)\\)\\s*\\(\\s*PARTITION",
+    regex::icase);
+  regex partition_def("PARTITION\\s+`?\\w+`?\\s+VALUES\\s+(IN|LESS THAN)\\s*"
+    "\\(([^)]*)\\)\\s*COMMENT\\s*=\\s*'([^']*)'", regex::icase);
+  regex server_def("server\\s+\\\\?\"([^\"\\\\]+)\\\\?\"", regex::icase);
+  string expr;
+  size_t pos;
+
+  rule.bound_list.clear();
+  rule.is_maxvalue.clear();
+  rule.server_list.clear();
+  if (!regex_search(create_sql, match, partition_by))
+    return TRUE;
+  rule.is_list = !strcasecmp(match[1].str().c_str(), "LIST");
+  expr = match[2].str();
+
+  /*
+    crc32(`key`)%N, crc32_ci(`key`)%N or `key`%N, range partition may
+    also be `key`, to_days(`key`), to_seconds(`key`) or unix_timestamp(`key`)
+  */
+  rule.shard_count = 0;
+  rule.is_unsigned = false;
+  if ((pos = expr.find('`')) != string::npos &&
+    expr.find('`', pos + 1) != string::npos)
+    rule.key_name = expr.substr(pos + 1, expr.find('`', pos + 1) - pos - 1);
+  if ((pos = expr.rfind('%')) != string::npos)
+  {
+    rule.shard_count = atoll(expr.substr(pos + 1).c_str());
+    if (rule.shard_count <= 0)
+      return TRUE;
+    expr = expr.substr(0, pos);
+  }
+  else if (rule.is_list)
+    return TRUE;
+  expr.erase(0, expr.find_first_not_of(" "));
+  if (!strncasecmp(expr.c_str(), "crc32_ci", 8))
+    rule.func = TC_ROUTE_FUNC_CRC32_CI;
+  else if (!strncasecmp(expr.c_str(), "crc32", 5))
+    rule.func = TC_ROUTE_FUNC_CRC32;
+  else if (!strncasecmp(expr.c_str(), "to_days", 7))
+    rule.func = TC_ROUTE_FUNC_TO_DAYS;
+  else if (!strncasecmp(expr.c_str(), "to_seconds", 10))
+    rule.func = TC_ROUTE_FUNC_TO_SECONDS;
+  else if (!strncasecmp(expr.c_str(), "unix_timestamp", 14))
+    rule.func = TC_ROUTE_FUNC_UNIX_TIMESTAMP;
+  else
+    rule.func = TC_ROUTE_FUNC_NONE;
+  if ((rule.func == TC_ROUTE_FUNC_CRC32 || rule.func == TC_ROUTE_FUNC_CRC32_CI) &&
+    rule.shard_count == 0)
+    return TRUE;
+
+  string partitions = match.suffix().str();
+  partitions = "PARTITION" + partitions;
+  for (sregex_iterator it(partitions.begin(), partitions.end(), partition_def), end;
+    it != end; ++it)
+  {
+    string value = (*it)[2].str();
+    string comment = (*it)[3].str();
+    smatch server_match;
+    if (!regex_search(comment, server_match, server_def))
+      return TRUE;
+    value.erase(0, value.find_first_not_of(" "));
+    rule.is_maxvalue.push_back(!strcasecmp(value.c_str(), "MAXVALUE"));
+    if (rule.is_maxvalue.back())
+      rule.bound_list.push_back(0);
+    else if (value[0] == '-')
+      rule.bound_list.push_back(strtoll(value.c_str(), NULL, 10));
+    else
+    {
+      /* bound of BIGINT UNSIGNED key may exceed LLONG_MAX */
+      ulonglong bound = strtoull(value.c_str(), NULL, 10);
+      if (bound > (ulonglong)LLONG_MAX)
+        rule.is_unsigned = true;
+      rule.bound_list.push_back((longlong)bound);
+    }
+    rule.server_list.push_back(server_match[1].str());
+  }
+
+  /* column definition of the key, one line of SHOW CREATE TABLE */
+  if (!rule.key_name.empty() &&
+    (pos = create_sql.find("\n  `" + rule.key_name + "` ")) != string::npos)
+  {
+    string column_def = create_sql.substr(pos + 1,
+      create_sql.find('\n', pos + 1) - pos - 1);
+    if (column_def.find(" unsigned") != string::npos)
+      rule.is_unsigned = true;
+  }
+  return rule.server_list.empty();
+}
+
+/*
+  crc32 of key in upper case of its charset, as crc32_ci of spider
+*/
+static ulong tc_route_crc32_ci(const char *key, size_t length,
+  const CHARSET_INFO *cs)
+{
+  /* case is converted in place, same as caseup of charsets */
+  char buf[256];
+  char *upper = (length <= sizeof(buf) ? buf : new char[length]);
+  size_t upper_len;
+  ulong crc;
+  memcpy(upper, key, length);
+  upper_len = cs->cset->caseup(cs, upper, length, upper, length);
+  crc = crc32(0L, (const uchar*)upper, upper_len);
+  if (upper != buf)
+    delete[] upper;
+  return crc;
+}
+
+/* keys crc32_ci of spider is checked with, in utf8mb4 */
+static const char *tc_route_crc32_ci_probes[] =
+{
+  "TenDB Cluster 123", "mIxEd CaSe ", "\xC3\xA0\xC3\xA9\xC3\xAE\xC3\xB5\xC3\xBC",
+  "stra\xC3\x9F" "e", "\xCE\xA3\xCE\xAF\xCF\x83\xCF\x85\xCF\x86\xCE\xBF\xCF\x82",
+  "\xC4\xB0stanbul \xC4\xB1", "\xC7\x85\xC7\x86", "\xF0\x9F\x98\x80x", NULL
+};
+
+/*
+  check crc32_ci of spider is the same as tc_route_crc32_ci, keys of
+  crc32_ci(key)%N are routed by tdbctl only if they are the same
+
+  @retval
+    FALSE same
+    TRUE differs or failed, my_error is set
+*/
+static bool tc_route_check_crc32_ci(MYSQL *mysql)
+{
+  string sql = "select ";
+  for (uint i = 0; tc_route_crc32_ci_probes[i]; i++)
+  {
+    const char *probe = tc_route_crc32_ci_probes[i];
+    sql += string(i ? "," : "") + "crc32_ci(_utf8mb4";
+    tc_append_quoted_value(sql, probe, strlen(probe));
+    sql += ")";
+  }
+  MYSQL_RES *res = tc_exec_sql_with_result(mysql, sql);
+  MYSQL_RES_GUARD(res);
+  MYSQL_ROW row;
+  if (!res || !(row = mysql_fetch_row(res)))
+  {
+    my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), mysql_error(mysql));
+    return TRUE;
+  }
+  for (uint i = 0; tc_route_crc32_ci_probes[i]; i++)
+  {
+    const char *probe = tc_route_crc32_ci_probes[i];
+    if (!row[i] || strtoul(row[i], NULL, 10) !=
+      tc_route_crc32_ci(probe, strlen(probe), &my_charset_utf8mb4_general_ci))
+    {
+      string err = string("crc32_ci of spider differs from tdbctl for '") +
+        probe + "', keys of crc32_ci(key)%N can't be routed";
+      my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), err.c_str());
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/* fetch routing rule from the first available spider */
+static bool tc_route_fetch_rule(const string &db_name, const string &tb_name,
+  TC_ROUTE_RULE &rule)
+{
+  MEM_ROOT mem_root;
+  list<FOREIGN_SERVER*> server_list;
+  string sql = "show create table `" + db_name + "`.`" + tb_name + "`";
+
+  init_sql_alloc(key_memory_for_tdbctl, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+  MEM_ROOT_GUARD(mem_root);
+  get_server_by_wrapper(server_list, &mem_root, SPIDER_WRAPPER, FALSE);
+  for (auto &server : server_list)
+  {
+    string ipport = string(server->host) + "#" + to_string(server->port);
+    MYSQL *mysql = tc_conn_connect(ipport, server->username, server->password);
+    MYSQL_GUARD(mysql);
+    if (!mysql)
+      continue;
+    MYSQL_RES *res = tc_exec_sql_with_result(mysql, sql);
+    MYSQL_RES_GUARD(res);
+    MYSQL_ROW row;
+    if (!res)
+    {
+      my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), mysql_error(mysql));
+      return TRUE;
+    }
+    if (!(row = mysql_fetch_row(res)) || !row[1] ||
+      tc_route_parse_rule(row[1], rule))
+    {
+      string err = db_name + "." + tb_name + " is not a sharded spider table";
+      my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), err.c_str());
+      return TRUE;
+    }
+    if (rule.func == TC_ROUTE_FUNC_CRC32_CI)
+      return tc_route_check_crc32_ci(mysql);
+    return FALSE;
+  }
+
+  my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), "no spider available to get routing rule");
+  return TRUE;
+}
+
+/*
+  get routing rule of table, cached for TC_ROUTE_RULE_CACHE_TIME seconds
+  or until mysql.servers changed
+
+  @retval
+    FALSE ok
+    TRUE error, my_error is set
+*/
+bool tc_route_get_rule(const string &db_name, const string &tb_name,
+  TC_ROUTE_RULE &rule)
+{
+  string key = db_name + "." + tb_name;
+  time_t now = time(NULL);
+  {
+    std::lock_guard<std::mutex> lock(tc_route_mutex);
+    if (check_server_version(tc_route_server_version))
+      tc_route_rule_map.clear();
+    auto it = tc_route_rule_map.find(key);
+    if (it != tc_route_rule_map.end() &&
+      now - it->second.first < TC_ROUTE_RULE_CACHE_TIME)
+    {
+      rule = it->second.second;
+      return FALSE;
+    }
+  }
+
+  if (tc_route_fetch_rule(db_name, tb_name, rule))
+    return TRUE;
+  std::lock_guard<std::mutex> lock(tc_route_mutex);
+  tc_route_rule_map[key] = make_pair(now, rule);
+  return FALSE;
+}
+
+/* remove cached rule of table after its partition is changed */
+void tc_route_clear_rule(const string &db_name, const string &tb_name)
+{
+  std::lock_guard<std::mutex> lock(tc_route_mutex);
+  tc_route_rule_map.erase(db_name + "." + tb_name);
+}
+
+/* partition of the value of partition expression, -1 for no partition */
+static longlong tc_route_partition(const TC_ROUTE_RULE &rule, longlong value)
+{
+  size_t count = rule.bound_list.size();
+  if (rule.is_list)
+  {
+    /* partition i is VALUES IN (i) when created by tdbctl */
+    if (value >= 0 && (size_t)value < count && rule.bound_list[value] == value)
+      return value;
+    for (size_t i = 0; i < count; i++)
+    {
+      if (rule.bound_list[i] == value)
+        return i;
+    }
+    return -1;
+  }
+  for (size_t i = 0; i < count; i++)
+  {
+    if (rule.is_maxvalue[i] ||
+      (rule.is_unsigned ? (ulonglong)value < (ulonglong)rule.bound_list[i] :
+        value < rule.bound_list[i]))
+      return i;
+  }
+  return -1;
+}
+
+/*
+  value of to_days(key), to_seconds(key) or unix_timestamp(key)
+
+  @retval
+    FALSE ok
+    TRUE key is not a valid date
+*/
+static bool tc_route_date_value(tc_route_func func, const char *key,
+  size_t length, const CHARSET_INFO *cs, longlong *value)
+{
+  MYSQL_TIME ltime;
+  MYSQL_TIME_STATUS status;
+  longlong daynr;
+  if (str_to_datetime(cs, key, length, &ltime, TIME_NO_ZERO_DATE, &status) ||
+    ltime.time_type < MYSQL_TIMESTAMP_DATE)
+    return TRUE;
+
+  daynr = calc_daynr(ltime.year, ltime.month, ltime.day);
+  if (func == TC_ROUTE_FUNC_TO_DAYS)
+    *value = daynr;
+  else if (func == TC_ROUTE_FUNC_TO_SECONDS)
+    *value = daynr * SECONDS_IN_24H + ltime.hour * 3600L +
+      ltime.minute * 60L + ltime.second;
+  else
+  {
+    my_bool not_used;
+    THD *thd = current_thd;
+    *value = (thd ? thd->time_zone() : my_tz_SYSTEM)->TIME_to_gmt_sec(&ltime, &not_used);
+  }
+  return FALSE;
+}
+
+/*
+  shard index of a string key
+
+  @NOTE:
+    crc32 is the same as CRC32() of spider, crc32_ci computes crc32 of
+    the key in upper case of its charset, checked with crc32_ci of spider
+    when the rule is fetched. a key of key%N not negative is unsigned.
+*/
+longlong tc_route_shard_by_str(const TC_ROUTE_RULE &rule, const char *key,
+  size_t length, const CHARSET_INFO *cs)
+{
+  ulong crc;
+  if (rule.func == TC_ROUTE_FUNC_NONE)
+  {
+    int error;
+    const char *end = key + length;
+    longlong value = my_strtoll10(key, (char**)&end, &error);
+    return tc_route_shard_by_int(rule, value, error == 0);
+  }
+  if (rule.func != TC_ROUTE_FUNC_CRC32 && rule.func != TC_ROUTE_FUNC_CRC32_CI)
+  {
+    longlong value;
+    if (tc_route_date_value(rule.func, key, length, cs, &value))
+      return -1;
+    return tc_route_partition(rule, value);
+  }
+
+  if (rule.func == TC_ROUTE_FUNC_CRC32_CI)
+    crc = tc_route_crc32_ci(key, length, cs);
+  else
+    crc = crc32(0L, (const uchar*)key, length);
+
+  return tc_route_partition(rule, (longlong)(crc % rule.shard_count));
+}
+
+/*
+  shard index of an integer key of key%N or key, key is taken as
+  ulonglong if unsigned_key or the key column is unsigned
+*/
+longlong tc_route_shard_by_int(const TC_ROUTE_RULE &rule, longlong key,
+  bool unsigned_key)
+{
+  unsigned_key = unsigned_key || rule.is_unsigned;
+  if (rule.func != TC_ROUTE_FUNC_NONE)
+  {
+    char buf[32];
+    size_t length = snprintf(buf, sizeof(buf), unsigned_key ? "%llu" : "%lld", key);
+    return tc_route_shard_by_str(rule, buf, length, &my_charset_bin);
+  }
+  if (rule.shard_count == 0)
+  {
+    /* out of range of the signed key column */
+    if (unsigned_key && key < 0 && !rule.is_unsigned)
+      return -1;
+    return tc_route_partition(rule, key);
+  }
+  if (unsigned_key)
+    return tc_route_partition(rule,
+      (longlong)((ulonglong)key % (ulonglong)rule.shard_count));
+  return tc_route_partition(rule, key % rule.shard_count);
+}
+
+/*
+  TDBCTL ROUTE db.table KEYS (key, ...)
+  send shard index and server of every key
+
+  @retval
+    FALSE ok
+    TRUE error, my_error is set
+*/
+bool tc_route_keys(THD *thd, LEX_STRING db, LEX_STRING table,
+  List<Item> &key_list)
+{
+  TC_ROUTE_RULE rule;
+  List<Item> field_list;
+  List_iterator<Item> it(key_list);
+  Item *item;
+  Item *field;
+  Protocol *protocol = thd->get_protocol();
+  string db_name = (db.str ? string(db.str, db.length) :
+    (thd->db().str ? thd->db().str : ""));
+  string tb_name(table.str, table.length);
+  DBUG_ENTER("tc_route_keys");
+
+  if (db_name.empty())
+  {
+    my_error(ER_NO_DB_ERROR, MYF(0));
+    DBUG_RETURN(TRUE);
+  }
+  if (tc_route_get_rule(db_name, tb_name, rule))
+    DBUG_RETURN(TRUE);
+
+  while ((item = it++))
+  {
+    if ((!item->fixed && item->fix_fields(thd, it.ref())) ||
+      !(*it.ref())->const_item())
+    {
+      if (!thd->is_error())
+        my_error(ER_WRONG_ARGUMENTS, MYF(0), "TDBCTL ROUTE");
+      DBUG_RETURN(TRUE);
+    }
+  }
+
+  field_list.push_back(field = new Item_empty_string("Key", 255));
+  field->maybe_null = 1;
+  field_list.push_back(field = new Item_int(NAME_STRING("Shard_index"),
+    0, MY_INT64_NUM_DECIMAL_DIGITS));
+  field->maybe_null = 1;
+  field_list.push_back(field = new Item_empty_string("Server_name", NAME_CHAR_LEN));
+  field->maybe_null = 1;
+  if (thd->send_result_metadata(&field_list,
+    Protocol::SEND_NUM_ROWS | Protocol::SEND_EOF))
+    DBUG_RETURN(TRUE);
+
+  it.rewind();
+  while ((item = it++))
+  {
+    String tmp, *key = item->val_str(&tmp);
+    longlong shard = -1;
+    protocol->start_row();
+    if (key == NULL)
+      protocol->store_null();
+    else
+    {
+      protocol->store(key->ptr(), key->length(), key->charset());
+      shard = (rule.func == TC_ROUTE_FUNC_NONE ?
+        tc_route_shard_by_int(rule, item->val_int(), item->unsigned_flag) :
+        tc_route_shard_by_str(rule, key->ptr(), key->length(), key->charset()));
+    }
+    if (shard < 0)
+    {
+      protocol->store_null();
+      protocol->store_null();
+    }
+    else
+    {
+      protocol->store_longlong(shard, false);
+      protocol->store(rule.server_list[shard].c_str(), system_charset_info);
+    }
+    if (protocol->end_row())
+      DBUG_RETURN(TRUE);
+  }
+
+  my_eof(thd);
+  DBUG_RETURN(FALSE);
+}
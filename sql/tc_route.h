@@ -0,0 +1,76 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+#ifndef TC_ROUTE_INCLUDED
+#define TC_ROUTE_INCLUDED
+
+/*
+  Shard routing of spider tables, compute shard of keys the same way as
+  the partition of spider table created by tc_get_spider_create_table:
+    list partition by crc32(key)%N, crc32_ci(key)%N or key%N
+    range partition by crc32(key)%N, crc32_ci(key)%N, key, to_days(key),
+    to_seconds(key) or unix_timestamp(key)
+*/
+
+#include "my_global.h"
+#include "m_ctype.h"
+#include "m_string.h"
+#include <string>
+#include <vector>
+
+class THD;
+class Item;
+template <class T> class List;
+
+/* seconds the rule of a table is cached before fetched from spider again */
+#define TC_ROUTE_RULE_CACHE_TIME 60
+
+enum tc_route_func
+{
+  TC_ROUTE_FUNC_NONE = 0,
+  TC_ROUTE_FUNC_CRC32,
+  TC_ROUTE_FUNC_CRC32_CI,
+  TC_ROUTE_FUNC_TO_DAYS,
+  TC_ROUTE_FUNC_TO_SECONDS,
+  TC_ROUTE_FUNC_UNIX_TIMESTAMP
+};
+
+/*
+  routing rule of one spider table, from its partition clause
+
+  key_name: shard key column in partition expression
+  shard_count: N of %N in partition expression, 0 if there is no %N
+  bound_list: VALUES IN value of list partition, or VALUES LESS THAN of
+    range partition, is_maxvalue is set for MAXVALUE
+  is_unsigned: key column is unsigned or a bound exceeds LLONG_MAX, keys
+    and bounds are compared and divided as unsigned
+  server_list: server of every partition
+*/
+typedef struct tc_route_rule
+{
+  tc_route_func func;
+  std::string key_name;
+  bool is_list;
+  bool is_unsigned;
+  longlong shard_count;
+  std::vector<longlong> bound_list;
+  std::vector<bool> is_maxvalue;
+  std::vector<std::string> server_list;
+} TC_ROUTE_RULE;
+
+bool tc_route_get_rule(const std::string &db_name, const std::string &tb_name,
+  TC_ROUTE_RULE &rule);
+
+void tc_route_clear_rule(const std::string &db_name, const std::string &tb_name);
+
+longlong tc_route_shard_by_str(const TC_ROUTE_RULE &rule, const char *key,
+  size_t length, const CHARSET_INFO *cs);
+
+longlong tc_route_shard_by_int(const TC_ROUTE_RULE &rule, longlong key,
+  bool unsigned_key);
+
+bool tc_route_keys(THD *thd, LEX_STRING db, LEX_STRING table,
+  List<Item> &key_list);
+
+#endif /* TC_ROUTE_INCLUDED */
@@ -0,0 +1,697 @@
+/*
+   Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+/*
+  Schema catalog of the cluster, see tc_schema_catalog.h
+*/
+#include "sql_base.h"
+#include "sql_lex.h"
+#include "sql_class.h"
+#include "tc_base.h"
+#include "log.h"
+#include "sql_servers.h"
+#include "protocol.h"
+#include "errmsg.h"
+#include "tc_schema_catalog.h"
+#include <thread>
+#include <mutex>
+#include <list>
+#include <set>
+#include <regex>
+#include <sstream>
+
+/* escape value by the connection's charset and quote it */
+static string tc_catalog_quote(MYSQL *mysql, string value)
+{
+  char *buf = new char[value.length() * 2 + 1];
+  mysql_real_escape_string_quote(mysql, buf, value.c_str(), value.length(), '\'');
+  string res = string("'") + buf + "'";
+  delete[] buf;
+  return res;
+}
+
+/*
+  get definition from one node by SHOW CREATE
+
+  @retval
+    0 ok
+    1 error, err_msg is set
+*/
+static int tc_catalog_show_create(
+  MYSQL *mysql,
+  string db_name,
+  string tb_name,
+  string &create_sql,
+  string &err_msg)
+{
+  string sql = tb_name.empty() ?
+    "show create database `" + db_name + "`" :
+    "show create table `" + db_name + "`.`" + tb_name + "`";
+  MYSQL_RES *res = tc_exec_sql_with_result(mysql, sql);
+  MYSQL_RES_GUARD(res);
+  MYSQL_ROW row = NULL;
+  if (res && (row = mysql_fetch_row(res)) && row[1])
+  {
+    create_sql = row[1];
+    return 0;
+  }
+  err_msg = sql + ": " + (mysql ? mysql_error(mysql) : "no connection");
+  return 1;
+}
+
+/*
+  get logical definition from spider and per-shard definition from remotes
+
+  @param (out)
+    entry_list: entries of the object, server_name is '' for spider
+  @retval
+    0 ok
+    1 error, err_msg is set
+*/
+static int tc_catalog_collect(
+  THD *thd,
+  string db_name,
+  string tb_name,
+  vector<TC_SCHEMA_CATALOG_ENTRY> &entry_list,
+  string &err_msg)
+{
+  map<string, MYSQL*>::iterator its;
+  MYSQL *spider_conn = NULL;
+  list<thread> thread_list;
+  size_t prefix_len = strlen(tdbctl_mysql_wrapper_prefix);
+  vector<TC_SCHEMA_CATALOG_ENTRY> remote_list(thd->remote_ipport_map.size());
+  vector<int> ret_list(thd->remote_ipport_map.size(), 0);
+  vector<string> msg_list(thd->remote_ipport_map.size());
+  size_t i = 0;
+  int result = 0;
+
+  for (its = thd->spider_conn_map.begin(); its != thd->spider_conn_map.end(); its++)
+  {
+    if (its->second)
+    {
+      spider_conn = its->second;
+      break;
+    }
+  }
+  if (!spider_conn)
+  {
+    err_msg = "no spider available to get definition of " + db_name + "." + tb_name;
+    return 1;
+  }
+  TC_SCHEMA_CATALOG_ENTRY spider_entry;
+  spider_entry.db_name = db_name;
+  spider_entry.tb_name = tb_name;
+  spider_entry.server_name = "";
+  if (tc_catalog_show_create(spider_conn, db_name, tb_name,
+    spider_entry.create_sql, err_msg))
+    return 1;
+  entry_list.push_back(spider_entry);
+
+  /* remotes in parallel, database on remote is db_name_<hash> */
+  for (auto &remote : thd->remote_ipport_map)
+  {
+    string server_name = remote.first;
+    MYSQL *mysql = thd->remote_conn_map[remote.second];
+    string remote_db = db_name + "_" + server_name.substr(prefix_len);
+    TC_SCHEMA_CATALOG_ENTRY *entry = &remote_list[i];
+    int *ret = &ret_list[i];
+    string *msg = &msg_list[i];
+    entry->db_name = db_name;
+    entry->tb_name = tb_name;
+    entry->server_name = server_name;
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, [=]() {
+      *ret = tc_catalog_show_create(mysql, remote_db, tb_name,
+        entry->create_sql, *msg);
+    }));
+    thread_list.push_back(std::move(tmp_t));
+    i++;
+  }
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+  for (i = 0; i < remote_list.size(); i++)
+  {
+    if (ret_list[i])
+    {
+      err_msg = msg_list[i];
+      result = 1;
+      break;
+    }
+    entry_list.push_back(remote_list[i]);
+  }
+  return result;
+}
+
+/*
+  record the DDL and the new definitions in the catalog
+
+  @NOTE:
+    called after tc_ddl_run succeed on all nodes, the log row and catalog
+    rows are written in one transaction on the primary tdbctl, the version
+    of the changed rows is the id of the log row.
+    failure only gives a warning, the DDL itself has succeed.
+
+  @retval
+    FALSE ok
+    TRUE error
+*/
+bool tc_schema_catalog_update(
+  THD *thd,
+  enum_sql_command sql_command,
+  TC_PARSE_RESULT *parse_result)
+{
+  int ret = 0;
+  string err_msg = "";
+  string db_name = parse_result->db_name;
+  string tb_name = parse_result->table_name;
+  string new_db_name = parse_result->new_db_name.empty() ?
+    db_name : parse_result->new_db_name;
+  string new_tb_name = parse_result->new_table_name;
+  /* objects to delete from catalog, tb_name '*' for whole database */
+  list<pair<string, string> > drop_list;
+  /* objects to get new definition */
+  list<pair<string, string> > refresh_list;
+  vector<TC_SCHEMA_CATALOG_ENTRY> entry_list;
+  string sql = "";
+  tc_exec_info exec_info;
+
+  switch (sql_command)
+  {
+  case SQLCOM_CREATE_DB:
+  case SQLCOM_ALTER_DB:
+    refresh_list.push_back(pair<string, string>(db_name, ""));
+    break;
+  case SQLCOM_DROP_DB:
+    drop_list.push_back(pair<string, string>(db_name, "*"));
+    break;
+  case SQLCOM_DROP_TABLE:
+    drop_list.push_back(pair<string, string>(db_name, tb_name));
+    break;
+  case SQLCOM_CREATE_TABLE:
+  case SQLCOM_ALTER_TABLE:
+  case SQLCOM_CREATE_INDEX:
+  case SQLCOM_DROP_INDEX:
+  case SQLCOM_RENAME_TABLE:
+    if (!new_tb_name.empty())
+    {/* rename */
+      drop_list.push_back(pair<string, string>(db_name, tb_name));
+      refresh_list.push_back(pair<string, string>(new_db_name, new_tb_name));
+    }
+    else
+      refresh_list.push_back(pair<string, string>(db_name, tb_name));
+    break;
+  default:
+    /* only spider objects, log only */
+    break;
+  }
+
+  for (auto &obj : refresh_list)
+  {
+    if (tc_catalog_collect(thd, obj.first, obj.second, entry_list, err_msg))
+    {
+      ret = 1;
+      goto finish;
+    }
+  }
+
+  {
+    MYSQL *conn = tc_tdbctl_conn_primary(ret, thd->tdbctl_ipport_map,
+      thd->tdbctl_user_map, thd->tdbctl_passwd_map);
+    MYSQL_GUARD(conn);
+    if (ret)
+    {/* error of connect is reported by warning only */
+      if (thd->is_error())
+        thd->clear_error();
+      err_msg = "failed to connect to primary tdbctl";
+      goto finish;
+    }
+
+    sql = "set sql_log_bin=1;begin;insert into " TC_SCHEMA_CATALOG_LOG_TABLE
+      "(db_name,tb_name,sql_type,query) values(" +
+      tc_catalog_quote(conn, db_name) + "," + tc_catalog_quote(conn, tb_name) + "," +
+      tc_catalog_quote(conn, get_stmt_type_str(sql_command)) + "," +
+      tc_catalog_quote(conn, string(thd->query().str, thd->query().length)) + ");"
+      "set @tc_catalog_version=last_insert_id();";
+    for (auto &obj : drop_list)
+    {
+      sql += "delete from " TC_SCHEMA_CATALOG_TABLE " where db_name=" +
+        tc_catalog_quote(conn, obj.first);
+      if (obj.second != "*")
+        sql += " and tb_name=" + tc_catalog_quote(conn, obj.second);
+      sql += ";";
+    }
+    for (auto &entry : entry_list)
+    {
+      sql += "replace into " TC_SCHEMA_CATALOG_TABLE
+        "(db_name,tb_name,server_name,version,create_sql) values(" +
+        tc_catalog_quote(conn, entry.db_name) + "," +
+        tc_catalog_quote(conn, entry.tb_name) + "," +
+        tc_catalog_quote(conn, entry.server_name) + ",@tc_catalog_version," +
+        tc_catalog_quote(conn, entry.create_sql) + ");";
+    }
+    sql += "commit";
+
+    if (tc_exec_sql_without_result(conn, sql, &exec_info))
+    {
+      ret = 1;
+      err_msg = exec_info.err_msg;
+      tc_exec_sql_without_result(conn, "rollback", &exec_info);
+    }
+  }
+
+finish:
+  if (ret)
+  {
+    sql_print_warning("TDBCTL: failed to update schema catalog for %s.%s: %s",
+      db_name.c_str(), tb_name.c_str(), err_msg.c_str());
+    push_warning_printf(thd, Sql_condition::SL_WARNING, ER_TCADMIN_EXECUTE_ERROR,
+      "failed to update schema catalog: %s", err_msg.c_str());
+  }
+  return ret != 0;
+}
+
+/*
+  read entries from the catalog
+
+  @param
+    where_sql: condition of the entries, empty for all
+  @retval
+    0 ok
+    1 error
+*/
+int tc_schema_catalog_read(
+  MYSQL *tdbctl_conn,
+  string where_sql,
+  vector<TC_SCHEMA_CATALOG_ENTRY> &entry_list)
+{
+  string sql = "select db_name,tb_name,server_name,version,create_sql from "
+    TC_SCHEMA_CATALOG_TABLE;
+  if (!where_sql.empty())
+    sql += " where " + where_sql;
+  MYSQL_RES *res = tc_exec_sql_with_result(tdbctl_conn, sql);
+  MYSQL_RES_GUARD(res);
+  MYSQL_ROW row = NULL;
+  if (!res)
+    return 1;
+  while ((row = mysql_fetch_row(res)))
+  {
+    TC_SCHEMA_CATALOG_ENTRY entry;
+    entry.db_name = row[0];
+    entry.tb_name = row[1];
+    entry.server_name = row[2];
+    entry.version = strtoull(row[3], NULL, 10);
+    entry.create_sql = row[4] ? row[4] : "";
+    entry_list.push_back(entry);
+  }
+  return 0;
+}
+
+/*
+  normalize SHOW CREATE TABLE for compare between spider and remotes
+
+  @NOTE:
+    partition clause and table options except charset/collate are removed,
+    database of the shard(db_N) is replaced by the logical database.
+*/
+static string tc_normalize_create_table(string create_sql, string remote_db,
+  string db_name)
+{
+  string body, options, res;
+  size_t end_def = create_sql.find("\n)");
+  if (end_def == string::npos)
+    return create_sql;
+  body = create_sql.substr(0, end_def + 2);
+  options = create_sql.substr(end_def + 2);
+  options = options.substr(0, options.find('\n'));
+
+  if (remote_db != db_name)
+  {
+    string from = "`" + remote_db + "`";
+    string to = "`" + db_name + "`";
+    size_t pos = 0;
+    while ((pos = body.find(from, pos)) != string::npos)
+    {
+      body.replace(pos, from.length(), to);
+      pos += to.length();
+    }
+  }
+
+  res = body;
+  regex pattern("(DEFAULT CHARSET|COLLATE)=\\w+");
+  for (sregex_iterator it(options.begin(), options.end(), pattern), end;
+    it != end; ++it)
+    res += " " + it->str();
+  return res;
+}
+
+/* lines of expected not in actual with '-', lines of actual not in expected with '+' */
+static string tc_schema_line_diff(string expected, string actual)
+{
+  multiset<string> expected_set, actual_set;
+  string diff = "";
+  stringstream ss_expected(expected), ss_actual(actual);
+  string line;
+  while (getline(ss_expected, line))
+    expected_set.insert(line);
+  while (getline(ss_actual, line))
+    actual_set.insert(line);
+
+  for (auto &l : expected_set)
+  {
+    if (!actual_set.count(l))
+      diff += "- " + l + "\n";
+  }
+  for (auto &l : actual_set)
+  {
+    if (!expected_set.count(l))
+      diff += "+ " + l + "\n";
+  }
+  if (!diff.empty())
+    diff.erase(diff.length() - 1);
+  return diff;
+}
+
+/*
+  get normalized definition hash of tables on one node
+
+  @NOTE:
+    SHOW CREATE TABLE is sent as multi-statement batches, the batch is
+    resent from the next table after an error such as table not exist.
+    one text of every distinct hash is kept in sample_map for diff.
+*/
+static void tc_check_schema_on_node(
+  TC_CHECK_SCHEMA_NODE *node,
+  vector<pair<string, string> > *table_list,
+  map<string, map<ha_checksum, string> > *sample_map,
+  std::mutex *sample_mutex)
+{
+  MYSQL *mysql = tc_conn_connect(node->ipport, node->user, node->passwd);
+  MYSQL_GUARD(mysql);
+  size_t begin = 0;
+  if (!mysql)
+  {
+    node->conn_error = "failed to connect to " + node->ipport;
+    return;
+  }
+
+  while (begin < table_list->size())
+  {
+    size_t end = begin + TC_CHECK_SCHEMA_BATCH_SIZE;
+    size_t done = 0;
+    string exec_sql = "";
+    int ret;
+    TC_PSI_STATEMENT stmt;
+    if (end > table_list->size())
+      end = table_list->size();
+    for (size_t i = begin; i < end; i++)
+      exec_sql += "show create table `" + (*table_list)[i].first + node->db_suffix +
+        "`.`" + (*table_list)[i].second + "`;";
+
+    tc_psi_statement_start(&stmt, TC_PSI_STATEMENT_QUERY, tc_mysql_ipport(mysql),
+      exec_sql.c_str(), exec_sql.length());
+    ret = mysql_real_query(mysql, exec_sql.c_str(), exec_sql.length());
+    while (!ret)
+    {
+      pair<string, string> &table = (*table_list)[begin + done];
+      string key = table.first + "." + table.second;
+      MYSQL_RES *res = mysql_store_result(mysql);
+      MYSQL_RES_GUARD(res);
+      MYSQL_ROW row = NULL;
+      if (res && (row = mysql_fetch_row(res)) && row[1])
+      {
+        string text = tc_normalize_create_table(row[1],
+          table.first + node->db_suffix, table.first);
+        ha_checksum hash = my_checksum(0, (const uchar*)text.c_str(), text.length());
+        node->hash_map[key] = hash;
+        std::lock_guard<std::mutex> lock(*sample_mutex);
+        map<ha_checksum, string> &samples = (*sample_map)[key];
+        if (!samples.count(hash))
+          samples[hash] = text;
+      }
+      else
+        node->error_map[key] = "can't get definition";
+      done++;
+      ret = tc_mysql_next_result(mysql);
+    }
+    tc_psi_statement_end(&stmt, mysql, ret != -1, 0);
+    if (ret == -1)
+    {
+      begin = end;
+      continue;
+    }
+
+    uint err_code = mysql_errno(mysql);
+    pair<string, string> &table = (*table_list)[begin + done];
+    string key = table.first + "." + table.second;
+    if (err_code == CR_SERVER_GONE_ERROR || err_code == CR_SERVER_LOST)
+    {
+      node->conn_error = mysql_error(mysql);
+      return;
+    }
+    node->error_map[key] = err_code == ER_NO_SUCH_TABLE ?
+      "missing" : string(mysql_error(mysql));
+    begin = begin + done + 1;
+  }
+}
+
+/* get tables to check from spider, excluding tc_skip_dump_db_list */
+static int tc_check_schema_tables(
+  MYSQL *mysql,
+  string db_name,
+  string tb_name,
+  vector<pair<string, string> > &table_list)
+{
+  string sql = "select TABLE_SCHEMA,TABLE_NAME from information_schema.TABLES "
+    " where TABLE_TYPE='BASE TABLE'";
+  if (!db_name.empty())
+    sql += " and TABLE_SCHEMA=" + tc_catalog_quote(mysql, db_name);
+  if (!tb_name.empty())
+    sql += " and TABLE_NAME=" + tc_catalog_quote(mysql, tb_name);
+  if (db_name.empty())
+  {
+    string dbs = tc_skip_dump_db_list ? tc_skip_dump_db_list : "";
+    string not_in = "'information_schema','performance_schema'";
+    size_t pos = 0;
+    while ((pos = dbs.find(",")) != string::npos)
+    {
+      not_in += "," + tc_catalog_quote(mysql, dbs.substr(0, pos));
+      dbs.erase(0, pos + 1);
+    }
+    if (!dbs.empty())
+      not_in += "," + tc_catalog_quote(mysql, dbs);
+    sql += " and TABLE_SCHEMA not in (" + not_in + ")";
+  }
+  sql += " order by TABLE_SCHEMA,TABLE_NAME";
+
+  MYSQL_RES *res = tc_exec_sql_with_result(mysql, sql);
+  MYSQL_RES_GUARD(res);
+  MYSQL_ROW row = NULL;
+  if (!res)
+    return 1;
+  while ((row = mysql_fetch_row(res)))
+    table_list.push_back(pair<string, string>(row[0], row[1]));
+  return 0;
+}
+
+/*
+  TDBCTL CHECK SCHEMA [db[.table]]
+  compare definition of tables on all spiders and remotes
+
+  @NOTE:
+    definitions are compared by hash of normalized SHOW CREATE TABLE,
+    expected definition is from the catalog if some node matches it,
+    otherwise the one most nodes have. only mismatching nodes are sent,
+    with the diff against the expected definition.
+
+  @retval
+    FALSE ok
+    TRUE error, my_error is set
+*/
+bool tc_check_schema(THD *thd, LEX_STRING db, LEX_STRING table)
+{
+  MEM_ROOT mem_root;
+  list<FOREIGN_SERVER*> spider_list;
+  list<FOREIGN_SERVER*> remote_list;
+  vector<TC_CHECK_SCHEMA_NODE> node_list;
+  vector<pair<string, string> > table_list;
+  map<string, map<ha_checksum, string> > sample_map;
+  map<string, ha_checksum> catalog_hash_map;
+  std::mutex sample_mutex;
+  list<thread> thread_list;
+  List<Item> field_list;
+  Protocol *protocol = thd->get_protocol();
+  string db_name = db.str ? string(db.str, db.length) : "";
+  string tb_name = table.str ? string(table.str, table.length) : "";
+  size_t prefix_len = strlen(tdbctl_mysql_wrapper_prefix);
+  DBUG_ENTER("tc_check_schema");
+
+  init_sql_alloc(key_memory_for_tdbctl, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+  MEM_ROOT_GUARD(mem_root);
+  get_server_by_wrapper(spider_list, &mem_root, SPIDER_WRAPPER, TRUE);
+  get_server_by_wrapper(remote_list, &mem_root, MYSQL_WRAPPER, FALSE);
+  for (auto &server : spider_list)
+  {
+    TC_CHECK_SCHEMA_NODE node;
+    node.server_name = server->server_name;
+    node.ipport = string(server->host) + "#" + to_string(server->port);
+    node.user = server->username;
+    node.passwd = server->password;
+    node.db_suffix = "";
+    node_list.push_back(node);
+  }
+  for (auto &server : remote_list)
+  {
+    TC_CHECK_SCHEMA_NODE node;
+    node.server_name = server->server_name;
+    node.ipport = string(server->host) + "#" + to_string(server->port);
+    node.user = server->username;
+    node.passwd = server->password;
+    node.db_suffix = "_" + node.server_name.substr(prefix_len);
+    node_list.push_back(node);
+  }
+
+  /* tables to check, from the first spider */
+  {
+    MYSQL *mysql = NULL;
+    if (spider_list.empty() ||
+      !(mysql = tc_conn_connect(node_list[0].ipport, node_list[0].user,
+        node_list[0].passwd)))
+    {
+      my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), "no spider available to get tables");
+      DBUG_RETURN(TRUE);
+    }
+    MYSQL_GUARD(mysql);
+    if (tc_check_schema_tables(mysql, db_name, tb_name, table_list))
+    {
+      my_error(ER_TCADMIN_EXECUTE_ERROR, MYF(0), mysql_error(mysql));
+      DBUG_RETURN(TRUE);
+    }
+  }
+
+  /* expected definitions from the catalog */
+  {
+    int ret = 0;
+    map<string, string> tdbctl_user_map;
+    map<string, string> tdbctl_passwd_map;
+    map<string, string> tdbctl_ipport_map = get_tdbctl_ipport_map(&mem_root,
+      tdbctl_user_map, tdbctl_passwd_map);
+    MYSQL *conn = tc_tdbctl_conn_primary(ret, tdbctl_ipport_map,
+      tdbctl_user_map, tdbctl_passwd_map);
+    MYSQL_GUARD(conn);
+    vector<TC_SCHEMA_CATALOG_ENTRY> entry_list;
+    string where_sql = "server_name='' and tb_name<>''";
+    if (thd->is_error())
+      thd->clear_error();
+    if (!db_name.empty())
+      where_sql += " and db_name=" + tc_catalog_quote(conn, db_name);
+    if (!tb_name.empty())
+      where_sql += " and tb_name=" + tc_catalog_quote(conn, tb_name);
+    if (!ret && !tc_schema_catalog_read(conn, where_sql, entry_list))
+    {
+      for (auto &entry : entry_list)
+      {
+        string text = tc_normalize_create_table(entry.create_sql,
+          entry.db_name, entry.db_name);
+        string key = entry.db_name + "." + entry.tb_name;
+        ha_checksum hash = my_checksum(0, (const uchar*)text.c_str(), text.length());
+        catalog_hash_map[key] = hash;
+        sample_map[key][hash] = text;
+      }
+    }
+  }
+
+  for (auto &node : node_list)
+  {
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_check_schema_on_node,
+      &node, &table_list, &sample_map, &sample_mutex));
+    thread_list.push_back(std::move(tmp_t));
+  }
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+
+  field_list.push_back(new Item_empty_string("Db", NAME_CHAR_LEN));
+  field_list.push_back(new Item_empty_string("Table", NAME_CHAR_LEN));
+  field_list.push_back(new Item_empty_string("Server_name", NAME_CHAR_LEN));
+  field_list.push_back(new Item_empty_string("Status", 16));
+  field_list.push_back(new Item_empty_string("Diff", 1024));
+  if (thd->send_result_metadata(&field_list,
+    Protocol::SEND_NUM_ROWS | Protocol::SEND_EOF))
+    DBUG_RETURN(TRUE);
+
+  /* nodes can't be checked */
+  for (auto &node : node_list)
+  {
+    if (node.conn_error.empty())
+      continue;
+    protocol->start_row();
+    protocol->store("", system_charset_info);
+    protocol->store("", system_charset_info);
+    protocol->store(node.server_name.c_str(), system_charset_info);
+    protocol->store("error", system_charset_info);
+    protocol->store(node.conn_error.c_str(), system_charset_info);
+    if (protocol->end_row())
+      DBUG_RETURN(TRUE);
+  }
+
+  for (auto &table : table_list)
+  {
+    string key = table.first + "." + table.second;
+    map<ha_checksum, ulong> count_map;
+    ha_checksum expected = 0;
+    ulong max_count = 0;
+    for (auto &node : node_list)
+    {
+      if (node.hash_map.count(key))
+        count_map[node.hash_map[key]]++;
+    }
+    for (auto &count : count_map)
+    {
+      if (count.second > max_count)
+      {
+        max_count = count.second;
+        expected = count.first;
+      }
+    }
+    if (catalog_hash_map.count(key) && count_map.count(catalog_hash_map[key]))
+      expected = catalog_hash_map[key];
+
+    for (auto &node : node_list)
+    {
+      string status = "";
+      string diff = "";
+      if (!node.conn_error.empty())
+        continue;
+      if (node.error_map.count(key))
+      {
+        status = node.error_map[key] == "missing" ? "missing" : "error";
+        diff = node.error_map[key];
+      }
+      else if (node.hash_map.count(key) && node.hash_map[key] != expected)
+      {
+        status = "mismatch";
+        diff = tc_schema_line_diff(sample_map[key][expected],
+          sample_map[key][node.hash_map[key]]);
+      }
+      else
+        continue;
+
+      protocol->start_row();
+      protocol->store(table.first.c_str(), system_charset_info);
+      protocol->store(table.second.c_str(), system_charset_info);
+      protocol->store(node.server_name.c_str(), system_charset_info);
+      protocol->store(status.c_str(), system_charset_info);
+      protocol->store(diff.c_str(), system_charset_info);
+      if (protocol->end_row())
+        DBUG_RETURN(TRUE);
+    }
+  }
+
+  my_eof(thd);
+  DBUG_RETURN(FALSE);
+}
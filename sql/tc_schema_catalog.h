@@ -0,0 +1,75 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+#ifndef TC_SCHEMA_CATALOG_INCLUDED
+#define TC_SCHEMA_CATALOG_INCLUDED
+
+/*
+  Schema catalog of the cluster, maintained by tdbctl after each DDL
+
+  cluster_admin.tc_schema_catalog_log: one row for every successful DDL,
+    version is the auto increment id of the row
+  cluster_admin.tc_schema_catalog: current definition of databases and
+    tables, server_name is '' for the logical(spider) definition and
+    SPT<n> for the definition on the remote shard
+*/
+
+#include "my_global.h"
+#include "my_sqlcommand.h"
+#include "mysql.h"
+#include "my_sys.h"
+#include <string>
+#include <map>
+#include <vector>
+using namespace std;
+
+#define TC_SCHEMA_CATALOG_TABLE "cluster_admin.tc_schema_catalog"
+#define TC_SCHEMA_CATALOG_LOG_TABLE "cluster_admin.tc_schema_catalog_log"
+/* max SHOW CREATE TABLE of one batch sent to node when check schema */
+#define TC_CHECK_SCHEMA_BATCH_SIZE 500
+
+class THD;
+struct tc_parse_result;
+
+/* definition of one object in the catalog */
+typedef struct tc_schema_catalog_entry
+{
+  string db_name;
+  string tb_name;
+  string server_name;
+  ulonglong version;
+  string create_sql;
+} TC_SCHEMA_CATALOG_ENTRY;
+
+/*
+  state of one node in TDBCTL CHECK SCHEMA
+  db_suffix: '' for spider, _<n> for remote SPT<n>
+  hash_map: db.tb-->hash of normalized definition
+  error_map: db.tb-->error when get definition, "missing" for not exist
+*/
+typedef struct tc_check_schema_node
+{
+  string server_name;
+  string ipport;
+  string user;
+  string passwd;
+  string db_suffix;
+  map<string, ha_checksum> hash_map;
+  map<string, string> error_map;
+  string conn_error;
+} TC_CHECK_SCHEMA_NODE;
+
+bool tc_schema_catalog_update(
+  THD *thd,
+  enum_sql_command sql_command,
+  struct tc_parse_result *parse_result);
+
+int tc_schema_catalog_read(
+  MYSQL *tdbctl_conn,
+  string where_sql,
+  vector<TC_SCHEMA_CATALOG_ENTRY> &entry_list);
+
+bool tc_check_schema(THD *thd, LEX_STRING db, LEX_STRING table);
+
+#endif /* TC_SCHEMA_CATALOG_INCLUDED */
@@ -10,6 +10,19 @@ Add for node's show
 #include "tc_base.h"
 #include "mysql.h"
 #include "protocol.h"                       // Protocol
+#include "item_cmpfunc.h"
+#include "sql_servers.h"
+#include "violite.h"                        // vio_shutdown
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <vector>
+#include <functional>
+
+/* max rows buffered by TDBCTL SHOW PROCESSLIST before sent to client */
+#define TC_SHOW_STREAM_SIZE 1024
 
 using namespace std;
 
@@ -40,14 +53,391 @@ static void protocol_store_field(Protocol *protocol, MYSQL_FIELD field, const ch
 	DBUG_VOID_RETURN;
 }
 
+/*
+  rows of TDBCTL SHOW fetched from all nodes, which nodes put rows in
+  and client thread takes rows out to send.
+
+  running: nodes still fetching rows
+  stop: client thread needs no more rows, such as LIMIT reached
+*/
+typedef struct tc_show_stream_row
+{
+	size_t node;
+	vector<string> values;
+	vector<bool> is_null;
+} TC_SHOW_STREAM_ROW;
+
+typedef struct tc_show_stream_node
+{
+	string server_name;
+	string ipport;
+	string user;
+	string passwd;
+	string wrapper;
+	vector<MYSQL_FIELD> fields;
+	string error;
+	bool straggler;
+} TC_SHOW_STREAM_NODE;
+
+typedef struct tc_show_stream
+{
+	std::mutex mtx;
+	std::condition_variable cond;
+	deque<TC_SHOW_STREAM_ROW> rows;
+	uint running;
+	bool stop;
+} TC_SHOW_STREAM;
+
+/*
+  fetch rows from one node with mysql_use_result and put into stream,
+  wait when the stream is full until client thread takes rows out.
+  every read from node waits until deadline at most, node is a straggler
+  if it fails after deadline, rows sent before are kept.
+*/
+static void tc_show_stream_from_node(TC_SHOW_STREAM *stream,
+	vector<TC_SHOW_STREAM_NODE> *node_list, size_t node_idx, string show_sql,
+	ulonglong deadline)
+{
+	TC_SHOW_STREAM_NODE *node = &(*node_list)[node_idx];
+	MYSQL *mysql = tc_conn_connect_by_deadline(node->ipport, node->user,
+		node->passwd, deadline);
+	MYSQL_RES *res = NULL;
+	bool stopped = FALSE;
+	ulonglong rows_sent = 0;
+	TC_PSI_STATEMENT stmt;
+
+	if (mysql)
+		tc_psi_statement_start(&stmt, TC_PSI_STATEMENT_QUERY, node->ipport,
+			show_sql.c_str(), show_sql.length());
+	if (mysql == NULL)
+		node->error = "failed to connect to " + node->ipport;
+	else if (tc_conn_set_deadline(mysql, deadline))
+		node->error = "no time left to query";
+	else if (mysql_real_query(mysql, show_sql.c_str(), show_sql.length()) ||
+		!(res = mysql_use_result(mysql)))
+		node->error = mysql_error(mysql);
+	else
+	{
+		MYSQL_ROW row;
+		uint num_fields = mysql_num_fields(res);
+		MYSQL_FIELD *fields = mysql_fetch_fields(res);
+		node->fields.assign(fields, fields + num_fields);
+		while (!stopped && (row = mysql_fetch_row(res)) != NULL)
+		{
+			TC_SHOW_STREAM_ROW stream_row;
+			ulong *lengths = mysql_fetch_lengths(res);
+			stream_row.node = node_idx;
+			for (uint i = 0; i < num_fields; i++)
+			{
+				stream_row.is_null.push_back(row[i] == NULL);
+				stream_row.values.push_back(row[i] ? string(row[i], lengths[i]) : "");
+			}
+
+			std::unique_lock<std::mutex> lock(stream->mtx);
+			stream->cond.wait(lock, [stream] {
+				return stream->stop || stream->rows.size() < TC_SHOW_STREAM_SIZE; });
+			if (stream->stop)
+				stopped = TRUE;
+			else
+			{
+				stream->rows.push_back(std::move(stream_row));
+				stream->cond.notify_all();
+				rows_sent++;
+			}
+		}
+		if (!stopped && mysql_errno(mysql))
+			node->error = mysql_error(mysql);
+	}
+	if (mysql)
+		tc_psi_statement_end(&stmt, mysql, !node->error.empty(), rows_sent);
+	node->straggler = !node->error.empty() && tc_fanout_deadline_passed(deadline);
+
+	/*
+	  result still unread when stopped or failed, shut down the connection
+	  first so that mysql_free_result doesn't read the rest rows, then free
+	  result before close, it refers to the connection.
+	*/
+	if (res && res->handle && mysql->net.vio)
+		vio_shutdown(mysql->net.vio, SHUT_RDWR);
+	if (res)
+		mysql_free_result(res);
+	if (mysql)
+		mysql_close(mysql);
+
+	std::lock_guard<std::mutex> lock(stream->mtx);
+	stream->running--;
+	stream->cond.notify_all();
+}
+
+/*
+  get nodes for TDBCTL SHOW
+
+  @param
+    server_name: only the server if not NULL
+    wrapper: servers of the wrapper(with slave), NULL_WRAPPER for all
+
+  @retval
+    FALSE ok
+    TRUE error, my_error is set
+*/
+static bool tc_show_stream_nodes(const char *server_name, const char *wrapper,
+	vector<TC_SHOW_STREAM_NODE> &node_list)
+{
+	MEM_ROOT mem_root;
+	list<FOREIGN_SERVER*> server_list;
+
+	init_sql_alloc(key_memory_for_tdbctl, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+	MEM_ROOT_GUARD(mem_root);
+	if (server_name != NULL) {
+		FOREIGN_SERVER *server = get_server_by_name(&mem_root, server_name, NULL);
+		if (server == NULL)
+		{
+			my_error(ER_FOREIGN_SERVER_DOESNT_EXIST, MYF(0), server_name);
+			return TRUE;
+		}
+		server_list.push_back(server);
+	}
+	else
+		get_server_by_wrapper(server_list, &mem_root, wrapper, TRUE);
+
+	for (auto &server : server_list)
+	{
+		TC_SHOW_STREAM_NODE node;
+		node.server_name = server->server_name;
+		node.ipport = string(server->host) + "#" + to_string(server->port);
+		node.user = server->username;
+		node.passwd = server->password;
+		node.wrapper = server->scheme;
+		node.straggler = FALSE;
+		node_list.push_back(node);
+	}
+	return FALSE;
+}
+
+/*
+  run show_sql on all nodes and call process_row for every row as soon as
+  any node produces it, until max_rows rows processed or process_row
+  returns TRUE.
+
+  @NOTE:
+    called after result metadata sent, nodes failed are reported as warnings,
+    nodes not replied within tc_fanout_read_timeout are reported as
+    stragglers and not waited for.
+
+  @retval
+    FALSE ok
+    TRUE process_row failed
+*/
+static bool tc_show_stream_run(THD *thd,
+	vector<TC_SHOW_STREAM_NODE> &node_list, string show_sql, ha_rows max_rows,
+	std::function<bool(TC_SHOW_STREAM_NODE&, TC_SHOW_STREAM_ROW&)> process_row)
+{
+	list<thread> thread_list;
+	TC_SHOW_STREAM stream;
+	ha_rows processed_rows = 0;
+	bool error = FALSE;
+	ulong timeout = thd->variables.tc_fanout_read_timeout;
+	ulonglong deadline = tc_fanout_deadline(timeout);
+
+	stream.running = node_list.size();
+	stream.stop = (max_rows == 0);
+	for (size_t i = 0; i < node_list.size(); i++)
+	{
+		thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_show_stream_from_node,
+			&stream, &node_list, i, show_sql, deadline));
+		thread_list.push_back(std::move(tmp_t));
+	}
+
+	while (TRUE)
+	{
+		TC_SHOW_STREAM_ROW row;
+		{
+			std::unique_lock<std::mutex> lock(stream.mtx);
+			stream.cond.wait(lock, [&stream] {
+				return stream.stop || !stream.rows.empty() || stream.running == 0; });
+			if (stream.stop || stream.rows.empty())
+				break;
+			row = std::move(stream.rows.front());
+			stream.rows.pop_front();
+			stream.cond.notify_all();
+		}
+
+		if ((error = process_row(node_list[row.node], row)) ||
+			++processed_rows >= max_rows)
+		{
+			std::lock_guard<std::mutex> lock(stream.mtx);
+			stream.stop = TRUE;
+			stream.cond.notify_all();
+			break;
+		}
+	}
+
+	for (auto &td : thread_list)
+	{
+		if (td.joinable())
+			td.join();
+	}
+
+	for (auto &node : node_list)
+	{
+		if (node.straggler)
+			push_warning_printf(thd, Sql_condition::SL_WARNING, ER_TCADMIN_EXECUTE_ERROR,
+				"%s: straggler, no reply within tc_fanout_read_timeout(%lu) seconds, "
+				"rows may be partial: %s", node.server_name.c_str(), timeout,
+				node.error.c_str());
+		else if (!node.error.empty())
+			push_warning_printf(thd, Sql_condition::SL_WARNING, ER_TCADMIN_EXECUTE_ERROR,
+				"%s: %s", node.server_name.c_str(), node.error.c_str());
+	}
+
+	return error;
+}
+
+/* columns of TDBCTL SHOW PROCESSLIST WHERE can refer to */
+static const char *tc_processlist_columns[] =
+{ "ID", "USER", "HOST", "DB", "COMMAND", "TIME", "STATE", "INFO", NULL };
+
+/* append column of processlist, TRUE if item is not one */
+static bool tc_show_push_column(Item *item, string &sql)
+{
+	if (item->type() != Item::FIELD_ITEM)
+		return TRUE;
+	Item_field *field = (Item_field*)item;
+	if (!field->field_name || field->table_name)
+		return TRUE;
+	for (uint i = 0; tc_processlist_columns[i]; i++)
+	{
+		if (!my_strcasecmp(system_charset_info, field->field_name,
+			tc_processlist_columns[i]))
+		{
+			sql += string("`") + tc_processlist_columns[i] + "`";
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/* append escaped constant, TRUE if item is not a constant */
+static bool tc_show_push_value(Item *item, string &sql)
+{
+	String tmp, *value;
+	if (!item->basic_const_item() || item->type() == Item::NULL_ITEM ||
+		!(value = item->val_str(&tmp)))
+		return TRUE;
+	tc_append_quoted_value(sql, value->ptr(), value->length());
+	return FALSE;
+}
+
+/*
+  render WHERE of TDBCTL SHOW PROCESSLIST for nodes
+
+  @NOTE:
+    only AND/OR of "column op constant" is rendered, op is one of
+    =,<>,<,<=,>,>=,LIKE without ESCAPE,[NOT] IN,IS [NOT] NULL.
+    constants are escaped, so nothing else than the predicates runs
+    on nodes with the internal account.
+
+  @retval
+    FALSE ok
+    TRUE cond has other expressions
+*/
+static bool tc_show_push_cond(Item *cond, string &sql)
+{
+	if (cond->type() == Item::COND_ITEM)
+	{
+		Item_cond *cond_item = (Item_cond*)cond;
+		const char *sep;
+		bool first = TRUE;
+		if (cond_item->functype() == Item_func::COND_AND_FUNC)
+			sep = " and ";
+		else if (cond_item->functype() == Item_func::COND_OR_FUNC)
+			sep = " or ";
+		else
+			return TRUE;
+		List_iterator<Item> li(*cond_item->argument_list());
+		Item *item;
+		sql += "(";
+		while ((item = li++))
+		{
+			if (!first)
+				sql += sep;
+			first = FALSE;
+			if (tc_show_push_cond(item, sql))
+				return TRUE;
+		}
+		sql += ")";
+		return FALSE;
+	}
+	if (cond->type() != Item::FUNC_ITEM)
+		return TRUE;
+
+	Item_func *func = (Item_func*)cond;
+	Item **args = func->arguments();
+	const char *op;
+	if (func->argument_count() < 1 || tc_show_push_column(args[0], sql))
+		return TRUE;
+	switch (func->functype())
+	{
+	case Item_func::ISNULL_FUNC:
+		sql += " is null";
+		return func->argument_count() != 1;
+	case Item_func::ISNOTNULL_FUNC:
+		sql += " is not null";
+		return func->argument_count() != 1;
+	case Item_func::IN_FUNC:
+		sql += ((Item_func_opt_neg*)func)->negated ? " not in (" : " in (";
+		for (uint i = 1; i < func->argument_count(); i++)
+		{
+			if (i > 1)
+				sql += ",";
+			if (tc_show_push_value(args[i], sql))
+				return TRUE;
+		}
+		sql += ")";
+		return func->argument_count() < 2;
+	case Item_func::EQ_FUNC: op = " = "; break;
+	case Item_func::NE_FUNC: op = " <> "; break;
+	case Item_func::LT_FUNC: op = " < "; break;
+	case Item_func::LE_FUNC: op = " <= "; break;
+	case Item_func::GT_FUNC: op = " > "; break;
+	case Item_func::GE_FUNC: op = " >= "; break;
+	case Item_func::LIKE_FUNC:
+		if (((Item_func_like*)func)->escape_was_used_in_parsing())
+			return TRUE;
+		op = " like ";
+		break;
+	default:
+		return TRUE;
+	}
+	if (func->argument_count() != 2)
+		return TRUE;
+	sql += op;
+	return tc_show_push_value(args[1], sql);
+}
+
 /*
   Tdbctl do show processlist.
 	transfer SHOW PROCESSLIST to all nodes executed and display
-	*/
-void tc_show_processlist(THD *thd, bool verbose, const char *server_name)
+
+  @param
+    where: rendered by tc_show_push_cond and pushed down to query of every node
+    limit: pushed down to query of every node, and total rows sent
+
+  @NOTE:
+    rows are sent to client as soon as any node produces them, tdbctl only
+    buffers TC_SHOW_STREAM_SIZE rows. nodes which failed are reported as
+    warnings.
+
+  @retval
+    FALSE ok
+    TRUE error, my_error is set
+*/
+bool tc_show_processlist(THD *thd, bool verbose, const char *server_name,
+	Item *where, Item *limit)
 {
-	map<string, MYSQL_RES*> result_map;
-	string show_sql = (verbose ? 
+	vector<TC_SHOW_STREAM_NODE> node_list;
+	ha_rows max_rows = (limit ? (ha_rows)limit->val_int() : HA_POS_ERROR);
+	string show_sql = (verbose ?
     "select ID,USER,HOST,DB,COMMAND,TIME,STATE,INFO from "
     " information_schema.processlist" :
     "select ID,USER,HOST,DB,COMMAND,TIME,STATE,substring(Info,1,100) "
@@ -60,6 +450,24 @@ void tc_show_processlist(THD *thd, bool verbose, const char *server_name)
 	Protocol *protocol = thd->get_protocol();
 	DBUG_ENTER("tc_show_processlist");
 
+	if (where)
+	{
+		string where_sql;
+		if (thd->lex->select_lex->first_inner_unit() ||
+			tc_show_push_cond(where, where_sql))
+		{
+			my_error(ER_NOT_SUPPORTED_YET, MYF(0), "WHERE other than AND/OR of "
+				"column op constant in TDBCTL SHOW PROCESSLIST");
+			DBUG_RETURN(TRUE);
+		}
+		show_sql += " where " + where_sql;
+	}
+	if (limit)
+		show_sql += " limit " + to_string(max_rows);
+
+	if (tc_show_stream_nodes(server_name, NULL_WRAPPER, node_list))
+		DBUG_RETURN(TRUE);
+
 	field_list.push_back(new Item_empty_string("Server_name", NAME_CHAR_LEN));
 	field_list.push_back(new Item_int(NAME_STRING("Id"),
 		0, MY_INT64_NUM_DECIMAL_DIGITS));
@@ -76,46 +484,21 @@ void tc_show_processlist(THD *thd, bool verbose, const char *server_name)
 	field->maybe_null = 1;
 	if (thd->send_result_metadata(&field_list,
 		Protocol::SEND_NUM_ROWS | Protocol::SEND_EOF))
-		DBUG_VOID_RETURN;
+		DBUG_RETURN(TRUE);
 
-	if (server_name != NULL) {
-		//get one server's processlist result.
-		MYSQL_RES *res = tc_exec_sql_by_server(show_sql, server_name);
-		result_map.insert(pair<string, MYSQL_RES *>(server_name, std::move(res)));
-	}
-	else {
-		//get all node's processlist result
-		result_map = tc_exec_sql_paral_by_wrapper(show_sql, NULL_WRAPPER, TRUE);
-	}
-	for_each(result_map.begin(), result_map.end(), [&protocol](std::pair<string, MYSQL_RES*> its) {
-		string server_name = its.first;
-		MYSQL_RES* res = its.second;
-		//use to free result.
-		MYSQL_RES_GUARD(res);
-		if (res != NULL)
-		{
-			uint i;
-			MYSQL_ROW row;
-			MYSQL_FIELD  field;
-			while ((row = mysql_fetch_row(res)) != NULL)
-			{
-			  protocol->start_row();
-				protocol->store(server_name.c_str(), system_charset_info);
-				res->current_field = 0;
-				for (i = 0; i < mysql_num_fields(res); i++)
-				{
-					field = res->fields[res->current_field++];
-					protocol_store_field(protocol, field, row[i]);
-				}
-				if (protocol->end_row())
-					break; /* purecov: inspected */
-			}
-		}
-	});
+	if (tc_show_stream_run(thd, node_list, show_sql, max_rows,
+		[protocol](TC_SHOW_STREAM_NODE &node, TC_SHOW_STREAM_ROW &row) -> bool {
+			protocol->start_row();
+			protocol->store(node.server_name.c_str(), system_charset_info);
+			for (size_t i = 0; i < row.values.size(); i++)
+				protocol_store_field(protocol, node.fields[i],
+					row.is_null[i] ? NULL : row.values[i].c_str());
+			return protocol->end_row();
+		}))
+		DBUG_RETURN(TRUE);
 
 	my_eof(thd);
-	result_map.clear();
-	DBUG_VOID_RETURN;
+	DBUG_RETURN(FALSE);
 }
 
 /*
@@ -216,3 +599,208 @@ void tc_show_variables(THD *thd, enum_var_type type, String *wild, const char *s
 
 }
 
+
+/*
+  aggregate of one status counter of one wrapper, counters of unsigned
+  integer on all nodes are summed in int_* so that big counters keep
+  their exact value, others and a sum overflowing ulonglong in double
+*/
+typedef struct tc_show_status_agg
+{
+	ulonglong int_sum;
+	ulonglong int_min;
+	ulonglong int_max;
+	double sum;
+	double min;
+	double max;
+	ulong nodes;
+	bool is_integer;
+} TC_SHOW_STATUS_AGG;
+
+static string tc_show_format_number(double value)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%.4f", value);
+	return buf;
+}
+
+static string tc_show_format_number(ulonglong value)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%llu", value);
+	return buf;
+}
+
+/* int_sum / nodes with 4 decimals as tc_show_format_number(double) */
+static string tc_show_format_avg(ulonglong sum, ulong nodes)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%llu.%04llu", sum / nodes,
+		(sum % nodes) * 10000 / nodes);
+	return buf;
+}
+
+/*
+  Tdbctl do show global status.
+	transfer SHOW GLOBAL STATUS to nodes executed and display
+
+  @param
+    wrapper: SPIDER, REMOTE or TDBCTL, empty for all nodes
+    aggregate: sum/min/max/avg of every numeric counter per wrapper
+    instead of rows of every node
+
+  @NOTE:
+    when aggregate, rows are folded on tdbctl as soon as any node produces
+    them, only one row per wrapper and counter is sent.
+
+  @retval
+    FALSE ok
+    TRUE error, my_error is set
+*/
+bool tc_show_global_status(THD *thd, const char *server_name,
+	LEX_STRING wrapper, bool aggregate)
+{
+	vector<TC_SHOW_STREAM_NODE> node_list;
+	map<pair<string, string>, TC_SHOW_STATUS_AGG> agg_map;
+	string show_sql = "SHOW GLOBAL STATUS";
+	const char *wrapper_name = NULL_WRAPPER;
+	Item *field;
+	List<Item> field_list;
+	Protocol *protocol = thd->get_protocol();
+	bool ret;
+	DBUG_ENTER("tc_show_global_status");
+
+	if (wrapper.str == NULL)
+		wrapper_name = NULL_WRAPPER;
+	else if (!strcasecmp(wrapper.str, "SPIDER"))
+		wrapper_name = SPIDER_WRAPPER;
+	else if (!strcasecmp(wrapper.str, "REMOTE"))
+		wrapper_name = MYSQL_WRAPPER;
+	else if (!strcasecmp(wrapper.str, "TDBCTL"))
+		wrapper_name = TDBCTL_WRAPPER;
+	else
+	{
+		my_error(ER_TCADMIN_WRONG_WRAPPER_NAME, MYF(0), wrapper.str,
+			"only support SPIDER, REMOTE, TDBCTL");
+		DBUG_RETURN(TRUE);
+	}
+	if (tc_show_stream_nodes(server_name, wrapper_name, node_list))
+		DBUG_RETURN(TRUE);
+
+	if (aggregate)
+	{
+		field_list.push_back(new Item_empty_string("Wrapper", NAME_CHAR_LEN));
+		field_list.push_back(new Item_empty_string("Variable_name", NAME_CHAR_LEN));
+		field_list.push_back(new Item_empty_string("Sum", 32));
+		field_list.push_back(new Item_empty_string("Min", 32));
+		field_list.push_back(new Item_empty_string("Max", 32));
+		field_list.push_back(new Item_empty_string("Avg", 32));
+		field_list.push_back(new Item_int(NAME_STRING("Nodes"),
+			0, MY_INT64_NUM_DECIMAL_DIGITS));
+	}
+	else
+	{
+		field_list.push_back(new Item_empty_string("Server_name", NAME_CHAR_LEN));
+		field_list.push_back(new Item_empty_string("Variable_name", NAME_CHAR_LEN));
+		field_list.push_back(field = new Item_empty_string("Value", 1024));
+		field->maybe_null = 1;
+	}
+	if (thd->send_result_metadata(&field_list,
+		Protocol::SEND_NUM_ROWS | Protocol::SEND_EOF))
+		DBUG_RETURN(TRUE);
+
+	if (!aggregate)
+		ret = tc_show_stream_run(thd, node_list, show_sql, HA_POS_ERROR,
+			[protocol](TC_SHOW_STREAM_NODE &node, TC_SHOW_STREAM_ROW &row) -> bool {
+				protocol->start_row();
+				protocol->store(node.server_name.c_str(), system_charset_info);
+				protocol->store(row.values[0].c_str(), system_charset_info);
+				if (row.is_null[1])
+					protocol->store_null();
+				else
+					protocol->store(row.values[1].c_str(), system_charset_info);
+				return protocol->end_row();
+			});
+	else
+		ret = tc_show_stream_run(thd, node_list, show_sql, HA_POS_ERROR,
+			[&agg_map](TC_SHOW_STREAM_NODE &node, TC_SHOW_STREAM_ROW &row) -> bool {
+				const char *value = row.values[1].c_str();
+				char *end = NULL;
+				double number;
+				ulonglong int_number = 0;
+				if (row.is_null[1] || row.values[1].empty())
+					return FALSE;
+				number = strtod(value, &end);
+				if (*end != '\0')
+					return FALSE; /* not numeric, such as ON/OFF */
+
+				bool is_integer = (value[strspn(value, "0123456789")] == '\0');
+				if (is_integer)
+				{
+					errno = 0;
+					int_number = strtoull(value, NULL, 10);
+					is_integer = (errno == 0);
+				}
+				pair<string, string> key(node.wrapper, row.values[0]);
+				auto it = agg_map.find(key);
+				if (it == agg_map.end())
+				{
+					TC_SHOW_STATUS_AGG agg = { int_number, int_number, int_number,
+						number, number, number, 1, is_integer };
+					agg_map.insert(make_pair(key, agg));
+					return FALSE;
+				}
+				TC_SHOW_STATUS_AGG &agg = it->second;
+				agg.sum += number;
+				agg.min = min(agg.min, number);
+				agg.max = max(agg.max, number);
+				agg.nodes++;
+				agg.is_integer = agg.is_integer && is_integer &&
+					agg.int_sum + int_number >= agg.int_sum;
+				if (agg.is_integer)
+				{
+					agg.int_sum += int_number;
+					agg.int_min = min(agg.int_min, int_number);
+					agg.int_max = max(agg.int_max, int_number);
+				}
+				return FALSE;
+			});
+	if (ret)
+		DBUG_RETURN(TRUE);
+
+	for (auto &it : agg_map)
+	{
+		TC_SHOW_STATUS_AGG &agg = it.second;
+		protocol->start_row();
+		protocol->store(it.first.first.c_str(), system_charset_info);
+		protocol->store(it.first.second.c_str(), system_charset_info);
+		if (agg.is_integer)
+		{
+			protocol->store(tc_show_format_number(agg.int_sum).c_str(),
+				system_charset_info);
+			protocol->store(tc_show_format_number(agg.int_min).c_str(),
+				system_charset_info);
+			protocol->store(tc_show_format_number(agg.int_max).c_str(),
+				system_charset_info);
+			protocol->store(tc_show_format_avg(agg.int_sum, agg.nodes).c_str(),
+				system_charset_info);
+		}
+		else
+		{
+			protocol->store(tc_show_format_number(agg.sum).c_str(),
+				system_charset_info);
+			protocol->store(tc_show_format_number(agg.min).c_str(),
+				system_charset_info);
+			protocol->store(tc_show_format_number(agg.max).c_str(),
+				system_charset_info);
+			protocol->store(tc_show_format_number(agg.sum / agg.nodes).c_str(),
+				system_charset_info);
+		}
+		protocol->store_longlong(agg.nodes, true);
+		if (protocol->end_row())
+			DBUG_RETURN(TRUE);
+	}
+
+	my_eof(thd);
+	DBUG_RETURN(FALSE);
+}
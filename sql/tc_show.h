@@ -7,6 +7,9 @@
 
 #include "my_global.h"
 #include "sql_class.h" 
-void tc_show_processlist(THD *thd, bool verbose, const char *server_name);
+bool tc_show_processlist(THD *thd, bool verbose, const char *server_name,
+  Item *where, Item *limit);
 void tc_show_variables(THD *thd, enum_var_type type, String *wild, const char *server_name);
+bool tc_show_global_status(THD *thd, const char *server_name,
+  LEX_STRING wrapper, bool aggregate);
 #endif
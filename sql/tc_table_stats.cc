@@ -0,0 +1,343 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+#include "tc_table_stats.h"
+#include "sql_base.h"
+#include "sql_lex.h"
+#include "tc_base.h"
+#include "sql_servers.h"
+#include "log.h"
+#include <thread>
+#include <list>
+
+void create_tc_table_stats_thread()
+{
+  std::thread t(tc_thread_create(key_thread_tc_table_stats, tc_table_stats_thread));
+  t.detach();
+}
+
+/*
+  state kept across collect rounds, only used by tc_table_stats_thread
+
+  stats_remote_map: ip#port-->remote, rebuilt when mysql.servers changes
+  stats_purge_servers: rows of servers not in mysql.servers are to be
+    deleted in the next round
+*/
+static map<string, TC_TABLE_STATS_REMOTE> stats_remote_map;
+static ulong stats_server_version = -1;
+static bool stats_inited = FALSE;
+static bool stats_purge_servers = FALSE;
+
+void tc_table_stats_thread()
+{
+  while (1)
+  {
+    if (tc_table_stats && tdbctl_is_primary)
+    {
+      tc_table_stats_collect();
+      for (ulong i = 2; i < tc_table_stats_interval && tc_table_stats; i++)
+        sleep(1);
+    }
+    else
+      tc_table_stats_free();
+    sleep(2);
+  }
+}
+
+/*
+  close connections and clear state of all remotes, all tables are read
+  again in the next round
+*/
+void tc_table_stats_free()
+{
+  for (auto &it : stats_remote_map)
+  {
+    if (it.second.conn)
+      mysql_close(it.second.conn);
+  }
+  stats_remote_map.clear();
+  stats_inited = FALSE;
+}
+
+/* rebuild remotes from mysql.servers if it changes */
+static void tc_table_stats_init()
+{
+  MEM_ROOT mem_root;
+  list<FOREIGN_SERVER*> server_list;
+  size_t prefix_len = strlen(tdbctl_mysql_wrapper_prefix);
+  if (stats_inited && !check_server_version(stats_server_version))
+    return;
+
+  tc_table_stats_free();
+  init_sql_alloc(key_memory_for_tdbctl, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+  MEM_ROOT_GUARD(mem_root);
+  stats_server_version = get_modify_server_version();
+  get_server_by_wrapper(server_list, &mem_root, MYSQL_WRAPPER, FALSE);
+  for (auto &server : server_list)
+  {
+    string ipport = string(server->host) + "#" + to_string(server->port);
+    TC_TABLE_STATS_REMOTE &remote = stats_remote_map[ipport];
+    remote.server_name = server->server_name;
+    remote.ipport = ipport;
+    remote.user = server->username;
+    remote.passwd = server->password;
+    remote.db_suffix = "_" + remote.server_name.substr(prefix_len);
+    remote.conn = NULL;
+    remote.rounds = 0;
+  }
+  stats_inited = TRUE;
+  stats_purge_servers = TRUE;
+}
+
+/*
+  read information_schema.TABLES of one remote, full read every
+  TC_TABLE_STATS_FULL_ROUNDS rounds, otherwise only tables changed
+  since update_time_hwm or with NULL UPDATE_TIME are returned
+*/
+static void tc_table_stats_remote_read(TC_TABLE_STATS_REMOTE *remote)
+{
+  bool full = (remote->rounds % TC_TABLE_STATS_FULL_ROUNDS == 0);
+  set<pair<string, string> > read_set;
+  string sql = "SELECT TABLE_SCHEMA, TABLE_NAME, TABLE_ROWS, DATA_LENGTH,"
+    " INDEX_LENGTH, DATA_FREE, UPDATE_TIME FROM information_schema.TABLES"
+    " WHERE TABLE_TYPE='BASE TABLE' AND RIGHT(TABLE_SCHEMA, " +
+    to_string(remote->db_suffix.length()) + ")=";
+  tc_append_quoted_value(sql, remote->db_suffix.c_str(), remote->db_suffix.length());
+  if (!full && !remote->update_time_hwm.empty())
+  {
+    sql += " AND (UPDATE_TIME IS NULL OR UPDATE_TIME>=";
+    tc_append_quoted_value(sql, remote->update_time_hwm.c_str(),
+      remote->update_time_hwm.length());
+    sql += ")";
+  }
+
+  remote->changed_list.clear();
+  remote->dropped_list.clear();
+  remote->error = "";
+  if (!remote->conn &&
+    !(remote->conn = tc_conn_connect(remote->ipport, remote->user, remote->passwd)))
+  {
+    remote->error = "connect failed";
+    return;
+  }
+
+  MYSQL_RES *res = tc_exec_sql_with_result(remote->conn, sql);
+  MYSQL_RES_GUARD(res);
+  MYSQL_ROW row;
+  if (!res)
+  {
+    remote->error = mysql_error(remote->conn);
+    mysql_close(remote->conn);
+    remote->conn = NULL;
+    return;
+  }
+  while ((row = mysql_fetch_row(res)))
+  {
+    pair<string, string> key(row[0], row[1]);
+    string update_time = row[6] ? row[6] : "";
+    auto its = remote->update_time_map.find(key);
+    read_set.insert(key);
+    /*
+      a table whose UPDATE_TIME is not NULL is returned only when it is
+      changed since update_time_hwm, NULL UPDATE_TIME is returned every
+      round and written only when it is new or was not NULL
+    */
+    if (!full && its != remote->update_time_map.end() &&
+      update_time.empty() && its->second.empty())
+      continue;
+    TC_TABLE_STATS_ROW stats;
+    stats.db_name = key.first;
+    stats.tb_name = key.second;
+    stats.table_rows = row[2] ? strtoull(row[2], NULL, 10) : 0;
+    stats.data_length = row[3] ? strtoull(row[3], NULL, 10) : 0;
+    stats.index_length = row[4] ? strtoull(row[4], NULL, 10) : 0;
+    stats.data_free = row[5] ? strtoull(row[5], NULL, 10) : 0;
+    stats.update_time = update_time;
+    remote->changed_list.push_back(stats);
+  }
+  if (full)
+  {
+    for (auto &it : remote->update_time_map)
+    {
+      if (!read_set.count(it.first))
+        remote->dropped_list.push_back(it.first);
+    }
+  }
+}
+
+/*
+  write changed and dropped tables of one remote to TC_TABLE_STATS_TABLE
+
+  @retval
+    FALSE ok
+    TRUE error, exec_info is set
+*/
+static bool tc_table_stats_write(MYSQL *tdbctl_conn,
+  TC_TABLE_STATS_REMOTE &remote, tc_exec_info *exec_info)
+{
+  size_t suffix_len = remote.db_suffix.length();
+  string server_sql, sql;
+  tc_append_quoted_value(server_sql, remote.server_name.c_str(),
+    remote.server_name.length());
+
+  for (size_t i = 0; i < remote.changed_list.size(); i++)
+  {
+    TC_TABLE_STATS_ROW &stats = remote.changed_list[i];
+    string db_name = stats.db_name.substr(0, stats.db_name.length() - suffix_len);
+    if (sql.empty())
+      sql = "REPLACE INTO " TC_TABLE_STATS_TABLE "(db_name, tb_name, server_name,"
+        " host, table_rows, data_length, index_length, data_free, update_time)"
+        " VALUES";
+    else
+      sql += ",";
+    sql += "(";
+    tc_append_quoted_value(sql, db_name.c_str(), db_name.length());
+    sql += ",";
+    tc_append_quoted_value(sql, stats.tb_name.c_str(), stats.tb_name.length());
+    sql += "," + server_sql + ",";
+    tc_append_quoted_value(sql, remote.ipport.c_str(), remote.ipport.length());
+    sql += "," + to_string(stats.table_rows) + "," + to_string(stats.data_length) +
+      "," + to_string(stats.index_length) + "," + to_string(stats.data_free) + ",";
+    if (stats.update_time.empty())
+      sql += "NULL";
+    else
+      tc_append_quoted_value(sql, stats.update_time.c_str(), stats.update_time.length());
+    sql += ")";
+    if ((i + 1) % TC_TABLE_STATS_BATCH_SIZE == 0 || i + 1 == remote.changed_list.size())
+    {
+      if (tc_exec_sql_without_result(tdbctl_conn, sql, exec_info))
+        return TRUE;
+      sql = "";
+    }
+  }
+
+  for (size_t i = 0; i < remote.dropped_list.size(); i++)
+  {
+    string db_name = remote.dropped_list[i].first;
+    db_name = db_name.substr(0, db_name.length() - suffix_len);
+    if (sql.empty())
+      sql = "DELETE FROM " TC_TABLE_STATS_TABLE " WHERE server_name=" +
+        server_sql + " AND (db_name, tb_name) IN (";
+    else
+      sql += ",";
+    sql += "(";
+    tc_append_quoted_value(sql, db_name.c_str(), db_name.length());
+    sql += ",";
+    tc_append_quoted_value(sql, remote.dropped_list[i].second.c_str(),
+      remote.dropped_list[i].second.length());
+    sql += ")";
+    if ((i + 1) % TC_TABLE_STATS_BATCH_SIZE == 0 || i + 1 == remote.dropped_list.size())
+    {
+      if (tc_exec_sql_without_result(tdbctl_conn, sql + ")", exec_info))
+        return TRUE;
+      sql = "";
+    }
+  }
+  return FALSE;
+}
+
+/* delete rows of servers not in mysql.servers any more */
+static bool tc_table_stats_purge_servers(MYSQL *tdbctl_conn,
+  tc_exec_info *exec_info)
+{
+  string sql = "DELETE FROM " TC_TABLE_STATS_TABLE;
+  string name_list = "";
+  for (auto &it : stats_remote_map)
+  {
+    name_list += name_list.empty() ? "" : ",";
+    tc_append_quoted_value(name_list, it.second.server_name.c_str(),
+      it.second.server_name.length());
+  }
+  if (!name_list.empty())
+    sql += " WHERE server_name NOT IN (" + name_list + ")";
+  return tc_exec_sql_without_result(tdbctl_conn, sql, exec_info);
+}
+
+/*
+  one collect round: read all remotes parallel, then write the changes
+  to primary tdbctl. A remote failed to read or write is read fully in
+  the next round.
+*/
+void tc_table_stats_collect()
+{
+  int ret = 0;
+  MEM_ROOT mem_root;
+  map<string, string> tdbctl_ipport_map;
+  map<string, string> tdbctl_user_map;
+  map<string, string> tdbctl_passwd_map;
+  MYSQL *tdbctl_conn = NULL;
+  list<thread> thread_list;
+  tc_exec_info exec_info;
+
+  tc_table_stats_init();
+  if (stats_remote_map.empty())
+    return;
+
+  for (auto &it : stats_remote_map)
+  {
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_table_stats_remote_read,
+      &it.second));
+    thread_list.push_back(std::move(tmp_t));
+  }
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+
+  init_sql_alloc(key_memory_for_tdbctl, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+  MEM_ROOT_GUARD(mem_root);
+  tdbctl_ipport_map = get_tdbctl_ipport_map(&mem_root, tdbctl_user_map,
+    tdbctl_passwd_map);
+  tdbctl_conn = tc_tdbctl_conn_primary(ret, tdbctl_ipport_map,
+    tdbctl_user_map, tdbctl_passwd_map);
+  MYSQL_GUARD(tdbctl_conn);
+  if (ret || !tdbctl_conn)
+  {
+    sql_print_warning("TDBCTL: failed to connect primary tdbctl for table stats");
+    for (auto &it : stats_remote_map)
+      it.second.rounds = 0;
+    return;
+  }
+
+  if (stats_purge_servers)
+  {
+    if (tc_table_stats_purge_servers(tdbctl_conn, &exec_info))
+      sql_print_warning("TDBCTL: failed to purge %s: %d %s", TC_TABLE_STATS_TABLE,
+        exec_info.err_code, exec_info.err_msg.c_str());
+    else
+      stats_purge_servers = FALSE;
+  }
+
+  for (auto &it : stats_remote_map)
+  {
+    TC_TABLE_STATS_REMOTE &remote = it.second;
+    if (!remote.error.empty())
+    {
+      sql_print_warning("TDBCTL: failed to read table stats of %s(%s): %s",
+        remote.server_name.c_str(), remote.ipport.c_str(), remote.error.c_str());
+      remote.rounds = 0;
+      continue;
+    }
+    if (tc_table_stats_write(tdbctl_conn, remote, &exec_info))
+    {
+      sql_print_warning("TDBCTL: failed to write table stats of %s to %s: %d %s",
+        remote.server_name.c_str(), TC_TABLE_STATS_TABLE, exec_info.err_code,
+        exec_info.err_msg.c_str());
+      remote.rounds = 0;
+      continue;
+    }
+    for (auto &stats : remote.changed_list)
+    {
+      remote.update_time_map[make_pair(stats.db_name, stats.tb_name)] = stats.update_time;
+      if (stats.update_time > remote.update_time_hwm)
+        remote.update_time_hwm = stats.update_time;
+    }
+    for (auto &key : remote.dropped_list)
+      remote.update_time_map.erase(key);
+    remote.changed_list.clear();
+    remote.dropped_list.clear();
+    remote.rounds++;
+  }
+}
@@ -0,0 +1,84 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+#ifndef TC_TABLE_STATS_INCLUDED
+#define TC_TABLE_STATS_INCLUDED
+
+/*
+  Table statistics of the cluster, collected by primary tdbctl every
+  tc_table_stats_interval seconds
+
+  cluster_admin.tc_table_stats: rows, data and index length of every table
+    on every remote shard, db_name is the logical database without the
+    _<n> suffix of the shard
+  cluster_admin.v_tc_table_skew: size of every table summed over shards,
+    skew_ratio is max/avg of shard size
+
+  Remotes are read parallel from information_schema.TABLES. Only tables
+  whose UPDATE_TIME is not older than the last UPDATE_TIME seen on the
+  remote, or is NULL, are returned, and only those changed are written.
+  Every TC_TABLE_STATS_FULL_ROUNDS rounds all tables are read again to
+  refresh TABLE_ROWS estimates and remove dropped tables.
+*/
+
+#include "my_global.h"
+#include "mysql.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+using namespace std;
+
+#define TC_TABLE_STATS_TABLE "cluster_admin.tc_table_stats"
+/* rounds between two full reads of a remote */
+#define TC_TABLE_STATS_FULL_ROUNDS 12
+/* max rows written to TC_TABLE_STATS_TABLE in one statement */
+#define TC_TABLE_STATS_BATCH_SIZE 500
+
+/*
+  statistics of one table on one remote
+  db_name: database on the remote, with the _<n> suffix
+  update_time: "" for NULL
+*/
+typedef struct tc_table_stats_row
+{
+  string db_name;
+  string tb_name;
+  ulonglong table_rows;
+  ulonglong data_length;
+  ulonglong index_length;
+  ulonglong data_free;
+  string update_time;
+} TC_TABLE_STATS_ROW;
+
+/*
+  state of one remote kept across rounds
+  db_suffix: _<n> of databases on the remote SPT<n>
+  update_time_map: (db, tb)-->UPDATE_TIME written, "" for NULL
+  update_time_hwm: max UPDATE_TIME seen, "" before the first full round
+  rounds: rounds since the last full round
+  changed_list/dropped_list/error: result of current round
+*/
+typedef struct tc_table_stats_remote
+{
+  string server_name;
+  string ipport;
+  string user;
+  string passwd;
+  string db_suffix;
+  MYSQL *conn;
+  map<pair<string, string>, string> update_time_map;
+  string update_time_hwm;
+  ulong rounds;
+  vector<TC_TABLE_STATS_ROW> changed_list;
+  vector<pair<string, string> > dropped_list;
+  string error;
+} TC_TABLE_STATS_REMOTE;
+
+void create_tc_table_stats_thread();
+void tc_table_stats_thread();
+void tc_table_stats_collect();
+void tc_table_stats_free();
+
+#endif /* TC_TABLE_STATS_INCLUDED */
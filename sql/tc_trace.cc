@@ -0,0 +1,195 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+#include "tc_trace.h"
+#include "sql_class.h"
+#include "mysqld.h"
+#include <deque>
+
+static std::mutex trace_mtx;
+/* oldest job first */
+static deque<TC_TRACE_JOB_PTR> trace_ring;
+static ulonglong trace_job_id = 0;
+
+/*
+  add a job for the DDL of thd to the ring, the oldest jobs are removed
+  when the ring has more than tc_ddl_trace_jobs jobs
+
+  @retval
+    NULL if tc_ddl_trace_jobs is 0
+*/
+TC_TRACE_JOB_PTR tc_trace_job_begin(THD *thd)
+{
+  TC_TRACE_JOB_PTR job;
+  ulong max_jobs = tc_ddl_trace_jobs;
+  if (max_jobs == 0)
+  {
+    std::lock_guard<std::mutex> lock(trace_mtx);
+    trace_ring.clear();
+    return job;
+  }
+
+  job = std::make_shared<TC_TRACE_JOB>();
+  job->thread_id = thd->thread_id();
+  job->db = thd->db().str ? thd->db().str : "";
+  if (thd->query().str)
+  {
+    /* cut on character boundary, a multi-byte character is not split */
+    const char *query = thd->query().str;
+    size_t length = thd->query().length;
+    job->query.assign(query, min(length, my_charpos(thd->charset(), query,
+      query + length, TC_TRACE_QUERY_LENGTH)));
+  }
+  job->begin = my_micro_time();
+  job->end = 0;
+  job->failed = false;
+
+  std::lock_guard<std::mutex> lock(trace_mtx);
+  job->id = ++trace_job_id;
+  trace_ring.push_back(job);
+  while (trace_ring.size() > max_jobs)
+    trace_ring.pop_front();
+  return job;
+}
+
+void tc_trace_job_end(const TC_TRACE_JOB_PTR &job, bool failed)
+{
+  if (!job)
+    return;
+  std::lock_guard<std::mutex> lock(job->mtx);
+  job->end = my_micro_time();
+  job->failed = failed;
+}
+
+/*
+  begin an event of job, ipport is "" for a phase
+
+  @retval
+    index of the event, passed to tc_trace_event_end
+*/
+size_t tc_trace_event_begin(const TC_TRACE_JOB_PTR &job, const char *phase,
+  const string &ipport)
+{
+  if (!job)
+    return 0;
+  TC_TRACE_EVENT event;
+  event.phase = phase;
+  event.ipport = ipport;
+  event.begin = my_micro_time();
+  event.end = 0;
+  event.err_code = 0;
+  std::lock_guard<std::mutex> lock(job->mtx);
+  job->event_list.push_back(event);
+  return job->event_list.size() - 1;
+}
+
+void tc_trace_event_end(const TC_TRACE_JOB_PTR &job, size_t event,
+  uint err_code, const string &err_msg)
+{
+  if (!job)
+    return;
+  std::lock_guard<std::mutex> lock(job->mtx);
+  TC_TRACE_EVENT &ev = job->event_list[event];
+  ev.end = my_micro_time();
+  ev.err_code = err_code;
+  ev.err_msg = err_msg;
+}
+
+/* jobs of the ring, oldest first */
+list<TC_TRACE_JOB_PTR> tc_trace_jobs()
+{
+  std::lock_guard<std::mutex> lock(trace_mtx);
+  return list<TC_TRACE_JOB_PTR>(trace_ring.begin(), trace_ring.end());
+}
+
+static void tc_trace_append_json_string(string &json, const string &str)
+{
+  json += '"';
+  for (unsigned char c : str)
+  {
+    if (c == '"' || c == '\\')
+    {
+      json += '\\';
+      json += c;
+    }
+    else if (c < 0x20)
+    {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      json += buf;
+    }
+    else
+      json += c;
+  }
+  json += '"';
+}
+
+/*
+  job in Chrome trace event format, caller holds job->mtx
+
+  pid is the job id, tid 0 is the phases, nodes get tid 1, 2 ... in order
+  of server name, so tracks are in the same order for every run. ts/dur
+  are microseconds since the begin of the job, events still running end
+  at now and have "running" in args.
+*/
+string tc_trace_chrome_json(TC_TRACE_JOB *job,
+  const map<string, string> &server_name_map, ulonglong now)
+{
+  map<string, string> node_map;  /* server name-->ipport */
+  map<string, uint> tid_map;     /* ipport-->tid */
+  string json = "{\"traceEvents\":[";
+  string pid = to_string(job->id);
+
+  for (auto &event : job->event_list)
+  {
+    if (event.ipport.empty())
+      continue;
+    map<string, string>::const_iterator its = server_name_map.find(event.ipport);
+    node_map[its == server_name_map.end() ? event.ipport : its->second] =
+      event.ipport;
+  }
+
+  json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pid +
+    ",\"args\":{\"name\":";
+  tc_trace_append_json_string(json, "job " + pid + ": " + job->query);
+  json += "}},{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid +
+    ",\"tid\":0,\"args\":{\"name\":\"phases\"}}";
+  for (auto &node : node_map)
+  {
+    uint tid = (uint)tid_map.size() + 1;
+    tid_map[node.second] = tid;
+    json += ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid +
+      ",\"tid\":" + to_string(tid) + ",\"args\":{\"name\":";
+    tc_trace_append_json_string(json, node.first + " " + node.second);
+    json += "}},{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":" +
+      pid + ",\"tid\":" + to_string(tid) + ",\"args\":{\"sort_index\":" +
+      to_string(tid) + "}}";
+  }
+
+  for (auto &event : job->event_list)
+  {
+    ulonglong end = event.end ? event.end : now;
+    ulonglong ts = event.begin > job->begin ? event.begin - job->begin : 0;
+    ulonglong dur = end > event.begin ? end - event.begin : 0;
+    uint tid = event.ipport.empty() ? 0 : tid_map[event.ipport];
+    json += ",{\"name\":\"" + event.phase + "\",\"cat\":\"ddl\",\"ph\":\"X\""
+      ",\"pid\":" + pid + ",\"tid\":" + to_string(tid) +
+      ",\"ts\":" + to_string(ts) + ",\"dur\":" + to_string(dur) +
+      ",\"args\":{";
+    if (!event.end)
+      json += "\"running\":true";
+    else
+    {
+      json += "\"err_code\":" + to_string(event.err_code);
+      if (event.err_code)
+      {
+        json += ",\"err_msg\":";
+        tc_trace_append_json_string(json, event.err_msg);
+      }
+    }
+    json += "}}";
+  }
+  json += "],\"displayTimeUnit\":\"ms\"}";
+  return json;
+}
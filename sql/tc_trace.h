@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2020 THL A29 Limited, a Tencent company.  All rights reserved.
+*/
+
+#ifndef TC_TRACE_INCLUDED
+#define TC_TRACE_INCLUDED
+
+/*
+  timeline of cluster DDL executed by tc_ddl_run
+
+  every DDL is a job, the spider and remote phases and the query on every
+  node are events of the job with begin/end time and error. Jobs are kept
+  in a ring of the last tc_ddl_trace_jobs jobs, a running job is in the
+  ring too, so a slow DDL can be looked at before it ends.
+
+  INFORMATION_SCHEMA.TC_DDL_TRACE shows a row for every job of the ring,
+  TRACE is the job in Chrome trace event format: one track for the phases
+  and one for every node, time is relative to the begin of the job so that
+  runs of the same DDL can be compared. Save it with
+    SELECT TRACE FROM information_schema.TC_DDL_TRACE WHERE JOB_ID = n
+    INTO DUMPFILE 'file.json'
+  and open it in chrome://tracing or Perfetto.
+*/
+
+#include "my_global.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+using namespace std;
+
+/* max characters of the query kept in a job, as the QUERY column */
+#define TC_TRACE_QUERY_LENGTH 1024
+
+class THD;
+
+/*
+  ipport: "" for a phase
+  begin/end: my_micro_time(), end is 0 while running
+*/
+typedef struct tc_trace_event
+{
+  string phase;
+  string ipport;
+  ulonglong begin;
+  ulonglong end;
+  uint err_code;
+  string err_msg;
+} TC_TRACE_EVENT;
+
+/* end is 0 while running, failed is set when the job ends */
+typedef struct tc_trace_job
+{
+  ulonglong id;
+  ulonglong thread_id;
+  string db;
+  string query;
+  ulonglong begin;
+  ulonglong end;
+  bool failed;
+  vector<TC_TRACE_EVENT> event_list;
+  std::mutex mtx;
+} TC_TRACE_JOB;
+
+typedef shared_ptr<TC_TRACE_JOB> TC_TRACE_JOB_PTR;
+
+TC_TRACE_JOB_PTR tc_trace_job_begin(THD *thd);
+void tc_trace_job_end(const TC_TRACE_JOB_PTR &job, bool failed);
+size_t tc_trace_event_begin(const TC_TRACE_JOB_PTR &job, const char *phase,
+  const string &ipport);
+void tc_trace_event_end(const TC_TRACE_JOB_PTR &job, size_t event,
+  uint err_code, const string &err_msg);
+list<TC_TRACE_JOB_PTR> tc_trace_jobs();
+string tc_trace_chrome_json(TC_TRACE_JOB *job,
+  const map<string, string> &server_name_map, ulonglong now);
+
+#endif /* TC_TRACE_INCLUDED */
@@ -7,19 +7,48 @@
 #include "sql_lex.h"
 #include "tc_base.h"
 #include "log.h"
+#include "errmsg.h"
 #include <thread>
 #include <string>
 #include <list>
+#include <vector>
 #include <mutex>
 
 void create_tc_xa_repair_thread()
 {
-  std::thread t(tc_xa_repair_thread);
+  std::thread t(tc_thread_create(key_thread_tc_xa_repair, tc_xa_repair_thread));
   t.detach();
 }
 
+/*
+  state kept across repair rounds, only used by tc_xa_repair_thread
+
+  xa_remote_*: connections to remotes, re-init when mysql.servers changes
+    or some connection failed in last round
+  xa_decided_map: xid already decided, TRUE for commit, FALSE for rollback,
+    an xid is removed when it is not prepared on any remote
+  xa_last_purge_time: when mysql.xa_commit_log was purged last
+  xa_indexed_set: remotes which have an index on commit_time
+*/
+static map<string, MYSQL*> xa_remote_conn_map;
+static map<string, string> xa_remote_user_map;
+static map<string, string> xa_remote_passwd_map;
+static map<string, string> xa_remote_ipport_map;
+static ulong xa_server_version = -1;
+static bool xa_conn_inited = FALSE;
+static map<string, bool> xa_decided_map;
+static time_t xa_last_purge_time = 0;
+static set<string> xa_indexed_set;
+/*
+  key is server name#version of a remote, value is whether the remote
+  supports "xa recover with time older than", kept until tdbctl restarts
+*/
+static map<string, bool> xa_older_than_map;
+static std::mutex xa_older_than_mtx;
+
 void tc_xa_repair_thread()
 {
+  tc_latency_cur_op = TC_LATENCY_OP_XA;
   while (1)
   {
 		if (tc_check_repair_trans && tdbctl_is_primary)
@@ -30,84 +59,333 @@ void tc_xa_repair_thread()
       for (ulong i = 0; i < tc_max_prepared_time - 2 - 2; i++)
         sleep(1);
     }
+    else
+      tc_xa_repair_free();
     sleep(2);
   }
 }
 
-void tc_check_and_repair_trans()
+/*
+  free connections to remotes, decided xids are kept
+*/
+void tc_xa_repair_conn_free()
+{
+  tc_conn_free(xa_remote_conn_map);
+  xa_remote_conn_map.clear();
+  xa_remote_user_map.clear();
+  xa_remote_passwd_map.clear();
+  xa_remote_ipport_map.clear();
+  xa_indexed_set.clear();
+  xa_conn_inited = FALSE;
+}
+
+/*
+  free connections and state of xa repair
+*/
+void tc_xa_repair_free()
+{
+  tc_xa_repair_conn_free();
+  xa_decided_map.clear();
+}
+
+/*
+  connect to all remotes if not connected or mysql.servers changed
+
+  @retval
+    0 ok, 1 error
+*/
+int tc_xa_repair_conn_init()
 {
-  std::map<std::string, MYSQL*> remote_conn_map;
-  std::map<std::string, std::string> remote_user_map;
-  std::map<std::string, std::string> remote_passwd_map;
-  std::map<std::string, std::string> remote_ipport_map;
-  MEM_ROOT mem_root;
   int ret = 0;
+  MEM_ROOT mem_root;
+  if (xa_conn_inited && !check_server_version(xa_server_version))
+    return ret;
+
+  tc_xa_repair_conn_free();
   init_sql_alloc(key_memory_for_tdbctl, &mem_root, ACL_ALLOC_BLOCK_SIZE, 0);
+  MEM_ROOT_GUARD(mem_root);
+  xa_server_version = get_modify_server_version();
+  xa_remote_ipport_map = get_remote_ipport_map(&mem_root,
+    xa_remote_user_map, xa_remote_passwd_map);
 
-  remote_ipport_map = get_remote_ipport_map(&mem_root,
-    remote_user_map, remote_passwd_map);
+  xa_remote_conn_map = tc_remote_conn_connect(ret, xa_remote_ipport_map,
+    xa_remote_user_map, xa_remote_passwd_map);
+  if (ret)
+  {/* the xid may be committed on a remote not connected, retry next round */
+    sql_print_warning("TDBCTL: failed to connect remotes for repairing "
+      "prepared transaction");
+    tc_xa_repair_conn_free();
+    return ret;
+  }
+  xa_conn_inited = TRUE;
+  return ret;
+}
 
-  remote_conn_map = tc_remote_conn_connect(ret, remote_ipport_map,
-    remote_user_map, remote_passwd_map);
+/*
+  format my_time_t as "YYYY-MM-DD HH:MM:SS" in local time
+*/
+static string tc_xa_time_string(my_time_t time_s)
+{
+  time_t t = (time_t)time_s;
+  struct tm lt;
+  char time_string[30] = { 0 };
+  localtime_r(&t, &lt);
+  strftime(time_string, sizeof(time_string), "%Y-%m-%d %H:%M:%S", &lt);
+  return time_string;
+}
 
+void tc_check_and_repair_trans()
+{
+  if (tc_xa_repair_conn_init())
+    return;
 
   int max_time = tc_max_prepared_time;
-  set<string> xid_set;
+  map<string, my_time_t> xid_map;
+  map<string, set<string> > node_xid_map;
+  map<string, my_time_t> undecided_map;
   set<string> commit_set;
   set<string> rollback_set;
-  /* get remote prepared transaction from xa recover with time */
-  /* TODO. push exceed time to data node */
-  tc_get_remote_prepared_trans(remote_conn_map, remote_user_map,
-    remote_passwd_map, max_time, xid_set );
+  set<string> prepared_set;
+  map<string, bool>::iterator its;
+  bool prepared_error;
+  time_t now = time(NULL);
+  /* purge needs all prepared xids, not only those older than max_time */
+  bool purge = tc_xa_commit_log_retention &&
+    now - xa_last_purge_time >= TC_XA_PURGE_INTERVAL;
+
+  /* add index on commit_time of mysql.xa_commit_log if purge needs it */
+  if (purge)
+    tc_ensure_commit_log_index(xa_remote_conn_map);
+
+  /* get remote prepared transaction from xa recover with time older than */
+  prepared_error = tc_get_remote_prepared_trans(xa_remote_conn_map,
+    xa_remote_user_map, xa_remote_passwd_map, max_time, purge, xid_map,
+    node_xid_map, prepared_set);
+
+  /* xid decided in previous rounds need not to check again */
+  for (auto &xid : xid_map)
+  {
+    if ((its = xa_decided_map.find(xid.first)) == xa_decided_map.end())
+      undecided_map.insert(xid);
+    else if (its->second)
+      commit_set.insert(xid.first);
+    else
+      rollback_set.insert(xid.first);
+  }
+  if (!prepared_error)
+  {/* xid not prepared on any remote had been repaired */
+    for (its = xa_decided_map.begin(); its != xa_decided_map.end();)
+    {
+      if (xid_map.find(its->first) == xid_map.end())
+        xa_decided_map.erase(its++);
+      else
+        ++its;
+    }
+  }
 
   /* check  if prepared transactions has been recorded in mysql.xa_commit_log */
-  tc_check_status_from_commit_logs( remote_conn_map, remote_user_map,
-    remote_passwd_map, xid_set, commit_set, rollback_set );
-
-  /* xa commit prepared transactions */
-  tc_process_prepared_trans( remote_conn_map, remote_user_map,
-    remote_passwd_map, "xa commit ", commit_set);
-
-  /* xa rollback prepared transactions */
-  tc_process_prepared_trans(remote_conn_map, remote_user_map,
-    remote_passwd_map, "xa rollback ", rollback_set);
-
-  free_root(&mem_root, MYF(0));
-  tc_conn_free(remote_conn_map);
-  remote_conn_map.clear();
-  remote_user_map.clear();
-  remote_passwd_map.clear();
-  remote_ipport_map.clear();
+  set<string> new_commit_set;
+  set<string> new_rollback_set;
+  tc_check_status_from_commit_logs(xa_remote_conn_map, xa_remote_user_map,
+    xa_remote_passwd_map, undecided_map, new_commit_set, new_rollback_set);
+  for (auto &xid : new_commit_set)
+  {
+    xa_decided_map[xid] = TRUE;
+    commit_set.insert(xid);
+  }
+  for (auto &xid : new_rollback_set)
+  {
+    xa_decided_map[xid] = FALSE;
+    rollback_set.insert(xid);
+  }
+
+  /* xa commit/rollback prepared transactions on each remote */
+  tc_process_prepared_trans(xa_remote_conn_map, node_xid_map,
+    commit_set, rollback_set);
+
+  /* purge old records in mysql.xa_commit_log */
+  if (purge && !prepared_error)
+  {
+    xa_last_purge_time = now;
+    tc_purge_commit_logs(xa_remote_conn_map, xa_remote_user_map,
+      xa_remote_passwd_map, prepared_set);
+  }
+
+  /* some remote may be lost, reconnect next round */
+  for (auto &conn : xa_remote_conn_map)
+  {
+    if (conn.second == NULL || mysql_errno(conn.second) == CR_SERVER_GONE_ERROR ||
+      mysql_errno(conn.second) == CR_SERVER_LOST)
+    {
+      xa_conn_inited = FALSE;
+      break;
+    }
+  }
 }
 
-void tc_get_remote_prepared_trans(
+/*
+  add index on commit_time of mysql.xa_commit_log for each remote once,
+  which used by purge
+*/
+void tc_ensure_commit_log_index(map<string, MYSQL*> &conn_map)
+{
+  string check_sql = "select count(*) from information_schema.STATISTICS "
+    "where TABLE_SCHEMA='mysql' and TABLE_NAME='xa_commit_log' "
+    "and COLUMN_NAME='commit_time' and SEQ_IN_INDEX=1";
+  string alter_sql = "alter table mysql.xa_commit_log "
+    "add index idx_commit_time(commit_time), algorithm=inplace, lock=none";
+  for (auto &conn : conn_map)
+  {
+    string ipport = conn.first;
+    MYSQL *mysql = conn.second;
+    MYSQL_ROW row = NULL;
+    tc_exec_info exec_info;
+    if (!mysql || xa_indexed_set.count(ipport))
+      continue;
+    MYSQL_RES *res = tc_exec_sql_with_result(mysql, check_sql);
+    //use to free result.
+    MYSQL_RES_GUARD(res);
+    if (!res || !(row = mysql_fetch_row(res)))
+      continue;
+    if (row[0] && atoi(row[0]) == 0 &&
+      tc_exec_sql_without_result(mysql, alter_sql, &exec_info))
+    {
+      sql_print_warning("TDBCTL: ipport is %s, failed to add index on "
+        "mysql.xa_commit_log: %d %s", ipport.c_str(), exec_info.err_code,
+        exec_info.err_msg.c_str());
+    }
+    /* do not retry until reconnect, whether succeed or not */
+    xa_indexed_set.insert(ipport);
+  }
+}
+
+/*
+  xa recover on one remote
+
+  @NOTE:
+    old remotes do not support "xa recover with time older than" and
+    return ER_PARSE_ERROR, they are asked by "xa recover with time" and
+    filtered by the caller. Whether a remote supports it is kept in
+    xa_older_than_map by server name and version, so the failed statement
+    is not sent again every round.
+
+  @param
+    all_prepared: get all prepared transactions, without OLDER THAN
+  @param (out)
+    res: result of xa recover, NULL if failed
+*/
+static void tc_xa_recover_on_node(
+  MYSQL *mysql,
+  string server_name,
+  int max_time,
+  bool all_prepared,
+  MYSQL_RES **res
+)
+{
+  string old_exec_sql = "xa recover with time";
+  string exec_sql = old_exec_sql + " older than " + to_string(max_time);
+  bool older_than = !all_prepared;
+  string key;
+
+  *res = NULL;
+  if (!mysql)
+    return;
+  key = server_name + "#" + mysql_get_server_info(mysql);
+  if (older_than)
+  {
+    std::lock_guard<std::mutex> lock(xa_older_than_mtx);
+    map<string, bool>::iterator its = xa_older_than_map.find(key);
+    if (its != xa_older_than_map.end())
+      older_than = its->second;
+  }
+
+  if (older_than)
+  {
+    /*
+      for "xa recover with time older than", data node only return the xid
+      prepared time exceed max_time, but not all prepared transaction
+    */
+    if ((*res = tc_exec_sql_with_result(mysql, exec_sql)) ||
+      mysql_errno(mysql) != ER_PARSE_ERROR)
+    {
+      if (*res)
+      {
+        std::lock_guard<std::mutex> lock(xa_older_than_mtx);
+        xa_older_than_map[key] = TRUE;
+      }
+      return;
+    }
+    std::lock_guard<std::mutex> lock(xa_older_than_mtx);
+    xa_older_than_map[key] = FALSE;
+  }
+  *res = tc_exec_sql_with_result(mysql, old_exec_sql);
+}
+
+/*
+  get prepared transactions which prepared time exceed max_time
+
+  @NOTE:
+    remote not replied within global tc_fanout_read_timeout is skipped as
+    straggler, its connection is lost and reconnected in next round.
+
+  @param
+    all_prepared: also get transactions prepared within max_time
+  @param (out)
+    xid_map: key is xid, value is the earliest prepare time on remotes
+    node_xid_map: key is ip#port, value is xids prepared on the remote
+    prepared_set: all xids got from remotes, prepared time exceed
+      max_time or not
+
+  @retval
+    FALSE ok, TRUE failed to get prepared transactions from some remote
+*/
+bool tc_get_remote_prepared_trans(
   map<string, MYSQL*> &conn_map,
   map<string, string> &user_map,
   map<string, string> &passwd_map,
   int max_time, 
-  set<string> &xid_set
+  bool all_prepared,
+  map<string, my_time_t> &xid_map,
+  map<string, set<string> > &node_xid_map,
+  set<string> &prepared_set
 )
 {
-  string exec_sql = "xa recover with time";
-  bool error_retry = FALSE;
+  bool result = FALSE;
   map<string, MYSQL_RES*> result_map;
+  map<string, string> name_map;
   map<string, MYSQL*>::iterator its;
   map<string, MYSQL_RES*>::iterator its_res;
+  list<thread> thread_list;
   time_t to_tm_time = (time_t)time((time_t*)0);
+  ulong timeout = global_system_variables.tc_fanout_read_timeout;
+  ulonglong deadline = tc_fanout_deadline(timeout);
 
+  for (auto &remote : xa_remote_ipport_map)
+    name_map[remote.second] = remote.first;
   for (its = conn_map.begin(); its != conn_map.end(); its++)
   {/* init for  result_map */
     string ipport = its->first;
     MYSQL_RES* res = NULL;
     result_map.insert(pair<string, MYSQL_RES*>(ipport, res));
+    if (its->second)
+      tc_conn_set_deadline(its->second, deadline);
   }
 
-  /* 
-  TODO. for "xa recover with time",  TenDB can return the xid prepared time exceed max_time, 
-  but not all prepared transaction 
-  */
-  tc_exec_sql_paral_with_result( exec_sql, conn_map,
-    result_map, user_map, passwd_map, error_retry);
+  for (its = conn_map.begin(); its != conn_map.end(); its++)
+  {
+    string ipport = its->first;
+    string server_name = name_map.count(ipport) ? name_map[ipport] : ipport;
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_xa_recover_on_node,
+      its->second, server_name, max_time, all_prepared, &result_map[ipport]));
+    thread_list.push_back(std::move(tmp_t));
+  }
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+  for (its = conn_map.begin(); its != conn_map.end(); its++)
+    tc_conn_reset_deadline(its->second);
 
   for (its_res = result_map.begin(); its_res != result_map.end(); its_res++)
   {
@@ -122,48 +400,83 @@ void tc_get_remote_prepared_trans(
         string xid = row[3]; // row->data
         string prepare_time = row[4]; // row->prepare_time
         my_time_t time_s = string_to_timestamp(prepare_time);
+        prepared_set.insert(xid);
         if (to_tm_time - time_s > max_time)
         {/* xa transaction prepared time exceed more than max_time */
-          xid_set.insert(xid);
+          map<string, my_time_t>::iterator its_xid = xid_map.find(xid);
+          node_xid_map[ipport].insert(xid);
+          if (its_xid == xid_map.end())
+            xid_map.insert(pair<string, my_time_t>(xid, time_s));
+          else if (its_xid->second > time_s)
+            its_xid->second = time_s;
         }
       }
       mysql_free_result(res);
     }
+    else if (conn_map[ipport] && mysql_errno(conn_map[ipport]) == CR_SERVER_LOST &&
+      tc_fanout_deadline_passed(deadline))
+    {
+      sql_print_warning("TDBCTL: ipport is %s, straggler, xa recover not "
+        "replied within tc_fanout_read_timeout(%lu) seconds, skipped",
+        ipport.c_str(), timeout);
+      result = TRUE;
+    }
     else
     {
 			sql_print_warning("TDBCTL: ipport is %s," 
 				"check prepared transaction mismatch",
 				ipport.c_str());
+      result = TRUE;
     }
   }
+  return result;
 }
 
+/*
+  check status of prepared transactions from mysql.xa_commit_log of all nodes
+
+  @NOTE:
+    xids are resolved in batches of TC_XA_REPAIR_BATCH_SIZE with an IN-list,
+    each batch is one parallel query on all nodes, and the results of all
+    nodes are merged in one pass.
+    the lookup is not limited by the prepare time, a remote restarted
+    reports the time of recovery as prepare time of its prepared
+    transactions, which may be later than their commit logs.
+*/
 void tc_check_status_from_commit_logs(
   map<string, MYSQL*> &conn_map,
   map<string, string> &user_map,
   map<string, string> &passwd_map,
-  set<string> &xid_set,
+  map<string, my_time_t> &xid_map,
   set<string> &commit_set,
   set<string> &rollback_set
 )
 {
-  set<string>::iterator its;
-  map<string, MYSQL*>::iterator its2;
+  map<string, my_time_t>::iterator its;
   map<string, MYSQL_RES*>::iterator its_res;
-  map<string, MYSQL_RES*> result_map;
-  /* TODO pre_sql also need to limit the xid commit time in mysql.xa_commit_log */
-  string pre_sql = "select * from mysql.xa_commit_log where xid=";
-  for (its2 = conn_map.begin(); its2 != conn_map.end(); its2++)
-  {/* init for  result_map */
-    string ipport = its2->first;
-    MYSQL_RES* res = NULL;
-    result_map.insert(pair<string, MYSQL_RES*>(ipport, res));
-  }
+  string pre_sql = "select xid from mysql.xa_commit_log where xid in (";
+
+  if (xid_map.empty())
+    return;
 
-  for (its = xid_set.begin(); its != xid_set.end(); its++)
+  its = xid_map.begin();
+  while (its != xid_map.end())
   {
-    string xid = *its;
-    string exec_sql = pre_sql + "\"" + xid + "\"";
+    set<string> batch_set;
+    string in_list = "";
+    for (; its != xid_map.end() && batch_set.size() < TC_XA_REPAIR_BATCH_SIZE; its++)
+    {
+      string xid = its->first;
+      if (batch_set.size())
+        in_list += ",";
+      in_list += "\"" + xid + "\"";
+      batch_set.insert(xid);
+    }
+    string exec_sql = pre_sql + in_list + ")";
+
+    map<string, MYSQL_RES*> result_map;
+    for (auto &conn : conn_map)
+      result_map.insert(pair<string, MYSQL_RES*>(conn.first, NULL));
     tc_exec_sql_paral_with_result(exec_sql,
       conn_map, result_map, user_map, passwd_map, FALSE);
 
@@ -173,7 +486,7 @@ void tc_check_status_from_commit_logs(
     if the xid don't exist in xa_commit_log does not exist for all nodes, 
     we roll back the transaction
     */
-    bool exist_xid = FALSE;
+    set<string> exist_set;
     bool need_retry = FALSE;
     for (its_res = result_map.begin(); its_res != result_map.end(); its_res++)
     {
@@ -181,84 +494,251 @@ void tc_check_status_from_commit_logs(
       MYSQL_RES* res = its_res->second;
       if (res)
       {
-        // TODO, may be we need to compare the commit_time and the prepared time
-        if (mysql_num_rows(res) > 0)
+        MYSQL_ROW row = NULL;
+        while ((row = mysql_fetch_row(res)))
         {/* xid exist in xa_commit_log */
-          exist_xid = TRUE;
+          if (row[0])
+            exist_set.insert(row[0]);
         }
         mysql_free_result(res);
       }
       else
       {
-				sql_print_warning("TDBCTL: ipport is %s, "
-					" failed to get xid info from mysql.xa_commit_log",
-					ipport.c_str());
+        sql_print_warning("TDBCTL: ipport is %s, "
+          " failed to get xid info from mysql.xa_commit_log",
+          ipport.c_str());
         need_retry = TRUE;
       }
     }
-    if(exist_xid)
-      commit_set.insert(xid);
-    else
+    for (auto &xid : batch_set)
     {
-      /* if some error happend when reading xid info from mysql.xa_commit_log, 
-      we do nothing and retry next time */
-      if(!need_retry) 
-        rollback_set.insert(xid);
+      if (exist_set.count(xid))
+        commit_set.insert(xid);
+      else
+      {
+        /* if some error happend when reading xid info from mysql.xa_commit_log, 
+        we do nothing and retry next time */
+        if (!need_retry)
+          rollback_set.insert(xid);
+      }
     }
   }
 }
 
+/*
+  purge records in mysql.xa_commit_log older than tc_xa_commit_log_retention
 
-/* xa commit/rollback prepared transactions */
-void tc_process_prepared_trans(
-  map<string, MYSQL*>& conn_map,
-  map<string, string>& user_map,
-  map<string, string>& passwd_map,
-  string pre_sql,
-  set<string>& commit_set
+  @NOTE:
+    records of xids still prepared on some remote are kept whatever their
+    commit_time, the prepare time can not bound them as a remote restarted
+    reports the time of recovery. purge is skipped if there are too many
+    prepared xids. at most TC_XA_PURGE_BATCH_SIZE records are deleted on
+    each remote every TC_XA_PURGE_INTERVAL seconds.
+
+  @param
+    prepared_set: all xids prepared on remotes
+*/
+void tc_purge_commit_logs(
+  map<string, MYSQL*> &conn_map,
+  map<string, string> &user_map,
+  map<string, string> &passwd_map,
+  set<string> &prepared_set
 )
 {
-  set<string>::iterator its;
+  my_time_t now = (my_time_t)time((time_t*)0);
+  my_time_t purge_time = now - tc_xa_commit_log_retention;
   map<string, tc_exec_info> result_map;
-  map<string, MYSQL*>::iterator its_tmp;
+  string in_list = "";
+
+  if (prepared_set.size() > TC_XA_REPAIR_BATCH_SIZE)
+  {
+    sql_print_warning("TDBCTL: %lu prepared transactions on remotes, skip "
+      "purging mysql.xa_commit_log", (ulong)prepared_set.size());
+    return;
+  }
+  if ((my_time_t)(now - tc_max_prepared_time) < purge_time)
+    purge_time = now - tc_max_prepared_time;
+  if (purge_time <= TC_XA_COMMIT_TIME_SLACK)
+    return;
+  purge_time -= TC_XA_COMMIT_TIME_SLACK;
 
-  for (its_tmp = conn_map.begin(); its_tmp != conn_map.end(); its_tmp++)
-  {/* init for exec result: result_map */
-    string ipport = its_tmp->first;
+  string exec_sql = "delete from mysql.xa_commit_log where commit_time<\"" +
+    tc_xa_time_string(purge_time) + "\"";
+  for (auto &xid : prepared_set)
+  {
+    if (in_list.size())
+      in_list += ",";
+    in_list += "\"" + xid + "\"";
+  }
+  if (in_list.size())
+    exec_sql += " and xid not in (" + in_list + ")";
+  exec_sql += " limit " + to_string(TC_XA_PURGE_BATCH_SIZE);
+  for (auto &conn : conn_map)
+  {
     tc_exec_info exec_info;
     exec_info.err_code = 0;
     exec_info.row_affect = 0;
     exec_info.err_msg = "";
-    result_map.insert(pair<string, tc_exec_info>(ipport, exec_info));
+    result_map.insert(pair<string, tc_exec_info>(conn.first, exec_info));
   }
+  if (tc_exec_sql_paral(exec_sql, conn_map, result_map, user_map, passwd_map, FALSE))
+  {
+    sql_print_warning("TDBCTL: failed to purge mysql.xa_commit_log: %s",
+      concat_result_map(result_map).c_str());
+  }
+}
 
-  for (its = commit_set.begin(); its != commit_set.end(); its++)
+
+/*
+  xa commit/rollback prepared transactions on one remote
+
+  @NOTE:
+    statements are sent as multi-statement batches of TC_XA_REPAIR_BATCH_SIZE,
+    the remote stops executing a batch at the first error, so the batch
+    is resent from the statement after the failed one.
+
+  @param
+    stmt_list: pair of xid and "xa commit "/"xa rollback "
+  @param (out)
+    result_map: key is xid, value is the execute result of the xid
+*/
+static void tc_process_prepared_trans_on_node(
+  MYSQL *mysql,
+  vector<pair<string, string> > stmt_list,
+  map<string, tc_exec_info> *result_map
+)
+{
+  size_t begin = 0;
+  while (begin < stmt_list.size())
   {
-    string xid = *its;
-    string exec_sql = pre_sql + "\"" + xid + "\"";
-    map<string, tc_exec_info>::iterator its_res;
-    tc_exec_sql_paral(exec_sql, conn_map,
-      result_map, user_map, passwd_map, FALSE);
+    size_t end = begin + TC_XA_REPAIR_BATCH_SIZE;
+    size_t done = 0;
+    string exec_sql = "";
+    int ret;
+    TC_PSI_STATEMENT stmt;
+    if (end > stmt_list.size())
+      end = stmt_list.size();
+    for (size_t i = begin; i < end; i++)
+      exec_sql += stmt_list[i].second + "\"" + stmt_list[i].first + "\";";
 
-    for (its_res = result_map.begin(); its_res != result_map.end(); its_res++)
+    tc_psi_statement_start(&stmt, TC_PSI_STATEMENT_EXECUTE, tc_mysql_ipport(mysql),
+      exec_sql.c_str(), exec_sql.length());
+    ret = mysql_real_query(mysql, exec_sql.c_str(), exec_sql.length());
+    while (!ret)
     {
-        string ipport = its_res->first;
-        tc_exec_info exec_info = its_res->second;
-        if (exec_info.err_code > 0)
-        {// some reason
-          // 1. don't exist, 1397
-          // 2. connection also hold the xid, 1397
-          // 3.failed, must be warning
-          if (exec_info.err_code == 1397)
-          {// ignore 1397 // ERROR 1397 (XAE04): XAER_NOTA: Unknown XID
-          }
-        }
-        else
-        {// succeed to repair unexpected prepared transaction
-					sql_print_warning("TDBCTL: ipport is %s, "
-						" succeed to repair unexpected prepared transaction", 
-						ipport.c_str());
+      (*result_map)[stmt_list[begin + done].first].err_code = 0;
+      done++;
+      ret = tc_mysql_next_result(mysql);
+    }
+    tc_psi_statement_end(&stmt, mysql, ret != -1, 0);
+    if (ret == -1)
+    {
+      begin = end;
+      continue;
+    }
+    /* error happened, statements after the failed one are not executed */
+    tc_exec_info &exec_info = (*result_map)[stmt_list[begin + done].first];
+    exec_info.err_code = mysql_errno(mysql);
+    exec_info.err_msg = mysql_error(mysql);
+    if (exec_info.err_code == CR_SERVER_GONE_ERROR ||
+      exec_info.err_code == CR_SERVER_LOST || exec_info.err_code == 0)
+    {
+      for (size_t i = begin + done + 1; i < stmt_list.size(); i++)
+      {
+        (*result_map)[stmt_list[i].first].err_code = exec_info.err_code;
+        (*result_map)[stmt_list[i].first].err_msg = exec_info.err_msg;
+      }
+      break;
+    }
+    begin = begin + done + 1;
+  }
+}
+
+/*
+  xa commit/rollback prepared transactions
+
+  @NOTE:
+    decisions are grouped by the remote where the xid is prepared,
+    each remote executes its own list independently in parallel.
+
+  @param
+    node_xid_map: key is ip#port, value is xids prepared on the remote
+*/
+void tc_process_prepared_trans(
+  map<string, MYSQL*>& conn_map,
+  map<string, set<string> >& node_xid_map,
+  set<string>& commit_set,
+  set<string>& rollback_set
+)
+{
+  map<string, map<string, tc_exec_info> > node_result_map;
+  list<thread> thread_list;
+
+  for (auto &node : node_xid_map)
+  {
+    string ipport = node.first;
+    MYSQL *mysql = conn_map[ipport];
+    vector<pair<string, string> > stmt_list;
+    if (!mysql)
+      continue;
+    for (auto &xid : node.second)
+    {
+      if (commit_set.count(xid))
+        stmt_list.push_back(pair<string, string>(xid, "xa commit "));
+      else if (rollback_set.count(xid))
+        stmt_list.push_back(pair<string, string>(xid, "xa rollback "));
+    }
+    if (stmt_list.empty())
+      continue;
+
+    map<string, tc_exec_info> &result_map = node_result_map[ipport];
+    for (auto &stmt : stmt_list)
+    {/* init for exec result: result_map */
+      tc_exec_info exec_info;
+      exec_info.err_code = 0;
+      exec_info.row_affect = 0;
+      exec_info.err_msg = "";
+      result_map.insert(pair<string, tc_exec_info>(stmt.first, exec_info));
+    }
+    thread tmp_t(tc_thread_create(key_thread_tc_worker, tc_process_prepared_trans_on_node,
+      mysql, stmt_list, &result_map));
+    thread_list.push_back(std::move(tmp_t));
+  }
+
+  for (auto &td : thread_list)
+  {
+    if (td.joinable())
+      td.join();
+  }
+
+  for (auto &node : node_result_map)
+  {
+    string ipport = node.first;
+    ulong succeed = 0;
+    for (auto &result : node.second)
+    {
+      tc_exec_info &exec_info = result.second;
+      if (exec_info.err_code > 0)
+      {// some reason
+        // 1. don't exist, 1397
+        // 2. connection also hold the xid, 1397
+        // 3.failed, must be warning
+        if (exec_info.err_code != 1397)
+        {// ignore 1397 // ERROR 1397 (XAE04): XAER_NOTA: Unknown XID
+          sql_print_warning("TDBCTL: ipport is %s, xid is %s, "
+            " failed to repair unexpected prepared transaction: %d %s",
+            ipport.c_str(), result.first.c_str(), exec_info.err_code,
+            exec_info.err_msg.c_str());
         }
+      }
+      else
+        succeed++;
+    }
+    if (succeed)
+    {// succeed to repair unexpected prepared transaction
+      sql_print_warning("TDBCTL: ipport is %s, "
+        " succeed to repair %lu unexpected prepared transaction",
+        ipport.c_str(), succeed);
     }
   }
 }
@@ -8,6 +8,7 @@
 /* Check unexpected prepared transaction and repair them */
 
 #include "my_global.h"                  /* uint */
+#include "my_time.h"                    /* my_time_t */
 #include "sql_cmd.h"
 #include "sql_string.h"
 #include "sql_alloc.h"
@@ -16,32 +17,55 @@
 #include<string>
 #include<map>
 #include<set>
+#include<vector>
 using namespace std;
 
+/* max number of xids resolved in one query on mysql.xa_commit_log */
+#define TC_XA_REPAIR_BATCH_SIZE 1000
+
+/* seconds of clock skew allowed between tdbctl and remotes */
+#define TC_XA_COMMIT_TIME_SLACK 60
+/* max number of records deleted from mysql.xa_commit_log in one purge */
+#define TC_XA_PURGE_BATCH_SIZE 10000
+/* min seconds between purges of mysql.xa_commit_log */
+#define TC_XA_PURGE_INTERVAL 600
+
 void create_tc_xa_repair_thread();
 void tc_xa_repair_thread();
+void tc_xa_repair_conn_free();
+void tc_xa_repair_free();
+int tc_xa_repair_conn_init();
 void tc_check_and_repair_trans();
-void tc_get_remote_prepared_trans(
+void tc_ensure_commit_log_index(map<string, MYSQL*>& conn_map);
+bool tc_get_remote_prepared_trans(
   map<string, MYSQL*>& conn_map,
   map<string, string>& user_map,
   map<string, string>& passwd_map,
   int time,
-  set<string>& xid_set
+  bool all_prepared,
+  map<string, my_time_t>& xid_map,
+  map<string, set<string> >& node_xid_map,
+  set<string>& prepared_set
 );
 void tc_check_status_from_commit_logs(
   map<string, MYSQL*>& conn_map,
   map<string, string>& user_map,
   map<string, string>& passwd_map,
-  set<string>& xid_set,
+  map<string, my_time_t>& xid_map,
   set<string>& commit_set,
   set<string>& rollback_set
 );
-void tc_process_prepared_trans(
+void tc_purge_commit_logs(
   map<string, MYSQL*>& conn_map,
   map<string, string>& user_map,
   map<string, string>& passwd_map,
-  string pre_sql,
-  set<string>& commit_set
+  set<string>& prepared_set
+);
+void tc_process_prepared_trans(
+  map<string, MYSQL*>& conn_map,
+  map<string, set<string> >& node_xid_map,
+  set<string>& commit_set,
+  set<string>& rollback_set
 );
 
 
@@ -24,6 +24,7 @@
 #include <pfs_transaction_provider.h>
 #include <mysql/psi/mysql_transaction.h>
 #include "binlog.h"
+#include "tztime.h"             // Time_zone
 
 const char *XID_STATE::xa_state_names[]={
   "NON-EXISTING", "ACTIVE", "IDLE", "PREPARED", "ROLLBACK ONLY"
@@ -808,6 +809,7 @@ bool Sql_cmd_xa_prepare::trans_xa_prepare(THD *thd)
     else
     {
       xid_state->set_state(XID_STATE::XA_PREPARED);
+      xid_state->set_prepare_time(my_time(0));
       MYSQL_SET_TRANSACTION_XA_STATE(thd->m_transaction_psi,
                                      (int)xid_state->get_state());
       if (thd->rpl_thd_ctx.session_gtids_ctx().notify_after_xa_prepare(thd))
@@ -847,6 +849,11 @@ bool Sql_cmd_xa_prepare::execute(THD *thd)
     I didn't find in XA specs that an RM cannot return the same XID twice,
     so trans_xa_recover does not filter XID's to ensure uniqueness.
     It can be easily fixed later, if necessary.
+
+  @note
+    For XA RECOVER WITH TIME, a prepare_time column is returned, and
+    with OLDER THAN n only XID's prepared more than n seconds ago are
+    returned, so that young XID's are filtered inside the transaction cache.
 */
 
 bool Sql_cmd_xa_recover::trans_xa_recover(THD *thd)
@@ -865,11 +872,16 @@ bool Sql_cmd_xa_recover::trans_xa_recover(THD *thd)
   field_list.push_back(new Item_int(NAME_STRING("bqual_length"), 0,
                                     MY_INT32_NUM_DECIMAL_DIGITS));
   field_list.push_back(new Item_empty_string("data", XIDDATASIZE*2+2));
+  if (m_with_time)
+    field_list.push_back(new Item_empty_string("prepare_time",
+                                               MAX_DATETIME_WIDTH));
 
   if (thd->send_result_metadata(&field_list,
                                 Protocol::SEND_NUM_ROWS | Protocol::SEND_EOF))
     DBUG_RETURN(true);
 
+  time_t now= my_time(0);
+
   mysql_mutex_lock(&LOCK_transaction_cache);
 
   while ((transaction= (Transaction_ctx*) my_hash_element(&transaction_cache,
@@ -878,8 +890,21 @@ bool Sql_cmd_xa_recover::trans_xa_recover(THD *thd)
     XID_STATE *xs= transaction->xid_state();
     if (xs->has_state(XID_STATE::XA_PREPARED))
     {
+      if (m_older_than &&
+          now - xs->get_prepare_time() <= (time_t) m_older_than)
+        continue;
+
       protocol->start_row();
       xs->store_xid_info(protocol, m_print_xid_as_hex);
+      if (m_with_time)
+      {
+        MYSQL_TIME prepare_time;
+        char buf[MAX_DATE_STRING_REP_LENGTH];
+        thd->variables.time_zone->gmt_sec_to_TIME(&prepare_time,
+                                   (my_time_t) xs->get_prepare_time());
+        uint len= my_datetime_to_str(&prepare_time, buf, 0);
+        protocol->store(buf, len, &my_charset_bin);
+      }
 
       if (protocol->end_row())
       {
@@ -1169,7 +1194,8 @@ bool transaction_cache_insert(XID *xid, Transaction_ctx *transaction)
 }
 
 
-inline bool create_and_insert_new_transaction(XID *xid, bool is_binlogged_arg)
+inline bool create_and_insert_new_transaction(XID *xid, bool is_binlogged_arg,
+                                              time_t prepare_time= 0)
 {
   Transaction_ctx *transaction= new (std::nothrow) Transaction_ctx();
   XID_STATE *xs;
@@ -1180,7 +1206,7 @@ inline bool create_and_insert_new_transaction(XID *xid, bool is_binlogged_arg)
     return true;
   }
   xs= transaction->xid_state();
-  xs->start_recovery_xa(xid, is_binlogged_arg);
+  xs->start_recovery_xa(xid, is_binlogged_arg, prepare_time);
 
   return my_hash_insert(&transaction_cache, (uchar*)transaction);
 }
@@ -1192,6 +1218,7 @@ bool transaction_cache_detach(Transaction_ctx *transaction)
   XID_STATE *xs= transaction->xid_state();
   XID xid= *(xs->get_xid());
   bool was_logged= xs->is_binlogged();
+  time_t prepare_time= xs->get_prepare_time();
 
 
   DBUG_ASSERT(xs->has_state(XID_STATE::XA_PREPARED));
@@ -1202,7 +1229,7 @@ bool transaction_cache_detach(Transaction_ctx *transaction)
                              xid.key_length()));
 
   my_hash_delete(&transaction_cache, (uchar *)transaction);
-  res= create_and_insert_new_transaction(&xid, was_logged);
+  res= create_and_insert_new_transaction(&xid, was_logged, prepare_time);
 
   mysql_mutex_unlock(&LOCK_transaction_cache);
 
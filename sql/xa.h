@@ -123,8 +123,17 @@ private:
 class Sql_cmd_xa_recover : public Sql_cmd
 {
 public:
-  explicit Sql_cmd_xa_recover(bool print_xid_as_hex)
-  : m_print_xid_as_hex(print_xid_as_hex)
+  /**
+    @param print_xid_as_hex  print xid data in hex
+    @param with_time         also return the prepare time of each xid
+    @param older_than        only return xids prepared more than
+                             older_than seconds ago, 0 for all
+  */
+  explicit Sql_cmd_xa_recover(bool print_xid_as_hex, bool with_time= false,
+                              ulong older_than= 0)
+  : m_print_xid_as_hex(print_xid_as_hex),
+    m_with_time(with_time),
+    m_older_than(older_than)
   {}
 
   virtual enum_sql_command sql_command_code() const
@@ -138,6 +147,8 @@ private:
   bool trans_xa_recover(THD *thd);
 
   bool m_print_xid_as_hex;
+  bool m_with_time;
+  ulong m_older_than;
 };
 
 
@@ -432,13 +443,20 @@ private:
     Checked and reset at XA-commit/rollback.
   */
   bool m_is_binlogged;
+  /*
+    Time when the transaction entered XA_PREPARED state, used by
+    XA RECOVER WITH TIME. For a transaction recovered at server
+    startup it is the time of recovery.
+  */
+  time_t m_prepare_time;
 
 public:
   XID_STATE()
   : xa_state(XA_NOTR),
     in_recovery(false),
     rm_error(0),
-    m_is_binlogged(false)
+    m_is_binlogged(false),
+    m_prepare_time(0)
   { m_xid.null(); }
 
   void set_state(xa_states state)
@@ -491,6 +509,7 @@ public:
     m_xid.null();
     in_recovery= false;
     m_is_binlogged= false;
+    m_prepare_time= 0;
   }
 
   void start_normal_xa(const XID *xid)
@@ -502,13 +521,15 @@ public:
     rm_error= 0;
   }
 
-  void start_recovery_xa(const XID *xid, bool binlogged_arg= false)
+  void start_recovery_xa(const XID *xid, bool binlogged_arg= false,
+                         time_t prepare_time= 0)
   {
     xa_state= XA_PREPARED;
     m_xid.set(xid);
     in_recovery= true;
     rm_error= 0;
     m_is_binlogged= binlogged_arg;
+    m_prepare_time= prepare_time ? prepare_time : my_time(0);
   }
 
   bool is_in_recovery() const
@@ -523,6 +544,12 @@ public:
   void unset_binlogged()
   { m_is_binlogged= false; }
 
+  void set_prepare_time(time_t prepare_time)
+  { m_prepare_time= prepare_time; }
+
+  time_t get_prepare_time() const
+  { return m_prepare_time; }
+
   void store_xid_info(Protocol *protocol, bool print_xid_as_hex) const;
 
   /**